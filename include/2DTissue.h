@@ -1,13 +1,23 @@
 // 2DTissue.h
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <boost/filesystem.hpp>
 #include <Eigen/Dense>
 #include <map>
 
 
-#include <utilities/sim_structs.h>
+#include <io/binary_matrix.h>
+#include <particle_simulation/forces.h>
+#include <particle_simulation/motion.h>
+#include <particle_simulation/neighbor_search.h>
+#include <utilities/distance_matrix.h>
+#include <utilities/distance_provider.h>
+#include <utilities/heat_method.h>
+#include <utilities/simulation_context.h>
 #include <io/mesh_loader.h>
 
 // Individuelle Partikel Informationen
@@ -21,6 +31,9 @@ struct Particle{
     double x_3D;
     double y_3D;
     double z_3D;
+    double x_velocity_3D;                   // UV velocity lifted onto the tangent plane of the 3D face
+    double y_velocity_3D;
+    double z_velocity_3D;
     int neighbor_count;
 };
 
@@ -28,6 +41,22 @@ struct Particle{
 struct System{
     double order_parameter;
     std::vector<Particle> particles;
+    int64_t neighbor_list_rebuilds;         // steps so far, which had to search the neighbor pairs from scratch
+    double neighbor_list_rebuild_rate;      // rebuilds per step so far, to tune the skin of the Verlet list
+};
+
+
+// Default physical parameters, the only place they are set
+struct TissueDefaults{
+    static constexpr double v0 = 0.1;
+    static constexpr double k = 10;
+    static constexpr double k_next = 10;
+    static constexpr double v0_next = 0.1;
+    static constexpr double σ = 0.4166666666666667;
+    static constexpr double μ = 1;
+    static constexpr double r_adh = 1;
+    static constexpr double k_adh = 0.75;
+    static constexpr double step_size = 0.001;
 };
 
 
@@ -50,41 +79,66 @@ private:
     double step_size;
     int current_step;
     int map_cache_count;
+    MatrixDtype distance_dtype;
+    double distance_cutoff;
+    ForceReduction force_reduction;
     bool finished;
 
     Eigen::Matrix<double, Eigen::Dynamic, 2> r;
-    Eigen::VectorXd n;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n;  // unit vectors of the flight direction
     std::vector<int> vertices_3D_active;
-    Eigen::MatrixXd distance_matrix;
+    std::vector<int> particle_faces;  // UV face of each particle, tracked from step to step
+    std::shared_ptr<NeighborSearch> neighbor_search;
+    AngularNoise angular_noise;
+    std::shared_ptr<const SimulationContext> context;  // mesh, UV atlas and distances, shared read-only by every step
     Eigen::VectorXd v_order;
-    Eigen::MatrixXd halfedge_uv;
-    Eigen::MatrixXi faces_uv;
-    Eigen::MatrixXd vertices_UV;
-    Eigen::MatrixXd vertices_3D;
-    std::vector<int64_t> h_v_mapping;
-    std::string mesh_file_path;
     double dt;
     int num_part;
-    std::unordered_map<int, Mesh_UV_Struct> vertices_2DTissue_map;
+
+    void build_neighbor_search(NeighborSearchType neighbor_search_type, double interaction_range, double neighbor_skin);
 
 public:
     _2DTissue(
         std::string mesh_path,
         int particle_count,
         int step_count = 1,
-        double v0 = 0.1,
-        double k = 10,
-        double k_next = 10,
-        double v0_next = 0.1,
-        double σ = 0.4166666666666667,
-        double μ = 1,
-        double r_adh = 1,
-        double k_adh = 0.75,
-        double step_size = 0.001,
-        int map_cache_count = 30
+        double v0 = TissueDefaults::v0,
+        double k = TissueDefaults::k,
+        double k_next = TissueDefaults::k_next,
+        double v0_next = TissueDefaults::v0_next,
+        double σ = TissueDefaults::σ,
+        double μ = TissueDefaults::μ,
+        double r_adh = TissueDefaults::r_adh,
+        double k_adh = TissueDefaults::k_adh,
+        double step_size = TissueDefaults::step_size,
+        int map_cache_count = 30,
+        MatrixDtype distance_dtype = MatrixDtype::Float64,
+        double distance_cutoff = std::numeric_limits<double>::infinity(),
+        size_t distance_cache_bytes = 0,
+        std::string distance_spill_path = "",
+        HeatMethodVariant distance_heat_method = HeatMethodVariant::IntrinsicDelaunay,
+        int distance_block_size = 32,
+        std::string cache_root = "",
+        NeighborSearchType neighbor_search_type = NeighborSearchType::UVCells,
+        double neighbor_skin = 0,
+        uint64_t seed = 0,
+        double noise = 0,
+        ForceReduction force_reduction = ForceReduction::ThreadLocalBuffers
+    );
+
+    // Simulation on an already built context, with the default physical parameters
+    _2DTissue(
+        std::shared_ptr<const SimulationContext> context,
+        int particle_count,
+        int step_count = 1,
+        NeighborSearchType neighbor_search_type = NeighborSearchType::UVCells,
+        double neighbor_skin = 0,
+        uint64_t seed = 0,
+        ForceReduction force_reduction = ForceReduction::ThreadLocalBuffers
     );
     void start();
     System update();
     bool is_finished();
     Eigen::VectorXd get_order_parameter();
+    Eigen::VectorXd get_orientation_degrees();
 };
@@ -0,0 +1,154 @@
+// binary_matrix.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+using RowMajorMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Increase the version whenever the header or the payload layout changes, so that outdated cache files get recomputed
+constexpr uint32_t BINARY_MATRIX_VERSION = 4;
+constexpr char BINARY_MATRIX_MAGIC[8] = {'2', 'D', 'T', 'I', 'S', 'S', 'U', 'E'};
+
+// Storage precision of the payload. UInt16 stores round(value / scale) with one scale for the whole matrix.
+enum class MatrixDtype : uint32_t {
+    Float64 = 0,
+    Float32 = 1,
+    UInt16 = 2
+};
+
+// Arrangement of the payload. PackedUpper stores the upper triangle (incl. diagonal) of a symmetric matrix row by row.
+// SparseCSR stores only the entries below the cutoff as compressed sparse rows: int64 row offsets, int32 column indices, values.
+enum class MatrixLayout : uint32_t {
+    PackedUpper = 0,
+    SparseCSR = 1
+};
+
+// Fixed size header in front of the payload. 80 bytes keep the payload aligned for every dtype.
+// The cutoff is infinite for the dense layout, the sparse layout treats every missing entry as beyond the cutoff.
+struct BinaryMatrixHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t layout;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t nonzeros;
+    uint64_t mesh_checksum;
+    uint64_t payload_bytes;
+    double scale;
+    double cutoff;
+};
+static_assert(sizeof(BinaryMatrixHeader) == 80, "The binary matrix header has to stay 80 bytes large");
+
+// Symmetric sparse matrix in compressed sparse row format, the column indices of each row are sorted ascending
+struct SparseMatrixCSR {
+    int64_t rows = 0;
+    std::vector<int64_t> row_offsets;
+    std::vector<int32_t> col_indices;
+    std::vector<double> values;
+};
+
+// Entries of a single matrix row as (column, value) pairs
+using SparseRow = std::vector<std::pair<int32_t, double>>;
+
+
+// Read-only memory mapping of a whole file, which gets unmapped again on destruction
+class MemoryMappedFile {
+public:
+    explicit MemoryMappedFile(const std::string& path);
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    const char* data() const { return mapped_data; }
+    size_t size() const { return mapped_size; }
+
+private:
+    const char* mapped_data = nullptr;
+    size_t mapped_size = 0;
+};
+
+// Number of stored values of a packed upper triangle of a n×n matrix
+inline int64_t packed_upper_size(int64_t n) {
+    return n * (n + 1) / 2;
+}
+
+// Position of the entry (row, col) of a symmetric n×n matrix inside its packed upper triangle
+inline int64_t packed_upper_index(int64_t row, int64_t col, int64_t n) {
+    if (row > col) {
+        std::swap(row, col);
+    }
+    return row * (2 * n - row + 1) / 2 + (col - row);
+}
+
+// Byte offset of the values inside a sparse payload. The column indices get padded, so that the values stay 8 byte aligned.
+inline size_t sparse_values_offset(int64_t rows, int64_t nonzeros) {
+    size_t offset = (rows + 1) * sizeof(int64_t) + nonzeros * sizeof(int32_t);
+    return (offset + 7) & ~size_t(7);
+}
+
+size_t dtype_size(MatrixDtype dtype);
+
+std::string dtype_name(MatrixDtype dtype);
+MatrixDtype parse_dtype(const std::string& name);
+
+std::vector<double> pack_symmetric_upper(const RowMajorMatrixXd& matrix);
+
+SparseMatrixCSR symmetric_csr_from_rows(const std::vector<SparseRow>& rows);
+
+SparseMatrixCSR truncate_symmetric(const RowMajorMatrixXd& matrix, double cutoff);
+
+size_t sparse_payload_bytes(const SparseMatrixCSR& matrix, MatrixDtype dtype);
+
+void encode_sparse_matrix(
+    const SparseMatrixCSR& matrix,
+    MatrixDtype dtype,
+    double scale,
+    char* output
+);
+
+double quantization_scale(const std::vector<double>& values, MatrixDtype dtype);
+
+void encode_values(
+    const std::vector<double>& values,
+    MatrixDtype dtype,
+    double scale,
+    char* output
+);
+
+uint64_t file_checksum(const std::string& path);
+
+void save_binary_matrix(
+    const std::string& path,
+    const RowMajorMatrixXd& matrix,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype = MatrixDtype::Float64
+);
+
+void save_sparse_binary_matrix(
+    const std::string& path,
+    const SparseMatrixCSR& matrix,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype,
+    double cutoff
+);
+
+bool read_binary_matrix_header(
+    const std::string& path,
+    BinaryMatrixHeader& header
+);
+
+bool is_valid_binary_matrix(
+    const std::string& path,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype = MatrixDtype::Float64,
+    double cutoff = std::numeric_limits<double>::infinity()
+);
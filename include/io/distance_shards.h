@@ -0,0 +1,106 @@
+// distance_shards.h
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <io/binary_matrix.h>
+#include <io/row_checkpoint.h>
+
+
+// Keeps every distance row in a dense matrix
+struct DenseRowStore {
+    RowMajorMatrixXd matrix;
+
+    explicit DenseRowStore(int num_vertices) : matrix(num_vertices, num_vertices) {}
+
+    void set(int row, const std::vector<double>& distances) {
+        std::copy(distances.begin(), distances.end(), matrix.row(row).data());
+    }
+
+    void save_block(RowCheckpoint& checkpoint, int block_id) const {
+        checkpoint.save_block(block_id, matrix.middleRows(checkpoint.block_start(block_id), checkpoint.block_size(block_id)));
+    }
+
+    void load(int row, const SparseRow& entries) {
+        for (const auto& [col, value] : entries) {
+            matrix(row, col) = value;
+        }
+    }
+
+    void release(int, int) {}
+};
+
+
+// Keeps only the distances within the cutoff, so the dense V×V matrix never exists in memory
+struct SparseRowStore {
+    std::vector<SparseRow> rows;
+    double cutoff;
+
+    SparseRowStore(int num_vertices, double cutoff) : rows(num_vertices), cutoff(cutoff) {}
+
+    void set(int row, const std::vector<double>& distances) {
+        SparseRow& entries = rows[row];
+        for (size_t vertex_id = 0; vertex_id < distances.size(); ++vertex_id) {
+            if (distances[vertex_id] <= cutoff) {
+                entries.emplace_back(static_cast<int32_t>(vertex_id), distances[vertex_id]);
+            }
+        }
+        entries.shrink_to_fit();
+    }
+
+    void save_block(RowCheckpoint& checkpoint, int block_id) const {
+        auto first_row = rows.begin() + checkpoint.block_start(block_id);
+        checkpoint.save_block(block_id, std::vector<SparseRow>(first_row, first_row + checkpoint.block_size(block_id)));
+    }
+
+    void load(int row, const SparseRow& entries) {
+        rows[row] = entries;
+    }
+
+    void release(int, int) {}
+};
+
+
+// A shard only writes its blocks, so their rows are freed as soon as they are in the checkpoint
+struct ShardRowStore : SparseRowStore {
+    using SparseRowStore::SparseRowStore;
+
+    void release(int first_row, int num_rows) {
+        for (int row = first_row; row < first_row + num_rows; ++row) {
+            SparseRow().swap(rows[row]);
+        }
+    }
+};
+
+
+template <typename RowStore>
+void load_checkpointed_rows(const RowCheckpoint& checkpoint, const std::vector<int>& block_ids, RowStore& store){
+    for (int block_id : block_ids) {
+        std::vector<SparseRow> rows = checkpoint.load_block(block_id);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            store.load(checkpoint.block_start(block_id) + i, rows[i]);
+        }
+    }
+}
+
+void save_distance_rows(const std::string& distance_matrix_path, DenseRowStore& store, uint64_t mesh_checksum, MatrixDtype dtype, double cutoff);
+void save_distance_rows(const std::string& distance_matrix_path, SparseRowStore& store, uint64_t mesh_checksum, MatrixDtype dtype, double cutoff);
+
+std::string get_distance_shard_path(
+    const std::string distance_matrix_path,
+    int shard,
+    int num_shards
+);
+
+void merge_distance_shard_files(
+    const std::string& distance_matrix_path,
+    uint64_t mesh_checksum,
+    int num_vertices,
+    int num_shards,
+    MatrixDtype dtype,
+    double cutoff,
+    int checkpoint_rows
+);
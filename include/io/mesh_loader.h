@@ -11,13 +11,18 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <io/mesh_registry.h>
 #include <utilities/sim_structs.h>
 
 void loadMeshVertices(std::string filepath, Eigen::MatrixXd& vertices);
 
 void loadMeshFaces(std::string filepath, Eigen::MatrixXi& faces);
 
+void import_mesh(const std::string& filepath, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces);
+
+std::shared_ptr<const MeshAsset> load_mesh(const std::string& filepath);
+
 std::pair<Eigen::MatrixXd, std::vector<int64_t>> get_mesh_data(
-    std::unordered_map<int, Mesh_UV_Struct> mesh_dict,
+    const std::unordered_map<int, Mesh_UV_Struct>& mesh_dict,
     int mesh_id
 );
\ No newline at end of file
@@ -0,0 +1,58 @@
+// mesh_registry.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <Eigen/Dense>
+
+
+/**
+ * @brief Parsed triangle mesh, shared read-only by everyone who loaded the same file
+*/
+struct MeshAsset {
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi faces;
+};
+
+// Parses the mesh file into its vertices and faces
+using MeshFileLoader = std::function<void(const std::string&, Eigen::MatrixXd&, Eigen::MatrixXi&)>;
+
+
+/**
+ * @brief Loads each mesh file once and hands out shared immutable views of it
+ *
+ * The meshes are keyed by their canonical path. A file gets parsed again only if its size or
+ * its nanosecond modification time changed since it was loaded, e.g. because the UV mesh got
+ * recreated. The registry is thread-safe: concurrent requests for the same file wait for one
+ * parse, while different files get parsed in parallel.
+*/
+class MeshRegistry {
+public:
+    explicit MeshRegistry(MeshFileLoader loader);
+
+    std::shared_ptr<const MeshAsset> get(const std::string& path);
+
+    size_t size() const;
+    int64_t parsed_files() const;
+    void clear();
+
+private:
+    struct Entry {
+        uintmax_t file_size;
+        std::filesystem::file_time_type write_time;
+        std::shared_future<std::shared_ptr<const MeshAsset>> mesh;
+    };
+
+    MeshFileLoader loader;
+    std::unordered_map<std::string, Entry> meshes;
+    std::atomic<int64_t> num_parsed{0};
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,24 @@
+// precompute_cache.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Environment variable, which overrides the default cache root, e.g. to share one warm cache directory between nodes
+constexpr char CACHE_ROOT_ENV[] = "TISSUE_CACHE_DIR";
+
+std::string get_cache_root(const std::string& cache_root = "");
+
+uint64_t cache_key(uint64_t mesh_checksum, const std::string& kind, const std::string& parameters);
+
+std::string get_cache_path(
+    const std::string& mesh_path,
+    const std::string& kind,
+    const std::string& parameters,
+    const std::string& extension,
+    const std::string& cache_root = ""
+);
+
+std::string temporary_cache_path(const std::string& path);
+
+void commit_cache_file(const std::string& temporary_path, const std::string& path);
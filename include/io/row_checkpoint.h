@@ -0,0 +1,90 @@
+// row_checkpoint.h
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <io/binary_matrix.h>
+
+
+/**
+ * @brief Checkpoint of a long running row by row precomputation, e.g. of the distance matrix
+ *
+ * Completed blocks of rows get written as separate files into the checkpoint directory and recorded in a manifest.
+ * A restarted precomputation only computes the blocks, which are not in the manifest yet.
+ * The manifest is bound to a key (e.g. the mesh checksum) and to the shape, a mismatch discards the old checkpoint.
+ * Only a checkpoint opened with open_existing is read-only, it refuses a mismatch instead of discarding the blocks.
+ * A checkpoint holds an exclusive lock for its whole lifetime, so a second job on the same checkpoint waits for the first.
+*/
+class RowCheckpoint {
+public:
+    RowCheckpoint(
+        const std::string& directory,
+        uint64_t key,
+        int num_rows,
+        int num_cols,
+        int block_rows
+    );
+
+    // Read the blocks of a finished precomputation, e.g. for the merge of the shards
+    ~RowCheckpoint();
+
+    static std::unique_ptr<RowCheckpoint> open_existing(
+        const std::string& directory,
+        uint64_t key,
+        int num_rows,
+        int num_cols,
+        int block_rows
+    );
+
+    int num_blocks() const { return (num_rows + block_rows - 1) / block_rows; }
+    int block_start(int block_id) const { return block_id * block_rows; }
+    int block_size(int block_id) const;
+
+    bool is_complete(int block_id) const;
+    std::vector<int> pending_blocks() const;
+    std::vector<int> completed_blocks() const;
+
+    // Contiguous range of blocks, which shard k of n computes
+    std::vector<int> shard_blocks(int shard, int num_shards) const;
+
+    void save_block(int block_id, const std::vector<SparseRow>& rows);
+    // Complete rows straight out of a dense matrix, e.g. matrix.middleRows(block_start, block_size)
+    void save_block(int block_id, const Eigen::Ref<const RowMajorMatrixXd>& rows);
+    std::vector<SparseRow> load_block(int block_id) const;
+
+    void remove();
+
+private:
+    RowCheckpoint(
+        const std::string& directory,
+        uint64_t key,
+        int num_rows,
+        int num_cols,
+        int block_rows,
+        bool read_only
+    );
+
+    void load_manifest();
+    void write_block(int block_id, const std::function<void(std::ofstream&)>& write_rows);
+    std::string block_path(int block_id) const;
+    std::string manifest_path() const;
+    std::string manifest_header() const;
+
+    std::string directory;
+    uint64_t key;
+    int num_rows;
+    int num_cols;
+    int block_rows;
+    bool read_only;
+    int lock_file = -1;
+
+    mutable std::mutex manifest_mutex;
+    std::set<int> completed_block_ids;
+};
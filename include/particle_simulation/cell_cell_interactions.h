@@ -1,6 +1,8 @@
 // cell_cell_interactions.h
 #pragma once
 
+#include <cstddef>
+#include <vector>
 #include <Eigen/Dense>
 
 Eigen::Vector2d repulsive_adhesion_motion(
@@ -10,4 +12,62 @@ Eigen::Vector2d repulsive_adhesion_motion(
     double r_adh,
     double k_adh,
     const Eigen::Vector2d& dist_v
-);
\ No newline at end of file
+);
+
+
+// Instruction sets of the batch force kernel, the best one supported by the CPU gets picked at runtime
+enum class SimdLevel {
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+SimdLevel detect_simd_level();
+
+
+// Interacting pairs as structure of arrays: distance, displacement and the resulting force of each pair
+struct InteractionBatch {
+    std::vector<double> dist;
+    std::vector<double> dx;
+    std::vector<double> dy;
+    std::vector<double> fx;
+    std::vector<double> fy;
+
+    size_t size() const { return dist.size(); }
+
+    void clear() {
+        dist.clear();
+        dx.clear();
+        dy.clear();
+        fx.clear();
+        fy.clear();
+    }
+
+    void add(double distance, const Eigen::Vector2d& dist_v) {
+        dist.push_back(distance);
+        dx.push_back(dist_v(0));
+        dy.push_back(dist_v(1));
+    }
+};
+
+void repulsive_adhesion_motion_batch(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    const double* dist,
+    const double* dx,
+    const double* dy,
+    double* fx,
+    double* fy,
+    size_t count,
+    SimdLevel level
+);
+
+void repulsive_adhesion_motion_batch(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    InteractionBatch& batch
+);
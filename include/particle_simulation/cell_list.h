@@ -0,0 +1,83 @@
+// cell_list.h
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/neighbor_search.h>
+#include <utilities/2D_mapping_fixed_border.h>
+#include <utilities/distance_provider.h>
+#include <utilities/uv_affine_maps.h>
+
+
+/**
+ * @brief Uniform grid of cells over the UV square, which finds the candidate pairs of interacting particles
+ *
+ * The cells are at least as large as the search radius, so every particle only has to be compared with the particles
+ * of its own and its 8 surrounding cells. The cells outside of the square (halo cells) get mapped across the seam
+ * onto the cells, which are glued to that border. Therefore particles close to each other across the seam are found as well.
+ * At a fixed particle density the number of candidate pairs grows linearly with the number of particles.
+ *
+ * On a UV map the search radius depends on the stretch of the faces. Instead of sizing all cells for the worst face,
+ * the cells can be sized for the typical stretch and each cell reaches as many cells around it as its local stretch needs.
+*/
+class UVCellList : public NeighborSearch {
+public:
+    UVCellList(double search_radius, SeamType seam_type);
+
+    // Cells for the interaction range on the UV map, the snap margin gets added to the UV search radius of every cell
+    UVCellList(
+        double search_range,
+        double snap_margin,
+        const Eigen::MatrixXd& vertices_uv,
+        const Eigen::MatrixXi& faces_uv,
+        const UVAffineMaps& affine_maps,
+        SeamType seam_type
+    );
+
+    int cells_per_side() const { return num_cells_per_side; }
+    const std::vector<int>& neighbor_cells(int cell_id) const { return neighbors[cell_id]; }
+    int cell_of(double u, double v) const;
+
+    // Number of cells in each direction, which the stencil of the cell covers
+    int reach_of(int cell_id) const { return cell_reach[cell_id]; }
+
+    // Sort the particles into their cells
+    void build(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV);
+
+    // Each pair of particles in neighboring cells exactly once, with the smaller particle index first
+    std::vector<ParticlePair> candidate_pairs() const;
+    void candidate_pairs(std::vector<ParticlePair>& pairs) const;
+
+    const std::vector<ParticlePair>& find_pairs(
+        const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+        const std::vector<int>& vertices_3D_active
+    ) override;
+
+private:
+    void build_neighbors();
+    void add_neighbor(std::vector<int>& cells, int x, int y) const;
+    int fold_cell(int x, int y) const;
+
+    // Limits the memory of the grid for tiny search radii, larger cells only add candidates
+    static constexpr int max_cells_per_side = 512;
+
+    int num_cells_per_side;
+    SeamType seam_type;
+    std::vector<int> cell_reach;
+    std::vector<std::vector<int>> neighbors;
+    std::vector<ParticlePair> found_pairs;
+
+    // Particles sorted by their cell, the particles of cell c are cell_particles[cell_start[c], cell_start[c + 1])
+    std::vector<int> cell_start;
+    std::vector<int> cell_particles;
+};
+
+
+std::vector<ParticlePair> all_particle_pairs(int num_part);
+
+double max_uv_stretch(const UVAffineMaps& affine_maps);
+double max_uv_edge_length(
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv
+);
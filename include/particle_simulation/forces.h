@@ -4,11 +4,43 @@
 #include <vector>
 #include <Eigen/Dense>
 
-Eigen::Matrix<double, Eigen::Dynamic, 2> calculate_forces_between_particles(
-    const std::vector<Eigen::MatrixXd>& dist_vect,
-    const Eigen::MatrixXd& dist_length,
+#include <particle_simulation/cell_cell_interactions.h>
+#include <utilities/distance_provider.h>
+
+
+// How the parallel force accumulation avoids that two threads add to the same particle
+enum class ForceReduction {
+    Serial,
+    ThreadLocalBuffers,
+    PairColoring
+};
+
+
+/**
+ * @brief Pairs grouped by the colors of a greedy coloring, no two pairs of one color share a particle
+ *
+ * The coloring only depends on the pairs, so it stays valid for every subset of them, like the interacting pairs of a step.
+*/
+struct PairColors {
+    std::vector<long> color_start;  // the pairs of color c are pair_ids[color_start[c], color_start[c + 1])
+    std::vector<long> pair_ids;
+
+    int num_colors() const { return color_start.empty() ? 0 : color_start.size() - 1; }
+};
+
+PairColors color_pairs(const std::vector<ParticlePair>& pairs, int num_part);
+
+void accumulate_pair_forces(
+    const std::vector<ParticlePair>& interacting,
+    InteractionBatch& batch,
+    int num_part,
     double k,
     double σ,
     double r_adh,
-    double k_adh
+    double k_adh,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& F,
+    std::vector<Eigen::Matrix<double, Eigen::Dynamic, 2>>& thread_forces,
+    ForceReduction reduction = ForceReduction::ThreadLocalBuffers,
+    const PairColors* colors = nullptr,
+    const std::vector<long>* batch_of_pair = nullptr
 );
@@ -5,29 +5,42 @@
 #include <vector>
 #include <Eigen/Dense>
 
-void transform_into_symmetric_matrix(Eigen::MatrixXd &A);
+#include <particle_simulation/forces.h>
+#include <particle_simulation/pair_interactions.h>
+#include <utilities/counter_rng.h>
+#include <utilities/distance_provider.h>
 
-std::vector<Eigen::MatrixXd> get_dist_vect(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r);
+void transform_into_symmetric_matrix(Eigen::MatrixXd &A);
 
 double mean_unit_circle_vector_angle_degrees(std::vector<double> angles);
 
-void calculate_average_n_within_distance(
-    const std::vector<Eigen::MatrixXd> dist_vect,
-    const Eigen::MatrixXd dist_length,
-    Eigen::VectorXd& n,
-    double σ
+// Uniform noise of the flight direction, which is reproducible by its seed
+struct AngularNoise {
+    CounterRNG rng;
+    double amplitude = 0;  // width of the noise in degrees, the direction turns by at most half of it to either side
+};
+
+void add_angular_noise(
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
+    const AngularNoise& noise,
+    int step
 );
 
-std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::MatrixXd> simulate_flight(
+std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::VectorXd> simulate_flight(
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
-    Eigen::VectorXd& n,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
     std::vector<int>& vertices_3D_active,
-    Eigen::MatrixXd distance_matrix_v,
+    const std::vector<ParticlePair>& pairs,
+    const DistanceProvider& distance_matrix_v,
     double v0,
     double k,
     double σ,
     double μ,
     double r_adh,
     double k_adh,
-    double dt
+    double dt,
+    const AngularNoise& noise = AngularNoise(),
+    int step = 0,
+    ForceReduction reduction = ForceReduction::ThreadLocalBuffers,
+    PairWorkspace* workspace = nullptr
 );
\ No newline at end of file
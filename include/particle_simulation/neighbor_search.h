@@ -0,0 +1,55 @@
+// neighbor_search.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/pair_interactions.h>
+#include <utilities/distance_provider.h>
+
+
+enum class NeighborSearchType {
+    UVCells,       // uniform grid over the UV square
+    MeshVertices   // geodesic neighborhoods of the active 3D vertices
+};
+
+
+struct NeighborSearchStats {
+    int64_t steps = 0;
+    int64_t rebuilds = 0;  // steps, which had to search the pairs from scratch
+
+    double rebuild_rate() const { return steps > 0 ? static_cast<double>(rebuilds) / steps : 0.0; }
+};
+
+
+/**
+ * @brief Finds the candidate pairs of particles, which can interact within the current step
+ *
+ * The candidates are a superset of the interacting pairs, the kernels still check the geodesic distance of each pair.
+ * Each pair is returned exactly once, with the smaller particle index first.
+ * The returned pairs belong to the search and stay valid until its next find_pairs, their memory gets reused.
+*/
+class NeighborSearch {
+public:
+    virtual ~NeighborSearch() = default;
+
+    virtual const std::vector<ParticlePair>& find_pairs(
+        const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+        const std::vector<int>& vertices_3D_active
+    ) = 0;
+
+    const NeighborSearchStats& stats() const { return statistics; }
+
+    // Buffers of the pair kernel, which belong to the pairs of the last find_pairs, every rebuild starts a new generation
+    PairWorkspace& workspace() {
+        pair_workspace.pairs_generation = statistics.rebuilds;
+        return pair_workspace;
+    }
+
+protected:
+    NeighborSearchStats statistics;
+
+private:
+    PairWorkspace pair_workspace;
+};
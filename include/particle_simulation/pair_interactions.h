@@ -0,0 +1,81 @@
+// pair_interactions.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/forces.h>
+#include <utilities/distance_provider.h>
+
+
+// Everything a step needs from the particle pairs
+struct PairInteractions {
+    Eigen::Matrix<double, Eigen::Dynamic, 2> force;     // force felt by each particle
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_sum;     // sum of the unit orientation vectors within 2σ, including the own one
+    Eigen::VectorXd neighbor_count;                     // neighbors within 2.4σ
+};
+
+/**
+ * @brief Buffers of the pair kernel, which stay allocated from step to step
+ *
+ * The neighbor rows and the coloring only depend on the pair list, they get rebuilt when the pairs change.
+ * The owner of the pairs increases pairs_generation, whenever it hands out a new pair list.
+ * The other buffers and the results get refilled every step, but keep their capacity.
+*/
+struct PairWorkspace {
+    struct Neighbor {
+        int particle;
+        long pair;
+    };
+
+    int64_t pairs_generation = 0;
+
+    // Neighbors of each particle over all pairs, the ones of particle i are neighbors[neighbor_start[i], neighbor_start[i + 1])
+    std::vector<int> neighbor_start;
+    std::vector<Neighbor> neighbors;
+    int64_t neighbors_generation = -1;
+
+    // Coloring of the pairs for ForceReduction::PairColoring
+    PairColors colors;
+    int64_t colors_generation = -1;
+
+    // Interacting pairs of the current step
+    InteractionBatch batch;
+    std::vector<ParticlePair> interacting;
+    std::vector<long> chunk_offset;
+    std::vector<long> batch_of_pair;  // position of every pair in the batch, -1 if it does not interact
+
+    // Force buffer of every thread for ForceReduction::ThreadLocalBuffers
+    std::vector<Eigen::Matrix<double, Eigen::Dynamic, 2>> thread_forces;
+
+    // Results of the current step, valid until the next call with this workspace
+    PairInteractions interactions;
+};
+
+const PairInteractions& calculate_pair_interactions(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    ForceReduction reduction,
+    PairWorkspace& workspace
+);
+
+PairInteractions calculate_pair_interactions(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    ForceReduction reduction = ForceReduction::ThreadLocalBuffers
+);
+
+void normalize_unit_vector_sums(const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_sum, Eigen::Matrix<double, Eigen::Dynamic, 2>& n);
@@ -4,15 +4,17 @@
 #include <vector>
 #include <Eigen/Dense>
 #include <tuple>
-#include <unordered_map>
-#include <utilities/sim_structs.h>
+#include <particle_simulation/motion.h>
+#include <particle_simulation/neighbor_search.h>
+#include <utilities/simulation_context.h>
 
 
-std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::MatrixXd, Eigen::VectorXd, Eigen::VectorXd> perform_particle_simulation(
+std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::VectorXd> perform_particle_simulation(
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
-    Eigen::VectorXd& n,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
     std::vector<int>& vertices_3D_active,
-    Eigen::MatrixXd distance_matrix_v,
+    const SimulationContext& context,
+    NeighborSearch& neighbor_search,
     Eigen::VectorXd& v_order,
     double v0,
     double k,
@@ -25,6 +27,7 @@ std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::Mat
     double dt,
     int tt,
     int num_part,
-    std::unordered_map<int, Mesh_UV_Struct>& vertices_2DTissue_map,
+    const AngularNoise& noise,
+    ForceReduction force_reduction = ForceReduction::ThreadLocalBuffers,
     double plotstep = 0.1
 );
\ No newline at end of file
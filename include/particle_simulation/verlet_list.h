@@ -0,0 +1,56 @@
+// verlet_list.h
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/neighbor_search.h>
+#include <utilities/distance_provider.h>
+
+
+/**
+ * @brief Persistent list of the pairs within the cutoff plus a skin, which gets reused over several steps
+ *
+ * The candidates of the underlying search get filtered to the pairs within cutoff + skin.
+ * The particles move on the vertices of the 3D mesh, so the displacement of a particle is the geodesic distance
+ * between its vertex at the last build and its current vertex. As long as no particle moved more than skin / 2,
+ * every pair within the cutoff is still in the list (triangle inequality) and the list gets reused.
+ * The heat method distances only fulfill the triangle inequality up to their error, so each of the two detours
+ * via the old vertices may fall short by up to distance_error. The list therefore gets rebuilt once a particle moved
+ * more than skin / 2 - distance_error, i.e. on every step, if the skin is not larger than twice the error.
+ * The underlying search has to find all pairs within cutoff + skin.
+*/
+class VerletList : public NeighborSearch {
+public:
+    VerletList(
+        std::shared_ptr<NeighborSearch> candidate_search,
+        std::shared_ptr<const DistanceProvider> distance_matrix,
+        double cutoff,
+        double skin,
+        double distance_error = 0
+    );
+
+    double cutoff() const { return cutoff_distance; }
+    double skin() const { return skin_distance; }
+    double distance_error() const { return triangle_slack; }
+    const std::vector<ParticlePair>& pairs() const { return neighbor_pairs; }
+
+    const std::vector<ParticlePair>& find_pairs(
+        const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+        const std::vector<int>& vertices_3D_active
+    ) override;
+
+private:
+    bool needs_rebuild(const std::vector<int>& vertices_3D_active) const;
+    void rebuild(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV, const std::vector<int>& vertices_3D_active);
+
+    std::shared_ptr<NeighborSearch> candidate_search;
+    std::shared_ptr<const DistanceProvider> distance_matrix;
+    double cutoff_distance;
+    double skin_distance;
+    double triangle_slack;
+
+    std::vector<ParticlePair> neighbor_pairs;
+    std::vector<int> vertices_at_build;
+};
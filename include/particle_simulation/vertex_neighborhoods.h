@@ -0,0 +1,50 @@
+// vertex_neighborhoods.h
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/neighbor_search.h>
+#include <utilities/distance_provider.h>
+
+
+/**
+ * @brief Candidate pairs out of the precomputed geodesic neighborhoods of the 3D vertices
+ *
+ * Every particle sits on its nearest 3D vertex. Once per mesh, the vertices within the cutoff of each vertex get
+ * collected from the distance matrix. Each step the particles get bucketed by their vertex and a particle is only
+ * compared with the particles on the vertices of its neighborhood.
+ * The neighborhoods come from the geodesic distances of the 3D mesh, so they neither depend on the seam
+ * nor on the distortion of the UV map.
+*/
+class VertexNeighborhoods : public NeighborSearch {
+public:
+    VertexNeighborhoods(const DistanceProvider& distance_matrix, double cutoff);
+
+    int num_vertices() const { return offsets.size() - 1; }
+    double cutoff() const { return cutoff_distance; }
+
+    // Vertices within the cutoff of the vertex, sorted and including the vertex itself
+    std::pair<const int*, const int*> neighborhood(int vertex_id) const {
+        return {vertex_ids.data() + offsets[vertex_id], vertex_ids.data() + offsets[vertex_id + 1]};
+    }
+
+    std::vector<ParticlePair> candidate_pairs(const std::vector<int>& vertices_3D_active) const;
+    void candidate_pairs(const std::vector<int>& vertices_3D_active, std::vector<ParticlePair>& pairs) const;
+
+    const std::vector<ParticlePair>& find_pairs(
+        const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+        const std::vector<int>& vertices_3D_active
+    ) override;
+
+private:
+    double cutoff_distance;
+
+    // Neighborhood of vertex v: vertex_ids[offsets[v], offsets[v + 1])
+    std::vector<int64_t> offsets;
+    std::vector<int> vertex_ids;
+
+    std::vector<ParticlePair> found_pairs;
+};
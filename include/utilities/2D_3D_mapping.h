@@ -7,29 +7,34 @@
 
 #include <io/mesh_loader.h>
 #include <io/csv.h>
+#include <utilities/simulation_context.h>
 
 std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
-    const Eigen::Matrix<double, Eigen::Dynamic, 2> r,
-    const Eigen::MatrixXd halfedges_uv,
-    const Eigen::MatrixXi faces_uv,
-    const Eigen::MatrixXd vertices_uv,
-    const Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXd& vertices_3D,
+    const std::vector<int64_t>& h_v_mapping
 );
 
-Eigen::Matrix<double, Eigen::Dynamic, 2> get_r2d(
-    const Eigen::MatrixXd r,
-    const Eigen::MatrixXd vertices_uv,
-    const Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping
+std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const SimulationContext& context
+);
+
+std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const SimulationContext& context,
+    std::vector<int>& particle_faces
 );
 
 std::vector<int> find_vertice_rows_index(
-    std::vector<int64_t> h_v_mapping_vector,
-    std::vector<int> r3d_vertices
+    const std::vector<int64_t>& h_v_mapping_vector,
+    const std::vector<int>& r3d_vertices
 );
 
 Eigen::MatrixXd get_coordinates(
-    std::vector<int> indices,
-    Eigen::MatrixXd coord
+    const std::vector<int>& indices,
+    const Eigen::MatrixXd& coord
 );
\ No newline at end of file
@@ -2,11 +2,19 @@
 
 #pragma once
 
+#include <string>
 #include <Eigen/Dense>
 
+// How the borders of the UV square are glued together by the seam of the parametrization
+enum class SeamType {
+    Diagonal,  // (1, y) is glued to (y, 1) and (0, y) to (y, 0)
+    Opposite   // (1, y) is glued to (0, y) and (x, 1) to (x, 0)
+};
+
+SeamType get_seam_type(const std::string& uv_mesh_path);
 void opposite_seam_edges_square_border(Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV_new);
 void diagonal_seam_edges_square_border(
     Eigen::Matrix<double, Eigen::Dynamic, 2> r_UV,
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV_new,
-    Eigen::VectorXd& n_UV_new
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n_UV_new
 );
\ No newline at end of file
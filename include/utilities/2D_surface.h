@@ -6,6 +6,7 @@
 #include <Eigen/Dense>
 
 #include <utilities/mesh_descriptor.h>
+#include <utilities/sim_structs.h>
 
 
 void calculate_distances(
@@ -28,9 +29,11 @@ std::vector<_3D::edge_descriptor> get_cut_line(
     const std::vector<_3D::vertex_descriptor> predecessor_pmap
 );
 
-std::tuple<std::vector<int64_t>, Eigen::MatrixXd, Eigen::MatrixXd, std::string> create_uv_surface(
+// Also returns the table of the UV face corners, i.e. their rows in vertices_UV and vertices_3D and their 3D vertex ids
+std::tuple<std::vector<int64_t>, Eigen::MatrixXd, Eigen::MatrixXd, std::string, UVFaceTable> create_uv_surface(
     std::string mesh_file_path,
-    int32_t start_node_int
+    int32_t start_node_int,
+    const std::string cache_root = ""
 );
 
 std::vector<_3D::edge_descriptor> set_UV_border_edges(
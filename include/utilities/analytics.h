@@ -5,7 +5,7 @@
 
 void calculate_order_parameter(
     Eigen::VectorXd& v_order, 
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r, 
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r_dot, 
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_dot,
     int tt
 );
\ No newline at end of file
@@ -4,4 +4,5 @@
 
 #include <Eigen/Dense>
 
-Eigen::Matrix<double, Eigen::Dynamic, 2> angles_to_unit_vectors(const Eigen::VectorXd& avg_n);
\ No newline at end of file
+Eigen::Matrix<double, Eigen::Dynamic, 2> angles_to_unit_vectors(const Eigen::VectorXd& avg_n);
+Eigen::VectorXd unit_vectors_to_angles(const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec);
\ No newline at end of file
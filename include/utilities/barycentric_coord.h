@@ -2,15 +2,26 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <Eigen/Dense>
 
+double pointTriangleDistance(
+    const Eigen::Vector3d p,
+    const Eigen::Vector3d a,
+    const Eigen::Vector3d b,
+    const Eigen::Vector3d c
+);
+
+int closestRow(const Eigen::MatrixXd& vertices_uv, const Eigen::Vector2d& halfedge_coord);
+
 std::pair<Eigen::Vector3d, int> calculate_barycentric_3D_coord(
-    const Eigen::Matrix<double, Eigen::Dynamic, 2> r,
-    const Eigen::MatrixXd halfedges_uv,
-    const Eigen::MatrixXi faces_uv,
-    Eigen::MatrixXd vertices_uv,
-    Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXd& vertices_3D,
+    const std::vector<int64_t>& h_v_mapping,
     int interator
 );
 
@@ -19,6 +30,6 @@ Eigen::Vector3d calculate_barycentric_2D_coord(
     const Eigen::MatrixXi& faces_3D_static,
     const Eigen::MatrixXd& vertices_uv,
     const Eigen::MatrixXd& vertices_3D,
-    std::vector<int64_t>& h_v_mapping,
+    const std::vector<int64_t>& h_v_mapping,
     int iterator
 );
@@ -0,0 +1,33 @@
+// counter_rng.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+
+// Independent streams of random numbers, so that the different uses never draw the same numbers
+enum class RandomStream : uint32_t {
+    InitialParticles = 0,
+    AngularNoise = 1
+};
+
+
+/**
+ * @brief Counter based random numbers after Salmon et al. (2011), "Parallel random numbers: as easy as 1, 2, 3"
+ *
+ * The Philox4x32-10 bijection encrypts the counter (stream, step, particle id) with the seed as key.
+ * There is no state, so every particle draws its numbers independently and the results are the same
+ * at any thread count and in any order.
+*/
+class CounterRNG {
+public:
+    explicit CounterRNG(uint64_t seed = 0) : seed(seed) {}
+
+    // Two uniform numbers in [0, 1) with 53 random bits each
+    std::array<double, 2> uniform(RandomStream stream, uint32_t step, uint64_t id) const;
+
+    static std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+private:
+    uint64_t seed;
+};
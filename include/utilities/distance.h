@@ -1,6 +1,60 @@
 // distance.h
 #pragma once
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
-std::vector<double> geo_distance(int32_t start_node = 0);
-int get_all_distances(std::string mesh_path);
\ No newline at end of file
+#include <io/binary_matrix.h>
+#include <utilities/distance_provider.h>
+#include <utilities/heat_method.h>
+
+std::vector<double> geo_distance(const std::string mesh_path, int32_t start_node = 0);
+int get_mesh_vertex_count(const std::string mesh_path);
+std::shared_ptr<LazyDistanceRows> make_lazy_distance_rows(
+    const std::string mesh_path,
+    size_t max_bytes,
+    std::string spill_directory = ""
+);
+std::string get_distance_matrix_path(
+    const std::string mesh_path,
+    MatrixDtype dtype = MatrixDtype::Float64,
+    double cutoff = std::numeric_limits<double>::infinity(),
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay,
+    const std::string cache_root = ""
+);
+RowMajorMatrixXd get_distance_rows(
+    const std::string mesh_path,
+    const std::vector<int>& source_ids,
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay,
+    int block_size = 32
+);
+int get_all_distances(
+    std::string mesh_path,
+    MatrixDtype dtype = MatrixDtype::Float64,
+    double cutoff = std::numeric_limits<double>::infinity(),
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay,
+    int block_size = 32,
+    const std::string cache_root = "",
+    int checkpoint_rows = 1024
+);
+int compute_distance_shard(
+    std::string mesh_path,
+    int shard,
+    int num_shards,
+    MatrixDtype dtype = MatrixDtype::Float64,
+    double cutoff = std::numeric_limits<double>::infinity(),
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay,
+    int block_size = 32,
+    const std::string cache_root = "",
+    int checkpoint_rows = 1024
+);
+int merge_distance_shards(
+    std::string mesh_path,
+    int num_shards,
+    MatrixDtype dtype = MatrixDtype::Float64,
+    double cutoff = std::numeric_limits<double>::infinity(),
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay,
+    const std::string cache_root = "",
+    int checkpoint_rows = 1024
+);
@@ -0,0 +1,93 @@
+// distance_matrix.h
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance_provider.h>
+
+
+/**
+ * @brief Read-only geodesic distance matrix of the static 3D mesh
+ *
+ * The values are either memory mapped from the binary cache file or owned in memory.
+ * Only the upper triangle of the symmetrized matrix is stored, so (i, j) and (j, i) read the same value.
+ * With a finite cutoff only the pairs within the cutoff are stored as sparse rows and every missing pair reads as infinity,
+ * i.e. beyond the cutoff. The cutoff has to cover the largest interaction range of the simulation.
+ * They can be stored with reduced precision (float32 or uint16 with one scale), the lookup decodes them to double.
+ * Copies of the object share the same storage.
+*/
+class DistanceMatrix : public DistanceProvider {
+public:
+    DistanceMatrix() = default;
+    explicit DistanceMatrix(
+        const Eigen::MatrixXd& matrix,
+        MatrixDtype dtype = MatrixDtype::Float64,
+        double cutoff = std::numeric_limits<double>::infinity()
+    );
+
+    static DistanceMatrix load(const std::string& path);
+
+    int rows() const override { return num_vertices; }
+    int cols() const { return num_vertices; }
+    MatrixDtype dtype() const { return value_dtype; }
+    MatrixLayout layout() const { return value_layout; }
+    double cutoff() const override { return cutoff_distance; }
+    int64_t nonzeros() const;
+
+    double operator()(int row, int col) const {
+        int64_t index;
+        if (value_layout == MatrixLayout::SparseCSR) {
+            index = sparse_index(row, col);
+            if (index < 0) {
+                return std::numeric_limits<double>::infinity();
+            }
+        }
+        else {
+            index = packed_upper_index(row, col, num_vertices);
+        }
+
+        return value_at(index);
+    }
+
+    Eigen::MatrixXd distances_between(const std::vector<int>& vertex_ids) const override;
+    std::vector<double> distances_of_pairs(const std::vector<int>& vertex_ids, const std::vector<ParticlePair>& pairs) const override;
+    Eigen::VectorXd row(int row) const override;
+    std::vector<int> vertices_within(int row, double cutoff) const override;
+
+private:
+    double value_at(int64_t index) const {
+        switch (value_dtype) {
+            case MatrixDtype::Float32: return static_cast<const float*>(values)[index];
+            case MatrixDtype::UInt16: return static_cast<const uint16_t*>(values)[index] * scale;
+            default: return static_cast<const double*>(values)[index];
+        }
+    }
+
+    // Position of the entry inside the values of the sparse row, or -1 if the pair is beyond the cutoff
+    int64_t sparse_index(int row, int col) const {
+        const int32_t* begin = col_indices + row_offsets[row];
+        const int32_t* end = col_indices + row_offsets[row + 1];
+        const int32_t* found = std::lower_bound(begin, end, col);
+
+        return (found != end && *found == col) ? found - col_indices : -1;
+    }
+
+    void attach(const char* payload, const BinaryMatrixHeader& header);
+
+    std::shared_ptr<const void> storage;
+    const void* values = nullptr;
+    const int64_t* row_offsets = nullptr;
+    const int32_t* col_indices = nullptr;
+    MatrixDtype value_dtype = MatrixDtype::Float64;
+    MatrixLayout value_layout = MatrixLayout::PackedUpper;
+    double scale = 1.0;
+    double cutoff_distance = std::numeric_limits<double>::infinity();
+    int num_vertices = 0;
+};
@@ -0,0 +1,119 @@
+// distance_provider.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+
+// Indices of two particles, which are candidates for an interaction
+using ParticlePair = std::pair<int, int>;
+
+
+/**
+ * @brief Source of the geodesic distances between the vertices of the static 3D mesh
+ *
+ * The simulation only asks for the distances between the vertices, which are currently active,
+ * so an implementation does not need to know the whole matrix in advance.
+*/
+class DistanceProvider {
+public:
+    virtual ~DistanceProvider() = default;
+
+    virtual int rows() const = 0;
+
+    // Symmetric distances between all pairs of the given vertices
+    virtual Eigen::MatrixXd distances_between(const std::vector<int>& vertex_ids) const = 0;
+
+    // Symmetric distances of the candidate pairs, the pairs index into the given vertices
+    virtual std::vector<double> distances_of_pairs(const std::vector<int>& vertex_ids, const std::vector<ParticlePair>& pairs) const = 0;
+
+    // Distances of the vertex to all vertices of the mesh
+    virtual Eigen::VectorXd row(int row) const = 0;
+
+    // Vertices within the cutoff of the vertex, including the vertex itself
+    virtual std::vector<int> vertices_within(int row, double cutoff) const;
+
+    // Largest distance, which is stored, every pair beyond it reads as infinity
+    virtual double cutoff() const { return std::numeric_limits<double>::infinity(); }
+};
+
+
+// Computes the distances of one source vertex to all vertices of the mesh, it gets called concurrently for different rows
+using DistanceRowSolver = std::function<std::vector<double>(int)>;
+
+
+/**
+ * @brief Distance rows, which get computed the first time their vertex becomes active
+ *
+ * The rows are kept in a least recently used cache, which never holds more rows than the byte budget allows.
+ * The budget is a soft limit for a single lookup: it keeps the rows of all its vertices alive until it returns,
+ * so a lookup over more distinct vertices than the budget holds temporarily needs memory for all of them.
+ * Evicted rows can optionally be spilled to a directory, so that they get reloaded instead of recomputed.
+ * The spill key (e.g. of the mesh and the solver) is part of every spill file name, so different meshes and solvers
+ * can share one spill directory. The file header repeats the key and the vertex count, a mismatch gets recomputed.
+ * The rows get solved outside of the cache lock, so several threads solve different rows at the same time.
+ * A thread asking for a row, which is already being solved, waits for it instead of solving it again.
+ * The heat method distances are not exactly symmetric, therefore the smaller value of (i, j) and (j, i) is used,
+ * just like for the precomputed distance matrix.
+*/
+class LazyDistanceRows : public DistanceProvider {
+public:
+    LazyDistanceRows(
+        int num_vertices,
+        DistanceRowSolver solve_row,
+        size_t max_bytes,
+        std::string spill_directory = "",
+        uint64_t spill_key = 0
+    );
+
+    int rows() const override { return num_vertices; }
+    Eigen::MatrixXd distances_between(const std::vector<int>& vertex_ids) const override;
+    std::vector<double> distances_of_pairs(const std::vector<int>& vertex_ids, const std::vector<ParticlePair>& pairs) const override;
+    Eigen::VectorXd row(int row) const override;
+
+    size_t cached_rows() const;
+    size_t cached_bytes() const;
+    int64_t computed_rows() const { return num_computed; }
+    int64_t spilled_rows() const { return num_spilled; }
+
+private:
+    using Row = std::shared_ptr<const std::vector<double>>;
+
+    Row get_row(int vertex_id) const;
+    std::unordered_map<int, Row> get_rows(const std::vector<int>& vertex_ids) const;
+    Row load_spilled_row(int vertex_id) const;
+    void spill_row(int vertex_id, const std::vector<double>& distances) const;
+    bool read_spill_header(std::istream& file) const;
+    std::string spill_path(int vertex_id) const;
+
+    int num_vertices;
+    DistanceRowSolver solve_row;
+    size_t max_rows;
+    std::string spill_directory;
+    uint64_t spill_key;
+
+    // Most recently used rows are at the front of the list
+    mutable std::mutex cache_mutex;
+    mutable std::list<int> lru_order;
+    mutable std::unordered_map<int, std::pair<Row, std::list<int>::iterator>> cache;
+    mutable std::unordered_set<int> rows_in_flight;
+    // Evicted rows, which get written to the spill directory outside of the lock
+    mutable std::unordered_map<int, Row> rows_in_spill;
+    mutable std::condition_variable row_finished;
+    mutable std::atomic<int64_t> num_computed{0};
+    mutable std::atomic<int64_t> num_spilled{0};
+};
@@ -0,0 +1,135 @@
+// heat_method.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+
+/**
+ * @brief Heat method of the distance precompute
+ *
+ * The two variants give slightly different distances, so the variant is part of the cache key of the distance matrix.
+ * The block size only tunes the batched variant and never changes which heat method runs.
+*/
+enum class HeatMethodVariant {
+    // CGAL heat method on the intrinsic Delaunay triangulation of the mesh, one source per solve
+    IntrinsicDelaunay,
+    // HeatMethodSolver on the cotan Laplacian of the mesh itself, a block of sources per solve
+    Batched
+};
+
+std::string heat_method_name(HeatMethodVariant variant);
+HeatMethodVariant parse_heat_method(const std::string& name);
+
+
+/**
+ * @brief Heat method geodesic distances for a whole block of source vertices at once
+ *
+ * The heat flow and the Poisson system get factorized once with a sparse LDLT decomposition.
+ * A block of B sources is then solved as one dense right hand side matrix. The triangular solves, the gradient
+ * and the divergence traverse their sparse matrices only once per block and update all B columns of a row together,
+ * instead of traversing them once per source.
+ * Unlike the CGAL heat method used by default, no intrinsic Delaunay triangulation is built,
+ * so on meshes with non-Delaunay edges the distances differ slightly (HeatMethodVariant::Batched).
+*/
+class HeatMethodSolver {
+public:
+    HeatMethodSolver(const Eigen::MatrixXd& vertices, const Eigen::MatrixXi& faces, double time_factor = 1.0);
+
+    int num_vertices() const { return mass.size(); }
+
+    static double mean_edge_length(const Eigen::MatrixXd& vertices, const Eigen::MatrixXi& faces);
+
+    // Column k holds the distances of all vertices to source_ids[k]
+    Eigen::MatrixXd distances(const std::vector<int>& source_ids) const;
+
+private:
+    using RowMajorBlock = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    // P A P^T = L D L^T with a unit lower triangular L
+    struct LDLTFactor {
+        Eigen::SparseMatrix<double> L;
+        Eigen::VectorXd D;
+        Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> P;
+        Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> P_inverse;
+    };
+
+    static LDLTFactor factorize(const Eigen::SparseMatrix<double>& matrix);
+    static void solve_in_place(const LDLTFactor& factor, RowMajorBlock& block);
+
+    Eigen::SparseMatrix<double, Eigen::RowMajor> gradient;
+    Eigen::SparseMatrix<double, Eigen::RowMajor> divergence;
+    Eigen::VectorXd mass;
+    LDLTFactor heat_factor;
+    LDLTFactor poisson_factor;
+};
+
+
+/**
+ * @brief Heat method distances up to a cutoff, every source only gets solved on the patch of the mesh around it
+ *
+ * The patch holds the vertices within patch_factor · cutoff of the source along the mesh edges (Dijkstra).
+ * Edge paths are never shorter than the geodesics and on well shaped meshes less than twice as long,
+ * so with the default factor 2 every vertex within the cutoff lies inside the patch, away from its border.
+ * The heat flow keeps the time step of the whole mesh. Distances beyond the cutoff are infinity.
+ * Nearby sources of a block share one patch and get solved together as one block of right hand sides.
+ * A group, whose patch covers more than half of the mesh, gets solved on the whole mesh instead.
+*/
+class TruncatedHeatMethodSolver {
+public:
+    TruncatedHeatMethodSolver(
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& faces,
+        double cutoff,
+        double patch_factor = 2.0,
+        double time_factor = 1.0
+    );
+
+    int num_vertices() const { return vertices.rows(); }
+
+    // Column k holds the distances of all vertices to source_ids[k], infinity beyond the cutoff
+    Eigen::MatrixXd distances(const std::vector<int>& source_ids) const;
+
+    // Vertices within the patch radius of the source along the mesh edges, the source comes first
+    std::vector<int> patch_vertices(int source_id) const;
+
+    // Factorized patches and whole mesh blocks so far, each one solves a whole group of sources
+    int64_t group_solves() const { return num_group_solves; }
+
+private:
+    std::vector<std::pair<int, double>> edge_ball(int source_id, double radius) const;
+
+    void solve_group(
+        const std::vector<int>& patch,
+        const std::vector<int>& group_sources,
+        const std::vector<int>& group_columns,
+        Eigen::MatrixXd& block
+    ) const;
+
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi faces;
+    double cutoff;
+    double patch_radius;
+    double time_factor;
+    double mean_edge_length;
+
+    // Edges and faces around each vertex in CSR form
+    std::vector<int> edge_offsets;
+    std::vector<int> edge_targets;
+    std::vector<double> edge_lengths;
+    std::vector<int> face_offsets;
+    std::vector<int> vertex_faces;
+
+    // Built on the first source with a large patch
+    mutable std::once_flag whole_mesh_once;
+    mutable std::unique_ptr<HeatMethodSolver> whole_mesh_solver;
+    mutable std::atomic<int64_t> num_group_solves{0};
+};
@@ -3,10 +3,13 @@
 
 #include <Eigen/Dense>
 
+#include <utilities/counter_rng.h>
+
 void init_particle_position(
     const Eigen::MatrixXi faces_uv,
     const Eigen::MatrixXd halfedges_uv,
     int num_part,
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
-    Eigen::VectorXd& n
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
+    const CounterRNG& rng
 );
\ No newline at end of file
@@ -31,4 +31,5 @@ namespace UV {
                                 _3D::Seam_vertex_pmap>;
     using vertex_descriptor = boost::graph_traits<Mesh>::vertex_descriptor;
     using halfedge_descriptor = boost::graph_traits<Mesh>::halfedge_descriptor;
+    using face_descriptor = boost::graph_traits<Mesh>::face_descriptor;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <Eigen/Dense>
 #include <vector>
 #include <cstdint>
+#include <string>
 
 struct VertexData {
     Eigen::MatrixXd old_particle_pos;
@@ -19,4 +20,10 @@ struct Mesh_UV_Struct {
     Eigen::MatrixXd vertices_UV;
     Eigen::MatrixXd vertices_3D;
     std::string mesh_file_path;
-};
\ No newline at end of file
+};
+
+// Corners of each face of the UV mesh: their row in vertices_UV and vertices_3D, and their vertex id on the 3D mesh
+struct UVFaceTable {
+    Eigen::MatrixXi vertex_rows;
+    Eigen::Matrix<int64_t, Eigen::Dynamic, 3> vertex_ids;
+};
@@ -0,0 +1,103 @@
+// simulation_context.h
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/2D_mapping_fixed_border.h>
+#include <utilities/distance_provider.h>
+#include <utilities/sim_structs.h>
+#include <utilities/uv_affine_maps.h>
+#include <utilities/uv_face_grid.h>
+#include <utilities/uv_face_walk.h>
+
+
+/**
+ * @brief Static data of a simulation: the UV mesh, its mapping to the 3D mesh and the geodesic distances
+ *
+ * It gets built once and every step reads it by const reference, so the large buffers never get copied per step.
+ * The UV mesh consists of the rows of vertices_UV and the face table of the parameterization,
+ * so a located UV face directly gives the rows of its corners in vertices_3D.
+ * It is not the UV mesh file of the mesh registry, whose faces come in a different order.
+ * The context is immutable and cannot be copied, passing it by value does not compile.
+*/
+struct SimulationContext {
+    SimulationContext(
+        std::shared_ptr<const DistanceProvider> distance_matrix,
+        UVFaceTable face_table,
+        std::vector<int64_t> h_v_mapping,
+        Eigen::MatrixXd vertices_UV,
+        Eigen::MatrixXd vertices_3D,
+        std::string mesh_file_path
+    ) :
+        distance_matrix(std::move(distance_matrix)),
+        vertices_UV(std::move(vertices_UV)),
+        halfedges_uv(this->vertices_UV),
+        faces_uv(checked_face_rows(face_table, this->vertices_UV, vertices_3D, h_v_mapping)),
+        face_vertex_ids(std::move(face_table.vertex_ids)),
+        h_v_mapping(std::move(h_v_mapping)),
+        vertices_3D(std::move(vertices_3D)),
+        mesh_file_path(std::move(mesh_file_path)),
+        seam_type(get_seam_type(this->mesh_file_path)),
+        uv_face_grid(halfedges_uv, faces_uv),
+        uv_face_adjacency(calculate_face_adjacency(halfedges_uv, faces_uv)),
+        uv_affine_maps(this->vertices_UV, faces_uv, this->vertices_3D)
+    {}
+
+    SimulationContext(const SimulationContext&) = delete;
+    SimulationContext& operator=(const SimulationContext&) = delete;
+
+    const std::shared_ptr<const DistanceProvider> distance_matrix;
+    const Eigen::MatrixXd vertices_UV;
+    const Eigen::MatrixXd& halfedges_uv;        // UV coordinates of the vertices of the UV mesh, the rows of vertices_UV
+    const Eigen::MatrixXi faces_uv;             // rows of vertices_UV and vertices_3D of the face corners
+    const Eigen::Matrix<int64_t, Eigen::Dynamic, 3> face_vertex_ids;  // 3D vertex id of the face corners
+    const std::vector<int64_t> h_v_mapping;     // 3D vertex id of each row of vertices_UV and vertices_3D
+    const Eigen::MatrixXd vertices_3D;
+    const std::string mesh_file_path;
+    const SeamType seam_type;
+    const UVFaceGrid uv_face_grid;              // locates the UV face of a particle
+    const FaceAdjacency uv_face_adjacency;      // tracks the UV face of a particle from step to step
+    const UVAffineMaps uv_affine_maps;          // lifts a particle on its UV face to 3D
+
+private:
+    /**
+     * @brief The rows of the face table, after checking its shape and that every row exists
+     *
+     * It runs in the init list, before the face grid, the adjacency and the affine maps index the vertices with the rows.
+    */
+    static Eigen::MatrixXi checked_face_rows(
+        UVFaceTable& face_table,
+        const Eigen::MatrixXd& vertices_UV,
+        const Eigen::MatrixXd& vertices_3D,
+        const std::vector<int64_t>& h_v_mapping
+    ){
+        const Eigen::MatrixXi& rows = face_table.vertex_rows;
+        if (rows.cols() != 3 || rows.rows() != face_table.vertex_ids.rows()) {
+            throw std::invalid_argument("The face table needs the rows and the 3D vertex ids of the three corners of every face");
+        }
+        if (vertices_3D.rows() != vertices_UV.rows() || static_cast<Eigen::Index>(h_v_mapping.size()) != vertices_UV.rows()) {
+            throw std::invalid_argument("Every row of vertices_UV needs its 3D position and its 3D vertex id");
+        }
+
+        for (Eigen::Index face = 0; face < rows.rows(); ++face) {
+            for (int corner = 0; corner < 3; ++corner) {
+                const int row = rows(face, corner);
+                if (row < 0 || row >= vertices_UV.rows()) {
+                    throw std::invalid_argument("Face " + std::to_string(face) + " refers to the row " + std::to_string(row)
+                                                + ", but there are only " + std::to_string(vertices_UV.rows()) + " vertices");
+                }
+                if (face_table.vertex_ids(face, corner) != h_v_mapping[row]) {
+                    throw std::invalid_argument("The 3D vertex id of face " + std::to_string(face) + " does not match the vertex id of its row");
+                }
+            }
+        }
+
+        return std::move(face_table.vertex_rows);
+    }
+};
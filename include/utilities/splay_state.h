@@ -6,6 +6,8 @@
 #include <vector>
 #include <Eigen/Dense>
 
+#include <utilities/distance_matrix.h>
+
 using Matrix3Xi = Eigen::Matrix<int, Eigen::Dynamic, 3>;
 
 std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, std::vector<int>> get_splay_state_vertices(
@@ -15,6 +17,6 @@ std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, std::vector<int>> get_splay
 );
 
 std::vector<int> get_3D_splay_vertices(
-    Eigen::MatrixXd distance_matrix,
+    const DistanceMatrix& distance_matrix,
     int modula_mode
 );
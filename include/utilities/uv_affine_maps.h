@@ -0,0 +1,56 @@
+// uv_affine_maps.h
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+
+
+/**
+ * @brief Affine map of every UV face onto its 3D face
+ *
+ * On face f a UV point p lifts to J_f p + o_f, which is exactly the barycentric interpolation of the 3D corners.
+ * J_f is the 3x2 Jacobian of the face, its pseudo-inverse maps the tangential 3D velocities back to UV velocities.
+ * The maps of a face are stored contiguously, so lifting a particle is a single 3x2 multiply-add.
+*/
+class UVAffineMaps {
+public:
+    // The face corners index the rows of both vertices_uv and vertices_3D
+    UVAffineMaps(
+        const Eigen::MatrixXd& vertices_uv,
+        const Eigen::MatrixXi& face_vertex_rows,
+        const Eigen::MatrixXd& vertices_3D
+    );
+
+    Eigen::Vector3d lift(const Eigen::Vector2d& point, int face) const;
+
+    // Lift all particles, particle i lies on face faces[i]
+    Eigen::MatrixXd lift(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r, const std::vector<int>& faces) const;
+
+    // Barycentric coordinates of the UV point with respect to the corners of the face
+    Eigen::Vector3d barycentric(const Eigen::Vector2d& point, int face) const;
+
+    // Corner of the face closest to the lifted 3D point, the first one on a tie
+    int nearest_corner(const Eigen::Vector2d& point, int face) const;
+
+    Eigen::Vector3d lift_velocity(const Eigen::Vector2d& velocity_uv, int face) const;
+    Eigen::Vector2d uv_velocity(const Eigen::Vector3d& velocity_3D, int face) const;
+
+    // Largest UV length per 3D length on the face, the largest singular value of the pseudo-inverse of J
+    double uv_stretch(int face) const;
+
+    int num_faces() const { return static_cast<int>(lift_maps.rows()); }
+
+private:
+    // Per face: J (3x2, row-major) followed by the offset o
+    Eigen::Matrix<double, Eigen::Dynamic, 9, Eigen::RowMajor> lift_maps;
+
+    // Per face: the inverse of the UV edge matrix (2x2, row-major) followed by the first UV corner,
+    // giving the barycentric coordinates of the second and third corner
+    Eigen::Matrix<double, Eigen::Dynamic, 6, Eigen::RowMajor> barycentric_maps;
+
+    // Per face: the pseudo-inverse of J (2x3, row-major)
+    Eigen::Matrix<double, Eigen::Dynamic, 6, Eigen::RowMajor> inverse_jacobians;
+
+    // Per face: the three 3D corners, one after the other
+    Eigen::Matrix<double, Eigen::Dynamic, 9, Eigen::RowMajor> corners_3D;
+};
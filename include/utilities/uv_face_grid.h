@@ -0,0 +1,42 @@
+// uv_face_grid.h
+#pragma once
+
+#include <array>
+#include <vector>
+#include <Eigen/Dense>
+
+
+/**
+ * @brief Uniform grid over the bounding box of a UV mesh, whose cells list the faces overlapping them
+ *
+ * Every face is binned into all cells covered by its bounding box. A query searches rings of cells around the point
+ * and stops as soon as no face outside the searched cells can be closer than the closest face found so far.
+ * Points inside the mesh therefore only look at a few faces. The result is the same face as the scan over all faces,
+ * including the smallest index among equally distant faces.
+*/
+class UVFaceGrid {
+public:
+    // Without a given resolution the grid gets about one cell per two faces
+    UVFaceGrid(const Eigen::MatrixXd& halfedges_uv, const Eigen::MatrixXi& faces_uv, int cells_per_side = 0);
+
+    // Face containing the UV point, or the nearest face if the point lies outside of the mesh
+    int nearest_face(const Eigen::Vector2d& point) const;
+
+    int cells_per_side() const { return num_cells_per_side; }
+    int num_faces() const { return static_cast<int>(corners.size()); }
+
+private:
+    int cell_coord(double value, double min) const;
+    int cell_id(int x, int y) const { return y * num_cells_per_side + x; }
+
+    int num_cells_per_side;
+    Eigen::Vector2d min_corner;
+    double cell_size;
+
+    // UV corners of each face, padded with z = 0 for the point triangle distance
+    std::vector<std::array<Eigen::Vector3d, 3>> corners;
+
+    // Faces binned by cell, the faces of cell c are cell_faces[cell_start[c], cell_start[c + 1])
+    std::vector<int> cell_start;
+    std::vector<int> cell_faces;
+};
@@ -0,0 +1,38 @@
+// uv_face_walk.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+
+
+/**
+ * @brief Faces sharing an edge with each face of the UV mesh, as compressed sparse rows
+ *
+ * The neighbors of face f are neighbors[offsets[f], offsets[f + 1]), the shared edge of the i-th entry
+ * lies opposite to the corner opposite_corner[i] of face f.
+ * Edges are matched by the UV coordinates of their vertices, so the table does not rely on the mesh loader
+ * sharing the vertex indices between faces. Faces along the seam have no neighbor across it.
+*/
+struct FaceAdjacency {
+    std::vector<int> offsets;
+    std::vector<int> neighbors;
+    std::vector<int8_t> opposite_corner;
+};
+
+FaceAdjacency calculate_face_adjacency(const Eigen::MatrixXd& halfedges_uv, const Eigen::MatrixXi& faces_uv);
+
+/**
+ * @brief Walk from the start face across the edges towards the UV point
+ *
+ * @return the face containing the point, or -1 if the walk left the mesh, took more than max_steps
+ * or ended too close to an edge to decide between the faces sharing it. The caller then has to locate the point globally.
+*/
+int walk_to_face(
+    const Eigen::Vector2d& point,
+    int start_face,
+    const FaceAdjacency& adjacency,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    int max_steps = 64
+);
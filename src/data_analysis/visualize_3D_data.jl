@@ -60,8 +60,20 @@ end
 
 num_part = 999
 
+# The UV meshes are cached as <mesh>_uv_<hash>.off under TISSUE_CACHE_DIR, else under meshes/data
+function find_uv_mesh(mesh_name)
+    cache_root = get(ENV, "TISSUE_CACHE_DIR", "")
+    cache_root = isempty(cache_root) ? joinpath("meshes", "data") : cache_root
+    uv_files = filter(file -> startswith(file, mesh_name * "_uv_") && endswith(file, ".off"), readdir(cache_root))
+    isempty(uv_files) && error("No cached UV mesh of $(mesh_name) in $(cache_root), run the simulation first")
+
+    # the most recently written UV mesh belongs to the last simulation run
+    uv_paths = joinpath.(cache_root, uv_files)
+    return uv_paths[argmax(mtime.(uv_paths))]
+end
+
 mesh_loaded = FileIO.load("meshes/ellipsoid_x4.off")  # 3D mesh
-mesh_loaded_uv = FileIO.load("meshes/ellipsoid_x4_uv.off")  # 2D mesh
+mesh_loaded_uv = FileIO.load(find_uv_mesh("ellipsoid_x4"))  # 2D mesh
 vertices_3D = GeometryBasics.coordinates(mesh_loaded) |> vec_of_vec_to_array  # return the vertices of the mesh
 
 observe_r = Makie.Observable(fill(Point3f0(NaN), num_part))
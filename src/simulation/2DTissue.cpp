@@ -1,17 +1,31 @@
 // TODO: implement the 2DTissue.h '    System update( // Get vector with particle back);' ' Code here and move the main.cpp to this new structure
 // We should start this simulation from here
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 #include <Eigen/Dense>
 #include <boost/filesystem.hpp>
 
+#include <particle_simulation/cell_list.h>
 #include <particle_simulation/simulation.h>
+#include <particle_simulation/verlet_list.h>
+#include <particle_simulation/vertex_neighborhoods.h>
+#include <utilities/angles_to_unit_vectors.h>
 #include <utilities/init_particle.h>
 #include <utilities/2D_3D_mapping.h>
+#include <utilities/2D_mapping_fixed_border.h>
 #include <utilities/2D_surface.h>
 #include <utilities/distance.h>
+#include <utilities/distance_matrix.h>
+#include <utilities/heat_method.h>
 #include <utilities/splay_state.h>
 
+#include <io/binary_matrix.h>
 #include <io/csv.h>
 #include <io/mesh_loader.h>
 
@@ -31,7 +45,19 @@ _2DTissue::_2DTissue(
     double r_adh,
     double k_adh,
     double step_size,
-    int map_cache_count
+    int map_cache_count,
+    MatrixDtype distance_dtype,
+    double distance_cutoff,
+    size_t distance_cache_bytes,
+    std::string distance_spill_path,
+    HeatMethodVariant distance_heat_method,
+    int distance_block_size,
+    std::string cache_root,
+    NeighborSearchType neighbor_search_type,
+    double neighbor_skin,
+    uint64_t seed,
+    double noise,
+    ForceReduction force_reduction
 ) :
     mesh_path(mesh_path),
     particle_count(particle_count),
@@ -47,29 +73,63 @@ _2DTissue::_2DTissue(
     step_size(step_size),
     current_step(0),
     map_cache_count(map_cache_count),
-    finished(false)
+    distance_dtype(distance_dtype),
+    distance_cutoff(distance_cutoff),
+    force_reduction(force_reduction),
+    finished(false),
+    angular_noise{CounterRNG(seed), noise}
 {
-    // Get the mesh name from the path without the file extension
-    std::string mesh_name = mesh_path.substr(mesh_path.find_last_of("/\\") + 1);
-    mesh_name = mesh_name.substr(0, mesh_name.find_last_of("."));
+    if (noise < 0) {
+        throw std::invalid_argument("The noise amplitude has to be non-negative");
+    }
+    if (neighbor_skin < 0) {
+        throw std::invalid_argument("The skin of the neighbor list has to be non-negative");
+    }
 
-    // Initialize the simulation
-    // Check if the distance matrix of the static 3D mesh already exists
-    std::string distance_matrix_path = PROJECT_PATH + "/meshes/data/" + mesh_name + "_distance_matrix_static.csv";
-    if (!boost::filesystem::exists(distance_matrix_path)) {
+    // The sparse distance matrix has to contain every pair, which can still interact (repulsion, adhesion and neighbor count),
+    // including the pairs in the skin of the Verlet list
+    const double interaction_range = std::max(2.4 * σ, r_adh);
+    if (distance_cutoff < interaction_range + neighbor_skin) {
+        throw std::invalid_argument("The distance cutoff has to be at least max(2.4 * σ, r_adh) + neighbor_skin");
+    }
 
-        // Calculate the distance matrix of the static 3D mesh
-        get_all_distances(mesh_path);
+    // The lazy distance rows keep every row at full precision
+    if (distance_cache_bytes > 0 && (distance_dtype != MatrixDtype::Float64 || !std::isinf(distance_cutoff))) {
+        throw std::invalid_argument("The lazy distance rows take neither a distance dtype nor a distance cutoff, only the precomputed distance matrix does");
+    }
+    if (neighbor_search_type == NeighborSearchType::MeshVertices && distance_cache_bytes > 0) {
+        throw std::invalid_argument("The vertex neighborhoods need the precomputed distance matrix instead of the lazy distance rows");
+    }
+
+    // Initialize the simulation
+    std::shared_ptr<const DistanceProvider> distance_matrix;
+    if (distance_cache_bytes > 0) {
+        // Compute the distance rows only for the vertices the particles actually visit
+        distance_matrix = make_lazy_distance_rows(mesh_path, distance_cache_bytes, distance_spill_path);
+    }
+    else {
+        // Check if the distance matrix of the static 3D mesh already exists
+        std::string distance_matrix_path = get_distance_matrix_path(mesh_path, distance_dtype, distance_cutoff, distance_heat_method, cache_root);
+        if (!is_valid_binary_matrix(distance_matrix_path, file_checksum(mesh_path), distance_dtype, distance_cutoff)) {
+
+            // Calculate the distance matrix of the static 3D mesh
+            get_all_distances(mesh_path, distance_dtype, distance_cutoff, distance_heat_method, distance_block_size, cache_root);
+        }
+        distance_matrix = std::make_shared<DistanceMatrix>(DistanceMatrix::load(distance_matrix_path));
     }
-    distance_matrix = load_csv<Eigen::MatrixXd>(distance_matrix_path);
 
-    // std::tie is used to unpack the values returned by create_uv_surface function directly into your class member variables.
-    // std::ignore is used to ignore values you don't need from the returned tuple.
-    std::tie(h_v_mapping, vertices_UV, vertices_3D, mesh_file_path) = create_uv_surface(mesh_path, 0);
+    // Build the static data of the simulation once, the steps only read it
+    auto [h_v_mapping, vertices_UV, vertices_3D, mesh_file_path, face_table] = create_uv_surface(mesh_path, 0, cache_root);
+    context = std::make_shared<const SimulationContext>(
+        std::move(distance_matrix),
+        std::move(face_table),
+        std::move(h_v_mapping),
+        std::move(vertices_UV),
+        std::move(vertices_3D),
+        std::move(mesh_file_path)
+    );
 
-    loadMeshVertices(mesh_file_path, halfedge_uv);
-    loadMeshFaces(mesh_file_path, faces_uv);
-    vertices_2DTissue_map[0] = Mesh_UV_Struct{0, halfedge_uv, h_v_mapping, vertices_UV, vertices_3D, mesh_file_path};
+    build_neighbor_search(neighbor_search_type, interaction_range, neighbor_skin);
 
     // Initialize the order parameter vector
     v_order = Eigen::VectorXd::Zero(step_count);
@@ -96,12 +156,97 @@ _2DTissue::_2DTissue(
 }
 
 
+/**
+ * @brief Simulation on an already built context, the mesh and its distances are neither loaded nor computed again
+ *
+ * The physical parameters are the defaults of the mesh constructor.
+*/
+_2DTissue::_2DTissue(
+    std::shared_ptr<const SimulationContext> context,
+    int particle_count,
+    int step_count,
+    NeighborSearchType neighbor_search_type,
+    double neighbor_skin,
+    uint64_t seed,
+    ForceReduction force_reduction
+) :
+    particle_count(particle_count),
+    step_count(step_count),
+    v0(TissueDefaults::v0),
+    k(TissueDefaults::k),
+    k_next(TissueDefaults::k_next),
+    v0_next(TissueDefaults::v0_next),
+    σ(TissueDefaults::σ),
+    μ(TissueDefaults::μ),
+    r_adh(TissueDefaults::r_adh),
+    k_adh(TissueDefaults::k_adh),
+    step_size(TissueDefaults::step_size),
+    current_step(0),
+    map_cache_count(0),
+    distance_dtype(MatrixDtype::Float64),
+    distance_cutoff(std::numeric_limits<double>::infinity()),
+    force_reduction(force_reduction),
+    finished(false),
+    angular_noise{CounterRNG(seed), 0},
+    context(std::move(context))
+{
+    if (!this->context) {
+        throw std::invalid_argument("The simulation needs a context");
+    }
+    if (neighbor_skin < 0) {
+        throw std::invalid_argument("The skin of the neighbor list has to be non-negative");
+    }
+    mesh_path = this->context->mesh_file_path;
+
+    build_neighbor_search(neighbor_search_type, std::max(2.4 * σ, r_adh), neighbor_skin);
+    v_order = Eigen::VectorXd::Zero(step_count);
+}
+
+
+/**
+ * @brief The neighbor search has to cover the largest interaction range plus the skin of the Verlet list
+*/
+void _2DTissue::build_neighbor_search(NeighborSearchType neighbor_search_type, double interaction_range, double neighbor_skin){
+    const double search_range = interaction_range + neighbor_skin;
+    if (neighbor_search_type == NeighborSearchType::MeshVertices) {
+        neighbor_search = std::make_shared<VertexNeighborhoods>(*context->distance_matrix, search_range);
+    }
+    else {
+        // The UV cells additionally have to cover the local stretch of the UV map and the snapping of both particles to a vertex
+        auto cell_list = std::make_shared<UVCellList>(
+            search_range,
+            2 * max_uv_edge_length(context->halfedges_uv, context->faces_uv),
+            context->halfedges_uv,
+            context->faces_uv,
+            context->uv_affine_maps,
+            context->seam_type
+        );
+        if (cell_list->cells_per_side() < 4) {
+            std::cout << "Warning: the UV map only fits " << cell_list->cells_per_side() << " cells per side, "
+                      << "the neighbor search compares nearly all pairs of particles" << std::endl;
+        }
+        neighbor_search = cell_list;
+    }
+
+    // Reuse the pairs over several steps, until a particle moved more than half of the skin.
+    // The heat method distances violate the triangle inequality by up to about one mean edge length of the mesh
+    if (neighbor_skin > 0) {
+        const double distance_error = HeatMethodSolver::mean_edge_length(context->vertices_3D, context->faces_uv);
+        if (neighbor_skin <= 2 * distance_error) {
+            std::cout << "Warning: the skin of the neighbor list is not larger than twice the mean edge length " << distance_error
+                      << ", the neighbor list gets rebuilt on every step" << std::endl;
+        }
+        neighbor_search = std::make_shared<VerletList>(neighbor_search, context->distance_matrix, interaction_range, neighbor_skin, distance_error);
+    }
+}
+
+
 void _2DTissue::start(){
     // Initialize the particles in 2D
     r.resize(particle_count, Eigen::NoChange);
-    n.resize(particle_count);
+    n.resize(particle_count, Eigen::NoChange);
 
-    init_particle_position(faces_uv, halfedge_uv, particle_count, r, n);
+    init_particle_position(context->faces_uv, context->halfedges_uv, particle_count, r, n, angular_noise.rng);
 
     // auto [coord_test, active_test] = get_r3d(r, halfedge_uv, faces_uv, vertices_UV, vertices_3D, h_v_mapping);
 
@@ -111,19 +256,20 @@ void _2DTissue::start(){
     // save_matrix_to_csv(coord_test, file_name_3D, num_part);
 
     // Map the 2D coordinates to their 3D vertices counterparts
-    std::tie(std::ignore, vertices_3D_active) = get_r3d(r, halfedge_uv, faces_uv, vertices_UV, vertices_3D, h_v_mapping);
+    particle_faces.assign(particle_count, -1);
+    std::tie(std::ignore, vertices_3D_active) = get_r3d(r, *context, particle_faces);
 }
 
 
 System _2DTissue::update(){
     // Simulate the particles on the 2D surface
-    auto [r_new, r_dot, dist_length, n_new, particles_color] = perform_particle_simulation(r, n, vertices_3D_active, distance_matrix, v_order, v0, k, k_next, v0_next, σ, μ, r_adh, k_adh, step_size, current_step, particle_count, vertices_2DTissue_map);
-    r = r_new;
-    n = n_new;
+    auto [r_new, r_dot, n_new, particles_color] = perform_particle_simulation(r, n, vertices_3D_active, *context, *neighbor_search, v_order, v0, k, k_next, v0_next, σ, μ, r_adh, k_adh, step_size, current_step, particle_count, angular_noise, force_reduction);
+    r = std::move(r_new);
+    n = std::move(n_new);
 
     // Get the 3D vertices coordinates from the 2D particle position coordinates
-    auto [r_3D, new_vertices_3D_active] = get_r3d(r, halfedge_uv, faces_uv, vertices_UV, vertices_3D, h_v_mapping);
-    vertices_3D_active = new_vertices_3D_active;
+    auto [r_3D, new_vertices_3D_active] = get_r3d(r, *context, particle_faces);
+    vertices_3D_active = std::move(new_vertices_3D_active);
 
     std::vector<Particle> particles;
     // start for loop
@@ -138,6 +284,10 @@ System _2DTissue::update(){
         p.x_3D = r_3D(i, 0);
         p.y_3D = r_3D(i, 1);
         p.z_3D = r_3D(i, 2);
+        Eigen::Vector3d velocity_3D = context->uv_affine_maps.lift_velocity(Eigen::Vector2d(r_dot(i, 0), r_dot(i, 1)), particle_faces[i]);
+        p.x_velocity_3D = velocity_3D[0];
+        p.y_velocity_3D = velocity_3D[1];
+        p.z_velocity_3D = velocity_3D[2];
         p.neighbor_count = particles_color[i];
         particles.push_back(p);
     }
@@ -145,6 +295,8 @@ System _2DTissue::update(){
     System system;
     system.order_parameter = v_order(v_order.rows() - 1, 0);
     system.particles = particles;
+    system.neighbor_list_rebuilds = neighbor_search->stats().rebuilds;
+    system.neighbor_list_rebuild_rate = neighbor_search->stats().rebuild_rate();
 
     current_step++;
     if (current_step >= step_count) {
@@ -166,4 +318,12 @@ bool _2DTissue::is_finished() {
 
 Eigen::VectorXd _2DTissue::get_order_parameter() {
     return v_order;
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Flight direction of the particles as angle degrees in the UV plane, the simulation itself uses unit vectors
+*/
+Eigen::VectorXd _2DTissue::get_orientation_degrees() {
+    return unit_vectors_to_angles(n);
+}
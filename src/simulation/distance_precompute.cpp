@@ -0,0 +1,108 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-25
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Sharded precomputation of the distance matrix for large meshes.
+Each shard computes its own range of rows and writes it next to the cache file, without any coordination with the
+other shards, so they can run as separate processes or batch jobs. The merge assembles the cache file once all
+shards are complete.
+
+    distance_precompute shard <mesh> <shard> <num_shards> [options]
+    distance_precompute merge <mesh> <num_shards> [options]
+
+All shards and the merge need the same options, because they are part of the cache key.
+Several shards on one machine should split the cores, e.g. with OMP_NUM_THREADS, instead of each using all of them.
+*/
+
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance.h>
+
+
+struct PrecomputeOptions {
+    MatrixDtype dtype = MatrixDtype::Float64;
+    double cutoff = std::numeric_limits<double>::infinity();
+    HeatMethodVariant heat_method = HeatMethodVariant::IntrinsicDelaunay;
+    int block_size = 32;
+    std::string cache_root = "";
+    int checkpoint_rows = 1024;
+};
+
+
+void print_usage() {
+    std::cerr << "Usage:\n"
+              << "  distance_precompute shard <mesh> <shard> <num_shards> [options]\n"
+              << "  distance_precompute merge <mesh> <num_shards> [options]\n"
+              << "Options:\n"
+              << "  --dtype f64|f32|u16        value type of the cache file (default f64)\n"
+              << "  --cutoff <distance>        keep only the distances within the cutoff (default none)\n"
+              << "  --heat-method idt|batched  CGAL heat method on the intrinsic Delaunay triangulation or the batched heat method\n"
+              << "                             on the cotan Laplacian of the mesh, their distances differ slightly (default idt)\n"
+              << "                             with a cutoff the batched heat method solves each source on its patch of the mesh\n"
+              << "  --block-size <sources>     sources per batched heat method solve, only tunes its speed (default 32)\n"
+              << "  --cache-root <directory>   cache directory (default $TISSUE_CACHE_DIR or meshes/data)\n"
+              << "  --checkpoint-rows <rows>   rows per checkpoint block (default 1024)\n";
+}
+
+
+PrecomputeOptions parse_options(const std::vector<std::string>& arguments) {
+    PrecomputeOptions options;
+
+    for (size_t i = 0; i < arguments.size(); i += 2) {
+        if (i + 1 >= arguments.size()) {
+            throw std::invalid_argument("Missing value of the option " + arguments[i]);
+        }
+        const std::string& name = arguments[i];
+        const std::string& value = arguments[i + 1];
+
+        if (name == "--dtype") options.dtype = parse_dtype(value);
+        else if (name == "--cutoff") options.cutoff = std::stod(value);
+        else if (name == "--heat-method") options.heat_method = parse_heat_method(value);
+        else if (name == "--block-size") options.block_size = std::stoi(value);
+        else if (name == "--cache-root") options.cache_root = value;
+        else if (name == "--checkpoint-rows") options.checkpoint_rows = std::stoi(value);
+        else throw std::invalid_argument("Unknown option " + name);
+    }
+
+    return options;
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    if (arguments.size() < 3) {
+        print_usage();
+        return 1;
+    }
+
+    try {
+        const std::string& command = arguments[0];
+        const std::string& mesh_path = arguments[1];
+
+        if (command == "shard" && arguments.size() >= 4) {
+            PrecomputeOptions options = parse_options(std::vector<std::string>(arguments.begin() + 4, arguments.end()));
+            return compute_distance_shard(mesh_path, std::stoi(arguments[2]), std::stoi(arguments[3]),
+                                          options.dtype, options.cutoff, options.heat_method, options.block_size, options.cache_root, options.checkpoint_rows);
+        }
+        if (command == "merge") {
+            PrecomputeOptions options = parse_options(std::vector<std::string>(arguments.begin() + 3, arguments.end()));
+            return merge_distance_shards(mesh_path, std::stoi(arguments[2]),
+                                         options.dtype, options.cutoff, options.heat_method, options.cache_root, options.checkpoint_rows);
+        }
+    }
+    catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    print_usage();
+    return 1;
+}
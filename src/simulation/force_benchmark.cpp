@@ -0,0 +1,98 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Benchmark of the pair interactions of a step: thread local force buffers against the pair coloring, both compared with
+the serial accumulation at 1, 2, 4, 8 and 16 threads.
+The particles are spread uniformly over the UV square and their pairs are found with the cell list.
+The pairs stay the same over all repetitions like between two rebuilds of the Verlet list, so the coloring gets
+computed once in the workspace and its cost gets reported separately.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_list.h>
+#include <particle_simulation/forces.h>
+#include <particle_simulation/pair_interactions.h>
+
+
+double time_pair_interactions(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double σ,
+    ForceReduction reduction,
+    PairWorkspace& workspace,
+    int repetitions
+){
+    // The first call fills the workspace for the pairs
+    calculate_pair_interactions(r, n, pairs, pair_distances, 10, σ, 1, 0.75, reduction, workspace);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        calculate_pair_interactions(r, n, pairs, pair_distances, 10, σ, 1, 0.75, reduction, workspace);
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    return duration.count() / repetitions;
+}
+
+
+int main()
+{
+    const int repetitions = 20;
+    const std::vector<int> thread_counts = {1, 2, 4, 8, 16};
+    const std::vector<std::pair<std::string, ForceReduction>> reductions = {
+        {"thread local buffers", ForceReduction::ThreadLocalBuffers},
+        {"pair coloring", ForceReduction::PairColoring}
+    };
+
+    for (int num_part : {10000, 100000}) {
+        // About six neighbors within 2σ per particle
+        const double σ = 0.7 / std::sqrt(num_part);
+
+        Eigen::Matrix<double, Eigen::Dynamic, 2> r = (Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(num_part, 2).array() + 1.0) / 2;
+        Eigen::Matrix<double, Eigen::Dynamic, 2> n = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(num_part, 2).rowwise().normalized();
+        UVCellList cell_list(2 * σ, SeamType::Opposite);
+        std::vector<ParticlePair> pairs = cell_list.find_pairs(r, {});
+
+        std::vector<double> pair_distances;
+        pair_distances.reserve(pairs.size());
+        for (const auto& [i, j] : pairs) {
+            pair_distances.push_back((r.row(i) - r.row(j)).norm());
+        }
+
+        omp_set_num_threads(1);
+        PairWorkspace workspace;
+        const double serial = time_pair_interactions(r, n, pairs, pair_distances, σ, ForceReduction::Serial, workspace, repetitions);
+        std::cout << num_part << " particles, " << pairs.size() << " candidate pairs, serial: " << serial * 1e3 << " ms" << '\n';
+
+        auto coloring_start = std::chrono::steady_clock::now();
+        PairColors colors = color_pairs(pairs, num_part);
+        std::chrono::duration<double> coloring = std::chrono::steady_clock::now() - coloring_start;
+        std::cout << num_part << " particles, coloring once per pair list: " << coloring.count() * 1e3 << " ms, "
+                  << colors.num_colors() << " colors" << '\n';
+
+        for (const auto& [name, reduction] : reductions) {
+            for (int num_threads : thread_counts) {
+                omp_set_num_threads(num_threads);
+                const double parallel = time_pair_interactions(r, n, pairs, pair_distances, σ, reduction, workspace, repetitions);
+
+                std::cout << num_part << " particles, " << name << ", " << num_threads << " threads: "
+                          << parallel * 1e3 << " ms, speedup " << serial / parallel << '\n';
+            }
+        }
+    }
+
+    return 0;
+}
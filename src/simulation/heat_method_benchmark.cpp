@@ -0,0 +1,71 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-24
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Benchmark of the batched heat method of the distance precomputation.
+The reference is block size 1, the same solver with a single source per solve, so the speedup only shows the batching.
+The per source CGAL heat method of the default precomputation builds an intrinsic Delaunay triangulation first,
+therefore it gets reported on its own line and its distances differ from the batched ones.
+Only the first rows of each mesh get computed, which is enough to compare the throughput.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <omp.h>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance.h>
+
+const boost::filesystem::path PROJECT_PATH = PROJECT_SOURCE_DIR;
+
+
+// Distance rows of the sources and the seconds it took to compute them, block size 0 runs the CGAL heat method
+std::pair<RowMajorMatrixXd, double> timed_distance_rows(const std::string& mesh_path, const std::vector<int>& source_ids, int block_size) {
+    auto start = std::chrono::steady_clock::now();
+    RowMajorMatrixXd rows = block_size > 0
+        ? get_distance_rows(mesh_path, source_ids, HeatMethodVariant::Batched, block_size)
+        : get_distance_rows(mesh_path, source_ids, HeatMethodVariant::IntrinsicDelaunay);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    return {rows, duration.count()};
+}
+
+
+int main()
+{
+    const int max_sources = 512;
+    const std::vector<int> block_sizes = {8, 32, 128};
+    std::cout << "OpenMP threads: " << omp_get_max_threads() << '\n';
+
+    for (std::string mesh_name : {"sphere", "ellipsoid_x4", "bear"}) {
+        std::string mesh_path = PROJECT_PATH.string() + "/meshes/" + mesh_name + ".off";
+
+        int num_vertices = get_mesh_vertex_count(mesh_path);
+        std::vector<int> source_ids(std::min(max_sources, num_vertices));
+        std::iota(source_ids.begin(), source_ids.end(), 0);
+
+        auto [reference, reference_duration] = timed_distance_rows(mesh_path, source_ids, 1);
+        std::cout << mesh_name << " (" << num_vertices << " vertices), block size 1: " << source_ids.size() / reference_duration << " rows/s" << '\n';
+
+        for (int block_size : block_sizes) {
+            auto [batched, batched_duration] = timed_distance_rows(mesh_path, source_ids, block_size);
+            double relative_difference = (batched - reference).norm() / reference.norm();
+
+            std::cout << mesh_name << ", block size " << block_size << ": " << source_ids.size() / batched_duration << " rows/s, speedup "
+                      << reference_duration / batched_duration << ", relative difference " << relative_difference << '\n';
+        }
+
+        auto [per_source, per_source_duration] = timed_distance_rows(mesh_path, source_ids, 0);
+        std::cout << mesh_name << ", CGAL heat method with intrinsic Delaunay triangulation: " << source_ids.size() / per_source_duration << " rows/s, "
+                  << "relative difference to block size 1 " << (per_source - reference).norm() / reference.norm() << '\n';
+    }
+
+    return 0;
+}
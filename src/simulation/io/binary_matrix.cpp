@@ -0,0 +1,494 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-20
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Binary cache format for large symmetric matrices, e.g. the geodesic distance matrix of the static 3D mesh.
+The payload is either the raw packed upper triangle or, for large meshes, only the entries below a distance cutoff
+in compressed sparse row format. Both can be memory mapped and used without any parsing.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <io/binary_matrix.h>
+#include <io/precompute_cache.h>
+
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file for memory mapping: " + path);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to get the size of the file: " + path);
+    }
+    mapped_size = static_cast<size_t>(file_stat.st_size);
+
+    void* mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping stays valid after closing the file descriptor
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to memory map the file: " + path);
+    }
+
+    // Let the kernel start reading the file in the background, so a cold start runs close to the disk bandwidth
+    posix_madvise(mapping, mapped_size, POSIX_MADV_WILLNEED);
+
+    mapped_data = static_cast<const char*>(mapping);
+}
+
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (mapped_data != nullptr) {
+        munmap(const_cast<char*>(mapped_data), mapped_size);
+    }
+}
+
+
+size_t dtype_size(MatrixDtype dtype) {
+    switch (dtype) {
+        case MatrixDtype::Float64: return sizeof(double);
+        case MatrixDtype::Float32: return sizeof(float);
+        case MatrixDtype::UInt16: return sizeof(uint16_t);
+    }
+    throw std::invalid_argument("Unknown matrix dtype");
+}
+
+
+std::string dtype_name(MatrixDtype dtype) {
+    switch (dtype) {
+        case MatrixDtype::Float64: return "f64";
+        case MatrixDtype::Float32: return "f32";
+        case MatrixDtype::UInt16: return "u16";
+    }
+    throw std::invalid_argument("Unknown matrix dtype");
+}
+
+
+MatrixDtype parse_dtype(const std::string& name) {
+    for (MatrixDtype dtype : {MatrixDtype::Float64, MatrixDtype::Float32, MatrixDtype::UInt16}) {
+        if (dtype_name(dtype) == name) {
+            return dtype;
+        }
+    }
+    throw std::invalid_argument("Unknown matrix dtype: " + name + " (expected f64, f32 or u16)");
+}
+
+
+/**
+ * @brief Symmetrize the matrix and pack its upper triangle row by row
+ *
+ * The heat method distances are not exactly symmetric, so the smaller value of (i, j) and (j, i) is used.
+*/
+std::vector<double> pack_symmetric_upper(const RowMajorMatrixXd& matrix) {
+    if (matrix.rows() != matrix.cols()) {
+        throw std::invalid_argument("Only square matrices can be packed as symmetric matrix");
+    }
+
+    const int64_t n = matrix.rows();
+    std::vector<double> values(packed_upper_size(n));
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t i = 0; i < n; ++i) {
+        for (int64_t j = i; j < n; ++j) {
+            values[packed_upper_index(i, j, n)] = std::min(matrix(i, j), matrix(j, i));
+        }
+    }
+
+    return values;
+}
+
+
+/**
+ * @brief Build a symmetric CSR matrix out of the (possibly asymmetric) sparse rows
+ *
+ * Same minimum rule as for the dense matrix: an entry that exists in only one direction is kept for both directions.
+*/
+SparseMatrixCSR symmetric_csr_from_rows(const std::vector<SparseRow>& rows) {
+    const int64_t n = rows.size();
+
+    // Mirror every entry into the row of its column
+    std::vector<SparseRow> merged_rows(n);
+    for (int64_t i = 0; i < n; ++i) {
+        for (const auto& [col, value] : rows[i]) {
+            if (col < 0 || col >= n) {
+                throw std::invalid_argument("The sparse column index is out of range");
+            }
+            merged_rows[i].emplace_back(col, value);
+            if (col != i) {
+                merged_rows[col].emplace_back(static_cast<int32_t>(i), value);
+            }
+        }
+    }
+
+    // Sort each row by column and keep the minimum of duplicated entries
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t i = 0; i < n; ++i) {
+        SparseRow& row = merged_rows[i];
+        std::sort(row.begin(), row.end());
+
+        // The pairs are sorted by value within the same column, so unique keeps the smaller one
+        auto last = std::unique(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first == b.first; });
+        row.erase(last, row.end());
+    }
+
+    SparseMatrixCSR matrix;
+    matrix.rows = n;
+    matrix.row_offsets.resize(n + 1, 0);
+    for (int64_t i = 0; i < n; ++i) {
+        matrix.row_offsets[i + 1] = matrix.row_offsets[i] + merged_rows[i].size();
+    }
+
+    matrix.col_indices.resize(matrix.row_offsets[n]);
+    matrix.values.resize(matrix.row_offsets[n]);
+    for (int64_t i = 0; i < n; ++i) {
+        int64_t index = matrix.row_offsets[i];
+        for (const auto& [col, value] : merged_rows[i]) {
+            matrix.col_indices[index] = col;
+            matrix.values[index] = value;
+            ++index;
+        }
+    }
+
+    return matrix;
+}
+
+
+/**
+ * @brief Keep only the entries of the square matrix, which are within the cutoff, as symmetric CSR matrix
+*/
+SparseMatrixCSR truncate_symmetric(const RowMajorMatrixXd& matrix, double cutoff) {
+    if (matrix.rows() != matrix.cols()) {
+        throw std::invalid_argument("Only square matrices can be truncated as symmetric matrix");
+    }
+
+    std::vector<SparseRow> rows(matrix.rows());
+    for (int64_t i = 0; i < matrix.rows(); ++i) {
+        for (int64_t j = 0; j < matrix.cols(); ++j) {
+            if (matrix(i, j) <= cutoff) {
+                rows[i].emplace_back(static_cast<int32_t>(j), matrix(i, j));
+            }
+        }
+    }
+
+    return symmetric_csr_from_rows(rows);
+}
+
+
+/**
+ * @brief Step size of the quantized values, so that the largest value maps onto the largest uint16
+*/
+double quantization_scale(const std::vector<double>& values, MatrixDtype dtype) {
+    if (dtype != MatrixDtype::UInt16 || values.empty()) {
+        return 1.0;
+    }
+
+    auto [min_value, max_value] = std::minmax_element(values.begin(), values.end());
+    if (*min_value < 0 || !std::isfinite(*max_value)) {
+        throw std::invalid_argument("Only finite, non-negative matrices can be quantized to uint16");
+    }
+
+    return *max_value > 0 ? *max_value / std::numeric_limits<uint16_t>::max() : 1.0;
+}
+
+
+/**
+ * @brief Write the values with the given precision into the output buffer
+*/
+void encode_values(
+    const std::vector<double>& values,
+    MatrixDtype dtype,
+    double scale,
+    char* output
+){
+    const size_t size = values.size();
+
+    switch (dtype) {
+        case MatrixDtype::Float64:
+            std::memcpy(output, values.data(), size * sizeof(double));
+            break;
+        case MatrixDtype::Float32: {
+            float* encoded = reinterpret_cast<float*>(output);
+            for (size_t i = 0; i < size; ++i) {
+                encoded[i] = static_cast<float>(values[i]);
+            }
+            break;
+        }
+        case MatrixDtype::UInt16: {
+            uint16_t* encoded = reinterpret_cast<uint16_t*>(output);
+            for (size_t i = 0; i < size; ++i) {
+                encoded[i] = static_cast<uint16_t>(std::lround(values[i] / scale));
+            }
+            break;
+        }
+    }
+}
+
+
+size_t sparse_payload_bytes(const SparseMatrixCSR& matrix, MatrixDtype dtype) {
+    return sparse_values_offset(matrix.rows, matrix.values.size()) + matrix.values.size() * dtype_size(dtype);
+}
+
+
+/**
+ * @brief Write the row offsets, the column indices and the values with the given precision into the output buffer
+*/
+void encode_sparse_matrix(
+    const SparseMatrixCSR& matrix,
+    MatrixDtype dtype,
+    double scale,
+    char* output
+){
+    const size_t offsets_bytes = matrix.row_offsets.size() * sizeof(int64_t);
+    const size_t values_offset = sparse_values_offset(matrix.rows, matrix.values.size());
+
+    std::memcpy(output, matrix.row_offsets.data(), offsets_bytes);
+    std::memcpy(output + offsets_bytes, matrix.col_indices.data(), matrix.col_indices.size() * sizeof(int32_t));
+
+    // Zero the alignment padding in front of the values
+    const size_t indices_end = offsets_bytes + matrix.col_indices.size() * sizeof(int32_t);
+    std::memset(output + indices_end, 0, values_offset - indices_end);
+
+    encode_values(matrix.values, dtype, scale, output + values_offset);
+}
+
+
+/**
+ * @brief 64 bit FNV-1a hash of the file content, used to detect a cache file that belongs to another mesh
+*/
+uint64_t file_checksum(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for the checksum: " + path);
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    std::vector<char> buffer(1 << 16);
+
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        for (std::streamsize i = 0; i < file.gcount(); ++i) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+
+static BinaryMatrixHeader make_header(
+    MatrixLayout layout,
+    MatrixDtype dtype,
+    int64_t rows,
+    int64_t nonzeros,
+    uint64_t mesh_checksum
+){
+    BinaryMatrixHeader header{};
+    std::memcpy(header.magic, BINARY_MATRIX_MAGIC, sizeof(header.magic));
+    header.version = BINARY_MATRIX_VERSION;
+    header.dtype = static_cast<uint32_t>(dtype);
+    header.layout = static_cast<uint32_t>(layout);
+    header.rows = rows;
+    header.cols = rows;
+    header.nonzeros = nonzeros;
+    header.mesh_checksum = mesh_checksum;
+
+    return header;
+}
+
+
+static void write_binary_matrix(
+    const std::string& path,
+    const BinaryMatrixHeader& header,
+    const std::function<void(std::ofstream&)>& write_payload
+){
+    // Concurrent jobs with the same cache root must never see a half written file
+    const std::string temporary_path = temporary_cache_path(path);
+
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + temporary_path);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_payload(file);
+    file.close();
+
+    if (!file.good()) {
+        throw std::runtime_error("Failed to write the binary matrix: " + temporary_path);
+    }
+    commit_cache_file(temporary_path, path);
+}
+
+
+/**
+ * @brief Same scale as quantization_scale of the packed values, without packing them
+*/
+static double packed_quantization_scale(const RowMajorMatrixXd& matrix, MatrixDtype dtype) {
+    const int64_t n = matrix.rows();
+    if (dtype != MatrixDtype::UInt16 || n == 0) {
+        return 1.0;
+    }
+
+    double min_value = std::numeric_limits<double>::infinity();
+    double max_value = -std::numeric_limits<double>::infinity();
+
+    #pragma omp parallel for schedule(dynamic, 64) reduction(min:min_value) reduction(max:max_value)
+    for (int64_t i = 0; i < n; ++i) {
+        for (int64_t j = i; j < n; ++j) {
+            const double value = std::min(matrix(i, j), matrix(j, i));
+            min_value = std::min(min_value, value);
+            max_value = std::max(max_value, value);
+        }
+    }
+
+    if (min_value < 0 || !std::isfinite(max_value)) {
+        throw std::invalid_argument("Only finite, non-negative matrices can be quantized to uint16");
+    }
+
+    return max_value > 0 ? max_value / std::numeric_limits<uint16_t>::max() : 1.0;
+}
+
+
+// Values per chunk of the streamed packed upper triangle, 4 MB at f64
+static constexpr int64_t PACKED_CHUNK_VALUES = 1 << 19;
+
+
+/**
+ * @brief Stream the packed upper triangle with the minimum rule and the dtype encoding into the file
+ *
+ * Only a chunk of rows gets encoded at a time, so the save needs no second copy of the V×V matrix.
+*/
+static void write_packed_upper(std::ofstream& file, const RowMajorMatrixXd& matrix, MatrixDtype dtype, double scale) {
+    const int64_t n = matrix.rows();
+    const size_t value_bytes = dtype_size(dtype);
+    std::vector<char> chunk;
+
+    int64_t begin = 0;
+    while (begin < n) {
+        // Rows until the chunk holds about PACKED_CHUNK_VALUES values, but at least one row
+        int64_t end = begin + 1;
+        while (end < n && packed_upper_index(end, n - 1, n) + 1 - packed_upper_index(begin, begin, n) < PACKED_CHUNK_VALUES) {
+            ++end;
+        }
+        const int64_t chunk_start = packed_upper_index(begin, begin, n);
+        const int64_t chunk_values = (end < n ? packed_upper_index(end, end, n) : packed_upper_size(n)) - chunk_start;
+        chunk.resize(chunk_values * value_bytes);
+
+        #pragma omp parallel
+        {
+            std::vector<double> row;
+
+            #pragma omp for schedule(dynamic, 16)
+            for (int64_t i = begin; i < end; ++i) {
+                row.resize(n - i);
+                for (int64_t j = i; j < n; ++j) {
+                    row[j - i] = std::min(matrix(i, j), matrix(j, i));
+                }
+                encode_values(row, dtype, scale, chunk.data() + (packed_upper_index(i, i, n) - chunk_start) * value_bytes);
+            }
+        }
+
+        file.write(chunk.data(), chunk.size());
+        begin = end;
+    }
+}
+
+
+void save_binary_matrix(
+    const std::string& path,
+    const RowMajorMatrixXd& matrix,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype
+){
+    if (matrix.rows() != matrix.cols()) {
+        throw std::invalid_argument("Only square matrices can be packed as symmetric matrix");
+    }
+
+    const int64_t num_values = packed_upper_size(matrix.rows());
+
+    BinaryMatrixHeader header = make_header(MatrixLayout::PackedUpper, dtype, matrix.rows(), num_values, mesh_checksum);
+    header.payload_bytes = num_values * dtype_size(dtype);
+    header.scale = packed_quantization_scale(matrix, dtype);
+    header.cutoff = std::numeric_limits<double>::infinity();
+
+    write_binary_matrix(path, header, [&](std::ofstream& file) {
+        write_packed_upper(file, matrix, dtype, header.scale);
+    });
+}
+
+
+/**
+ * @brief Save the symmetric sparse matrix, the missing entries are beyond the given cutoff
+*/
+void save_sparse_binary_matrix(
+    const std::string& path,
+    const SparseMatrixCSR& matrix,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype,
+    double cutoff
+){
+    BinaryMatrixHeader header = make_header(MatrixLayout::SparseCSR, dtype, matrix.rows, matrix.values.size(), mesh_checksum);
+    header.payload_bytes = sparse_payload_bytes(matrix, dtype);
+    header.scale = quantization_scale(matrix.values, dtype);
+    header.cutoff = cutoff;
+
+    std::vector<char> payload(header.payload_bytes);
+    encode_sparse_matrix(matrix, dtype, header.scale, payload.data());
+
+    write_binary_matrix(path, header, [&](std::ofstream& file) {
+        file.write(payload.data(), payload.size());
+    });
+}
+
+
+bool read_binary_matrix_header(
+    const std::string& path,
+    BinaryMatrixHeader& header
+){
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    return file.gcount() == sizeof(header) && std::memcmp(header.magic, BINARY_MATRIX_MAGIC, sizeof(header.magic)) == 0;
+}
+
+
+/**
+ * @brief Check if the cache file exists, has the current format version, the requested dtype and cutoff and belongs to the given mesh
+*/
+bool is_valid_binary_matrix(
+    const std::string& path,
+    uint64_t mesh_checksum,
+    MatrixDtype dtype,
+    double cutoff
+){
+    BinaryMatrixHeader header;
+    if (!read_binary_matrix_header(path, header)) {
+        return false;
+    }
+
+    return header.version == BINARY_MATRIX_VERSION && header.mesh_checksum == mesh_checksum && header.dtype == static_cast<uint32_t>(dtype)
+        && header.cutoff == cutoff;
+}
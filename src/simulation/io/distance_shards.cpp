@@ -0,0 +1,99 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Merge of the distance matrix shards into the cache file.
+The shards are the checkpoints of compute_distance_shard, the merge only needs their files and the shape of the matrix,
+so it works without the mesh and the heat method.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <io/distance_shards.h>
+
+namespace fs = boost::filesystem;
+
+
+/**
+ * @brief Write the distance matrix out of the rows into the cache file, with the packed layout without a cutoff
+*/
+void save_distance_rows(const std::string& distance_matrix_path, DenseRowStore& store, uint64_t mesh_checksum, MatrixDtype dtype, double){
+    std::cout << "Saving distance matrix to file..." << std::endl;
+    save_binary_matrix(distance_matrix_path, store.matrix, mesh_checksum, dtype);
+}
+
+void save_distance_rows(const std::string& distance_matrix_path, SparseRowStore& store, uint64_t mesh_checksum, MatrixDtype dtype, double cutoff){
+    auto distance_matrix_v = symmetric_csr_from_rows(store.rows);
+
+    std::cout << "Saving " << distance_matrix_v.values.size() << " distances within the cutoff " << cutoff << " to file..." << std::endl;
+    save_sparse_binary_matrix(distance_matrix_path, distance_matrix_v, mesh_checksum, dtype, cutoff);
+}
+
+
+std::string get_distance_shard_path(const std::string distance_matrix_path, int shard, int num_shards){
+    return distance_matrix_path + ".shard-" + std::to_string(shard) + "-of-" + std::to_string(num_shards);
+}
+
+
+/**
+ * @brief Assemble the cache file out of all shards
+ *
+ * Every shard has to be complete, otherwise nothing gets written and the missing blocks get reported.
+ * The shards get removed once the cache file is written.
+*/
+template <typename RowStore>
+static void merge_shards(const std::string& distance_matrix_path, uint64_t mesh_checksum, int num_vertices, int num_shards, RowStore& store, MatrixDtype dtype, double cutoff, int checkpoint_rows){
+    std::vector<std::string> shard_paths;
+    for (int shard = 0; shard < num_shards; ++shard) {
+        shard_paths.push_back(get_distance_shard_path(distance_matrix_path, shard, num_shards));
+        if (!fs::exists(shard_paths.back())) {
+            throw std::runtime_error("Missing shard " + std::to_string(shard) + " of " + std::to_string(num_shards) + ": " + shard_paths.back());
+        }
+    }
+
+    std::vector<std::unique_ptr<RowCheckpoint>> shards;
+    for (int shard = 0; shard < num_shards; ++shard) {
+        // A shard of another mesh or checkpoint size throws here instead of being discarded
+        RowCheckpoint& checkpoint = *shards.emplace_back(RowCheckpoint::open_existing(shard_paths[shard], mesh_checksum, num_vertices, num_vertices, checkpoint_rows));
+
+        std::vector<int> block_ids = checkpoint.shard_blocks(shard, num_shards);
+        int missing_blocks = std::count_if(block_ids.begin(), block_ids.end(), [&](int block_id) { return !checkpoint.is_complete(block_id); });
+
+        if (missing_blocks > 0) {
+            throw std::runtime_error("Shard " + std::to_string(shard) + " of " + std::to_string(num_shards) + " is incomplete, "
+                                     + std::to_string(missing_blocks) + " of " + std::to_string(block_ids.size()) + " blocks are missing");
+        }
+        load_checkpointed_rows(checkpoint, block_ids, store);
+    }
+
+    save_distance_rows(distance_matrix_path, store, mesh_checksum, dtype, cutoff);
+    for (auto& checkpoint : shards) {
+        checkpoint->remove();
+    }
+    std::cout << "saved" << std::endl;
+}
+
+
+void merge_distance_shard_files(const std::string& distance_matrix_path, uint64_t mesh_checksum, int num_vertices, int num_shards, MatrixDtype dtype, double cutoff, int checkpoint_rows){
+    if (num_shards <= 0) {
+        throw std::invalid_argument("The distance matrix needs at least one shard");
+    }
+
+    if (std::isinf(cutoff)) {
+        DenseRowStore store(num_vertices);
+        merge_shards(distance_matrix_path, mesh_checksum, num_vertices, num_shards, store, dtype, cutoff, checkpoint_rows);
+    }
+    else {
+        SparseRowStore store(num_vertices, cutoff);
+        merge_shards(distance_matrix_path, mesh_checksum, num_vertices, num_shards, store, dtype, cutoff, checkpoint_rows);
+    }
+}
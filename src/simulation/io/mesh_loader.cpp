@@ -6,6 +6,8 @@
 #include <iostream>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <Eigen/Dense>
@@ -17,55 +19,28 @@
 #include <utilities/sim_structs.h>
 
 
-void loadMeshVertices(std::string filepath, Eigen::MatrixXd& vertices) {
-    // Create an instance of the Importer class
+/**
+ * @brief Read the vertices and the faces of the mesh with a single import
+*/
+void import_mesh(const std::string& filepath, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces) {
     Assimp::Importer importer;
-
-    // Load the 3D model
-    // We pass several post-processing flags to this function, including aiProcess_Triangulate to convert all the geometry to triangles,
-    // aiProcess_FlipUVs to flip the texture coordinates along the y-axis, and aiProcess_GenNormals to generate normals if they are not present in the model.
     const aiScene* scene = importer.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
 
-    if (!scene) {
-        std::cerr << "Failed to load model: " << filepath << std::endl;
+    if (!scene || scene->mNumMeshes == 0) {
+        throw std::runtime_error("Failed to load model: " + filepath);
     }
 
-    // Get the first mesh in the scene
     const aiMesh* mesh = scene->mMeshes[0];
 
-    // Resize the Eigen matrix to store the vertices coordinates
     vertices.resize(mesh->mNumVertices, 3);
-
-    // Copy the vertices coordinates from the mesh to the Eigen matrix
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         const aiVector3D& vertex = mesh->mVertices[i];
         vertices(i, 0) = vertex.x;
         vertices(i, 1) = vertex.y;
         vertices(i, 2) = vertex.z;
     }
-}
-
-
-void loadMeshFaces(std::string filepath, Eigen::MatrixXi& faces) {
-    // Create an instance of the Importer class
-    Assimp::Importer importer;
-
-    // Load the 3D model
-    // We pass several post-processing flags to this function, including aiProcess_Triangulate to convert all the geometry to triangles,
-    // aiProcess_FlipUVs to flip the texture coordinates along the y-axis, and aiProcess_GenNormals to generate normals if they are not present in the model
-    const aiScene* scene = importer.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
-
-    if (!scene) {
-        std::cerr << "Failed to load model: " << filepath << std::endl;
-    }
-
-    // Get the first mesh in the scene
-    const aiMesh* mesh = scene->mMeshes[0];
 
-    // Resize the Eigen matrix to store the face indices
     faces.resize(mesh->mNumFaces, 3);
-
-    // Copy the face indices from the mesh to the Eigen matrix
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
         const aiFace& face = mesh->mFaces[i];
         if (face.mNumIndices == 3) {
@@ -77,8 +52,35 @@ void loadMeshFaces(std::string filepath, Eigen::MatrixXi& faces) {
 }
 
 
+/**
+ * @brief Only the vertices of the mesh, the faces of the import get dropped
+*/
+void loadMeshVertices(std::string filepath, Eigen::MatrixXd& vertices) {
+    Eigen::MatrixXi faces;
+    import_mesh(filepath, vertices, faces);
+}
+
+
+/**
+ * @brief Only the faces of the mesh, the vertices of the import get dropped
+*/
+void loadMeshFaces(std::string filepath, Eigen::MatrixXi& faces) {
+    Eigen::MatrixXd vertices;
+    import_mesh(filepath, vertices, faces);
+}
+
+
+/**
+ * @brief Shared view of the mesh, which gets parsed only on the first request in this process
+*/
+std::shared_ptr<const MeshAsset> load_mesh(const std::string& filepath) {
+    static MeshRegistry registry(import_mesh);
+    return registry.get(filepath);
+}
+
+
 std::pair<Eigen::MatrixXd, std::vector<int64_t>> get_mesh_data(
-    std::unordered_map<int, Mesh_UV_Struct> mesh_dict,
+    const std::unordered_map<int, Mesh_UV_Struct>& mesh_dict,
     int mesh_id
 ){
     Eigen::MatrixXd halfedges_uv;
@@ -0,0 +1,85 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#include <io/mesh_registry.h>
+
+// boost::filesystem only reports whole seconds, which would miss a UV mesh rewritten within the same second
+namespace fs = std::filesystem;
+
+
+MeshRegistry::MeshRegistry(MeshFileLoader loader) : loader(std::move(loader)) {}
+
+
+std::shared_ptr<const MeshAsset> MeshRegistry::get(const std::string& path){
+    if (!fs::exists(path)) {
+        throw std::runtime_error("Mesh file not found: " + path);
+    }
+
+    const std::string key = fs::canonical(path).string();
+    const uintmax_t file_size = fs::file_size(key);
+    const fs::file_time_type write_time = fs::last_write_time(key);
+
+    std::promise<std::shared_ptr<const MeshAsset>> parsed;
+    std::shared_future<std::shared_ptr<const MeshAsset>> mesh;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = meshes.find(key);
+        if (it != meshes.end() && it->second.file_size == file_size && it->second.write_time == write_time) {
+            mesh = it->second.mesh;
+        }
+        else {
+            meshes[key] = Entry{file_size, write_time, parsed.get_future().share()};
+        }
+    }
+
+    // Another caller parses (or already parsed) this version of the file, so only wait for its result
+    if (mesh.valid()) {
+        return mesh.get();
+    }
+
+    // Parse outside of the lock, so that the other files can get loaded in parallel
+    try {
+        auto asset = std::make_shared<MeshAsset>();
+        loader(key, asset->vertices, asset->faces);
+        ++num_parsed;
+        parsed.set_value(asset);
+        return asset;
+    }
+    catch (...) {
+        parsed.set_exception(std::current_exception());
+
+        // Drop the failed parse, so that the next request tries again
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = meshes.find(key);
+        if (it != meshes.end() && it->second.file_size == file_size && it->second.write_time == write_time) {
+            meshes.erase(it);
+        }
+        throw;
+    }
+}
+
+
+size_t MeshRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return meshes.size();
+}
+
+
+int64_t MeshRegistry::parsed_files() const {
+    return num_parsed;
+}
+
+
+// Views handed out before stay valid, the registry only drops its own reference
+void MeshRegistry::clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    meshes.clear();
+}
@@ -0,0 +1,118 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-25
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Content addressed cache for the precomputed artifacts of a mesh (distance matrix, UV mesh).
+The file name contains a hash of the mesh content and of all parameters, which change the artifact.
+Therefore a re-exported mesh with the same name or a second job with another parameter set never reuses stale data.
+Files get written under a temporary name and renamed afterwards, so concurrent jobs never see a half written file.
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <unistd.h>
+
+#include <io/binary_matrix.h>
+#include <io/precompute_cache.h>
+
+namespace fs = boost::filesystem;
+
+
+/**
+ * @brief Cache root directory: the given one, else the environment variable, else the data folder of the project
+*/
+std::string get_cache_root(const std::string& cache_root) {
+    if (!cache_root.empty()) {
+        return cache_root;
+    }
+
+    const char* environment_root = std::getenv(CACHE_ROOT_ENV);
+    if (environment_root != nullptr && environment_root[0] != '\0') {
+        return environment_root;
+    }
+
+    return (fs::path(PROJECT_SOURCE_DIR) / "meshes" / "data").string();
+}
+
+
+/**
+ * @brief 64 bit FNV-1a hash of the mesh checksum, the artifact kind and its parameters
+*/
+uint64_t cache_key(uint64_t mesh_checksum, const std::string& kind, const std::string& parameters) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto add_byte = [&hash](unsigned char byte) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    };
+
+    for (int i = 0; i < 8; ++i) {
+        add_byte(static_cast<unsigned char>(mesh_checksum >> (8 * i)));
+    }
+    for (char c : kind + '\0' + parameters) {
+        add_byte(static_cast<unsigned char>(c));
+    }
+
+    return hash;
+}
+
+
+/**
+ * @brief Path of a cached artifact of the mesh, e.g. <root>/ellipsoid_x4_distance_matrix_3f2a....bin
+ *
+ * The mesh name only keeps the file readable, the hash decides which file belongs to which mesh and parameters.
+*/
+std::string get_cache_path(
+    const std::string& mesh_path,
+    const std::string& kind,
+    const std::string& parameters,
+    const std::string& extension,
+    const std::string& cache_root
+){
+    fs::path root = get_cache_root(cache_root);
+    fs::create_directories(root);
+
+    std::ostringstream file_name;
+    file_name << fs::path(mesh_path).stem().string() << "_" << kind << "_"
+              << std::hex << std::setw(16) << std::setfill('0') << cache_key(file_checksum(mesh_path), kind, parameters)
+              << extension;
+
+    return (root / file_name.str()).string();
+}
+
+
+/**
+ * @brief Host name of this node, so that jobs on different nodes sharing a cache directory write different files
+*/
+static std::string host_name() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "unknown_host";
+    }
+    return name;
+}
+
+
+/**
+ * @brief Unique temporary file next to the final path, so that the rename stays on the same file system
+ *
+ * The process ids of jobs on different nodes collide, therefore the name holds the host name and a random part.
+*/
+std::string temporary_cache_path(const std::string& path) {
+    static const std::string host = host_name();
+
+    return path + ".tmp." + host + "." + fs::unique_path("%%%%-%%%%-%%%%-%%%%").string();
+}
+
+
+/**
+ * @brief Atomically replace the cache file with the completely written temporary file
+*/
+void commit_cache_file(const std::string& temporary_path, const std::string& path) {
+    fs::rename(temporary_path, path);
+}
@@ -0,0 +1,383 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Checkpoint directory layout:
+- <directory>.lock: next to the directory, so that it outlives the removal of the checkpoint; held with flock
+- manifest.txt: header line with key and shape, followed by one "block <id>" line per completed block
+- block_<id>.bin: the rows of the block, each row as uint32 entry count followed by its entries.
+  A complete row stores only its values, a truncated row stores (int32 column, double value) pairs.
+Block files get synced and renamed into place before they are added to the manifest, so a listed block is always complete.
+Every manifest line gets synced as well, so a completed block survives a crash of the machine and not only of the process.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <io/precompute_cache.h>
+#include <io/row_checkpoint.h>
+
+namespace fs = boost::filesystem;
+
+
+/**
+ * @brief Flush the written file from the page cache to the disk
+*/
+static void sync_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open the file for syncing: " + path);
+    }
+
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+
+    if (!synced) {
+        throw std::runtime_error("Failed to sync the file: " + path);
+    }
+}
+
+
+/**
+ * @brief Take the exclusive lock of the checkpoint directory and wait for it, if another job holds it
+ *
+ * The lock belongs to the open file, so it also gets released, when the job gets killed.
+*/
+static int lock_checkpoint(const std::string& directory) {
+    const std::string lock_path = directory + ".lock";
+    int fd = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open the checkpoint lock: " + lock_path);
+    }
+
+    bool locked = flock(fd, LOCK_EX | LOCK_NB) == 0;
+    if (!locked && errno == EWOULDBLOCK) {
+        std::cout << "Waiting for another job on the checkpoint " << directory << std::endl;
+        locked = flock(fd, LOCK_EX) == 0;
+    }
+    if (!locked) {
+        close(fd);
+        throw std::runtime_error("Failed to lock the checkpoint: " + lock_path);
+    }
+
+    return fd;
+}
+
+
+RowCheckpoint::RowCheckpoint(
+    const std::string& directory,
+    uint64_t key,
+    int num_rows,
+    int num_cols,
+    int block_rows
+) :
+    RowCheckpoint(directory, key, num_rows, num_cols, block_rows, false)
+{}
+
+
+/**
+ * @brief Open the checkpoint without ever discarding it
+ *
+ * A missing checkpoint or one of another precomputation throws, so e.g. a merge with different options keeps the blocks.
+*/
+std::unique_ptr<RowCheckpoint> RowCheckpoint::open_existing(
+    const std::string& directory,
+    uint64_t key,
+    int num_rows,
+    int num_cols,
+    int block_rows
+) {
+    return std::unique_ptr<RowCheckpoint>(new RowCheckpoint(directory, key, num_rows, num_cols, block_rows, true));
+}
+
+
+RowCheckpoint::RowCheckpoint(
+    const std::string& directory,
+    uint64_t key,
+    int num_rows,
+    int num_cols,
+    int block_rows,
+    bool read_only
+) :
+    directory(directory),
+    key(key),
+    num_rows(num_rows),
+    num_cols(num_cols),
+    block_rows(block_rows),
+    read_only(read_only)
+{
+    if (block_rows <= 0) {
+        throw std::invalid_argument("The checkpoint needs at least one row per block");
+    }
+
+    // The lock file lives in the parent directory, a missing read-only checkpoint gets reported below instead
+    if (!read_only) {
+        if (fs::path(directory).has_parent_path()) {
+            fs::create_directories(fs::path(directory).parent_path());
+        }
+        lock_file = lock_checkpoint(directory);
+    }
+    else if (fs::exists(directory)) {
+        lock_file = lock_checkpoint(directory);
+    }
+
+    // A throwing constructor never reaches the destructor, so the lock has to be released here
+    try {
+        // The job before might have removed the directory, while this one waited for the lock
+        if (!read_only) {
+            fs::create_directories(directory);
+        }
+        load_manifest();
+    }
+    catch (...) {
+        if (lock_file >= 0) {
+            close(lock_file);
+        }
+        throw;
+    }
+}
+
+
+/**
+ * @brief Resume the completed blocks of the manifest, or start a new checkpoint, if it belongs to another precomputation
+*/
+void RowCheckpoint::load_manifest() {
+    // Resume from an existing manifest, but only if it belongs to the same precomputation
+    std::ifstream manifest(manifest_path());
+    std::string header;
+    if (manifest.is_open() && std::getline(manifest, header) && header == manifest_header()) {
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::istringstream entry(line);
+            std::string tag;
+            int block_id;
+
+            // A line, which got cut off by an interruption, is ignored
+            if (entry >> tag >> block_id && tag == "block" && block_id >= 0 && block_id < num_blocks() && fs::exists(block_path(block_id))) {
+                completed_block_ids.insert(block_id);
+            }
+        }
+        return;
+    }
+    manifest.close();
+
+    if (read_only) {
+        if (!fs::exists(manifest_path())) {
+            throw std::runtime_error("Missing checkpoint manifest: " + manifest_path());
+        }
+        throw std::runtime_error("The checkpoint " + directory + " belongs to another precomputation, expected \"" + manifest_header()
+                                 + "\" but found \"" + header + "\"");
+    }
+
+    // Start a new checkpoint
+    for (fs::directory_iterator it(directory), end; it != end; ++it) {
+        fs::remove_all(it->path());
+    }
+    std::ofstream(manifest_path()) << manifest_header() << '\n';
+}
+
+
+RowCheckpoint::~RowCheckpoint() {
+    if (lock_file >= 0) {
+        close(lock_file);
+    }
+}
+
+
+int RowCheckpoint::block_size(int block_id) const {
+    return std::min(block_rows, num_rows - block_start(block_id));
+}
+
+
+bool RowCheckpoint::is_complete(int block_id) const {
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+    return completed_block_ids.count(block_id) > 0;
+}
+
+
+std::vector<int> RowCheckpoint::pending_blocks() const {
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+
+    std::vector<int> pending;
+    for (int block_id = 0; block_id < num_blocks(); ++block_id) {
+        if (completed_block_ids.count(block_id) == 0) {
+            pending.push_back(block_id);
+        }
+    }
+    return pending;
+}
+
+
+std::vector<int> RowCheckpoint::completed_blocks() const {
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+    return std::vector<int>(completed_block_ids.begin(), completed_block_ids.end());
+}
+
+
+/**
+ * @brief Blocks of shard k of n, the shards split the blocks into contiguous ranges of nearly equal size
+*/
+std::vector<int> RowCheckpoint::shard_blocks(int shard, int num_shards) const {
+    if (num_shards <= 0 || shard < 0 || shard >= num_shards) {
+        throw std::invalid_argument("The shard is not in the range of the shards");
+    }
+
+    const int64_t first_block = static_cast<int64_t>(num_blocks()) * shard / num_shards;
+    const int64_t last_block = static_cast<int64_t>(num_blocks()) * (shard + 1) / num_shards;
+
+    std::vector<int> block_ids;
+    for (int64_t block_id = first_block; block_id < last_block; ++block_id) {
+        block_ids.push_back(block_id);
+    }
+    return block_ids;
+}
+
+
+/**
+ * @brief Write the rows of the block and record the block in the manifest, can be called concurrently for different blocks
+*/
+void RowCheckpoint::save_block(int block_id, const std::vector<SparseRow>& rows) {
+    if (static_cast<int>(rows.size()) != block_size(block_id)) {
+        throw std::invalid_argument("The number of rows does not match the checkpoint block");
+    }
+
+    write_block(block_id, [&](std::ofstream& file) {
+        for (const SparseRow& row : rows) {
+            const uint32_t count = row.size();
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+            if (static_cast<int>(count) == num_cols) {
+                for (const auto& [col, value] : row) {
+                    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+                }
+            }
+            else {
+                for (const auto& [col, value] : row) {
+                    file.write(reinterpret_cast<const char*>(&col), sizeof(col));
+                    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+                }
+            }
+        }
+    });
+}
+
+
+/**
+ * @brief Write complete rows without converting them into column value pairs first
+*/
+void RowCheckpoint::save_block(int block_id, const Eigen::Ref<const RowMajorMatrixXd>& rows) {
+    if (rows.rows() != block_size(block_id) || rows.cols() != num_cols) {
+        throw std::invalid_argument("The shape of the rows does not match the checkpoint block");
+    }
+
+    write_block(block_id, [&](std::ofstream& file) {
+        const uint32_t count = num_cols;
+        for (Eigen::Index row = 0; row < rows.rows(); ++row) {
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            file.write(reinterpret_cast<const char*>(rows.row(row).data()), sizeof(double) * num_cols);
+        }
+    });
+}
+
+
+void RowCheckpoint::write_block(int block_id, const std::function<void(std::ofstream&)>& write_rows) {
+    if (read_only) {
+        throw std::logic_error("The checkpoint is opened read-only: " + directory);
+    }
+
+    const std::string path = block_path(block_id);
+    const std::string temporary_path = temporary_cache_path(path);
+
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    write_rows(file);
+    file.close();
+
+    if (!file.good()) {
+        throw std::runtime_error("Failed to write the checkpoint block: " + path);
+    }
+    sync_file(temporary_path);
+    commit_cache_file(temporary_path, path);
+
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+    std::ofstream manifest(manifest_path(), std::ios::app);
+    manifest << "block " << block_id << '\n';
+    manifest.close();
+
+    if (!manifest.good()) {
+        throw std::runtime_error("Failed to record the checkpoint block in the manifest: " + manifest_path());
+    }
+    sync_file(manifest_path());
+    completed_block_ids.insert(block_id);
+}
+
+
+std::vector<SparseRow> RowCheckpoint::load_block(int block_id) const {
+    std::ifstream file(block_path(block_id), std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Missing checkpoint block: " + block_path(block_id));
+    }
+
+    std::vector<SparseRow> rows(block_size(block_id));
+    for (SparseRow& row : rows) {
+        uint32_t count = 0;
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        row.resize(count);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            if (static_cast<int>(count) == num_cols) {
+                row[i].first = i;
+            }
+            else {
+                file.read(reinterpret_cast<char*>(&row[i].first), sizeof(int32_t));
+            }
+            file.read(reinterpret_cast<char*>(&row[i].second), sizeof(double));
+        }
+    }
+
+    if (!file.good()) {
+        throw std::runtime_error("The checkpoint block is truncated: " + block_path(block_id));
+    }
+    return rows;
+}
+
+
+/**
+ * @brief Delete the checkpoint, once the final result got saved
+*/
+void RowCheckpoint::remove() {
+    std::lock_guard<std::mutex> lock(manifest_mutex);
+    fs::remove_all(directory);
+    completed_block_ids.clear();
+}
+
+
+std::string RowCheckpoint::block_path(int block_id) const {
+    return (fs::path(directory) / ("block_" + std::to_string(block_id) + ".bin")).string();
+}
+
+
+std::string RowCheckpoint::manifest_path() const {
+    return (fs::path(directory) / "manifest.txt").string();
+}
+
+
+std::string RowCheckpoint::manifest_header() const {
+    std::ostringstream header;
+    header << "key " << std::hex << key << std::dec << " rows " << num_rows << " cols " << num_cols << " block_rows " << block_rows;
+    return header.str();
+}
@@ -19,6 +19,7 @@
 * In this file we want to collect the different types of Cell-Cell Information Fluxes that we want to simulate.
 */
 
+#include <cstddef>
 #include <Eigen/Dense>
 
 #include <particle_simulation/cell_cell_interactions.h>
@@ -54,3 +55,179 @@ Eigen::Vector2d repulsive_adhesion_motion(
 
     return Fij * (dist_v / dist);
 }
+
+
+/**
+ * @brief Same force law as repulsive_adhesion_motion for the pairs from begin to end, branch-free for the autovectorizer
+*/
+static void repulsive_adhesion_motion_scalar(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    const double* dist,
+    const double* dx,
+    const double* dy,
+    double* fx,
+    double* fy,
+    size_t begin,
+    size_t end
+) {
+    for (size_t p = begin; p < end; ++p) {
+        const double d = dist[p];
+        const double Fij_rep = (-k * (2 * σ - d)) / (2 * σ);
+        const double Fij_adh = (k_adh * (2 * σ - d)) / (2 * σ - r_adh);
+        const double Fij = d < 2 * σ ? Fij_rep : (d <= r_adh ? Fij_adh : 0.0);
+
+        fx[p] = Fij * (dx[p] / d);
+        fy[p] = Fij * (dy[p] / d);
+    }
+}
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TISSUE_X86_SIMD
+
+__attribute__((target("avx2")))
+static size_t repulsive_adhesion_motion_avx2(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    const double* dist,
+    const double* dx,
+    const double* dy,
+    double* fx,
+    double* fy,
+    size_t count
+) {
+    const __m256d two_σ = _mm256_set1_pd(2 * σ);
+    const __m256d neg_k = _mm256_set1_pd(-k);
+    const __m256d k_adh_v = _mm256_set1_pd(k_adh);
+    const __m256d adh_range = _mm256_set1_pd(2 * σ - r_adh);
+    const __m256d r_adh_v = _mm256_set1_pd(r_adh);
+    const __m256d zero = _mm256_setzero_pd();
+
+    size_t p = 0;
+    for (; p + 4 <= count; p += 4) {
+        const __m256d d = _mm256_loadu_pd(dist + p);
+        const __m256d overlap = _mm256_sub_pd(two_σ, d);
+
+        const __m256d Fij_rep = _mm256_div_pd(_mm256_mul_pd(neg_k, overlap), two_σ);
+        const __m256d Fij_adh = _mm256_div_pd(_mm256_mul_pd(k_adh_v, overlap), adh_range);
+
+        // Masks instead of branches: repulsion below 2σ, adhesion from 2σ up to r_adh, nothing beyond
+        const __m256d is_rep = _mm256_cmp_pd(d, two_σ, _CMP_LT_OQ);
+        const __m256d is_adh = _mm256_cmp_pd(d, r_adh_v, _CMP_LE_OQ);
+        const __m256d Fij = _mm256_blendv_pd(_mm256_blendv_pd(zero, Fij_adh, is_adh), Fij_rep, is_rep);
+
+        _mm256_storeu_pd(fx + p, _mm256_mul_pd(Fij, _mm256_div_pd(_mm256_loadu_pd(dx + p), d)));
+        _mm256_storeu_pd(fy + p, _mm256_mul_pd(Fij, _mm256_div_pd(_mm256_loadu_pd(dy + p), d)));
+    }
+
+    return p;
+}
+
+
+__attribute__((target("avx512f")))
+static size_t repulsive_adhesion_motion_avx512(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    const double* dist,
+    const double* dx,
+    const double* dy,
+    double* fx,
+    double* fy,
+    size_t count
+) {
+    const __m512d two_σ = _mm512_set1_pd(2 * σ);
+    const __m512d neg_k = _mm512_set1_pd(-k);
+    const __m512d k_adh_v = _mm512_set1_pd(k_adh);
+    const __m512d adh_range = _mm512_set1_pd(2 * σ - r_adh);
+    const __m512d r_adh_v = _mm512_set1_pd(r_adh);
+    const __m512d zero = _mm512_setzero_pd();
+
+    size_t p = 0;
+    for (; p + 8 <= count; p += 8) {
+        const __m512d d = _mm512_loadu_pd(dist + p);
+        const __m512d overlap = _mm512_sub_pd(two_σ, d);
+
+        const __m512d Fij_rep = _mm512_div_pd(_mm512_mul_pd(neg_k, overlap), two_σ);
+        const __m512d Fij_adh = _mm512_div_pd(_mm512_mul_pd(k_adh_v, overlap), adh_range);
+
+        const __mmask8 is_rep = _mm512_cmp_pd_mask(d, two_σ, _CMP_LT_OQ);
+        const __mmask8 is_adh = _mm512_cmp_pd_mask(d, r_adh_v, _CMP_LE_OQ);
+        const __m512d Fij = _mm512_mask_blend_pd(is_rep, _mm512_mask_blend_pd(is_adh, zero, Fij_adh), Fij_rep);
+
+        _mm512_storeu_pd(fx + p, _mm512_mul_pd(Fij, _mm512_div_pd(_mm512_loadu_pd(dx + p), d)));
+        _mm512_storeu_pd(fy + p, _mm512_mul_pd(Fij, _mm512_div_pd(_mm512_loadu_pd(dy + p), d)));
+    }
+
+    return p;
+}
+#endif
+
+
+SimdLevel detect_simd_level() {
+#ifdef TISSUE_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+
+/**
+ * @brief Evaluate the force law for a whole batch of pairs at once
+ *
+ * The vector kernels handle full registers, the remaining pairs and unsupported instruction sets use the scalar loop.
+*/
+void repulsive_adhesion_motion_batch(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    const double* dist,
+    const double* dx,
+    const double* dy,
+    double* fx,
+    double* fy,
+    size_t count,
+    SimdLevel level
+) {
+    size_t done = 0;
+
+#ifdef TISSUE_X86_SIMD
+    if (level == SimdLevel::AVX512) {
+        done = repulsive_adhesion_motion_avx512(k, σ, r_adh, k_adh, dist, dx, dy, fx, fy, count);
+    }
+    else if (level == SimdLevel::AVX2) {
+        done = repulsive_adhesion_motion_avx2(k, σ, r_adh, k_adh, dist, dx, dy, fx, fy, count);
+    }
+#endif
+
+    repulsive_adhesion_motion_scalar(k, σ, r_adh, k_adh, dist, dx, dy, fx, fy, done, count);
+}
+
+
+void repulsive_adhesion_motion_batch(
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    InteractionBatch& batch
+) {
+    // The CPU does not change during the run, so it gets asked only once
+    static const SimdLevel level = detect_simd_level();
+
+    batch.fx.resize(batch.size());
+    batch.fy.resize(batch.size());
+    repulsive_adhesion_motion_batch(
+        k, σ, r_adh, k_adh,
+        batch.dist.data(), batch.dx.data(), batch.dy.data(), batch.fx.data(), batch.fy.data(), batch.size(),
+        level
+    );
+}
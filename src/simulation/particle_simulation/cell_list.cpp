@@ -0,0 +1,328 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_list.h>
+
+
+UVCellList::UVCellList(double search_radius, SeamType seam_type) : seam_type(seam_type) {
+    if (!(search_radius > 0)) {
+        throw std::invalid_argument("The search radius of the cell list has to be positive");
+    }
+
+    num_cells_per_side = std::clamp(static_cast<int>(std::floor(1.0 / search_radius)), 1, max_cells_per_side);
+    cell_reach.assign(num_cells_per_side * num_cells_per_side, 1);
+    build_neighbors();
+}
+
+
+/**
+ * @brief Cells sized for nine of ten faces, the cells around the strongly stretched faces reach further
+ *
+ * A path of the 3D length R, which starts in a cell, stays within R times the largest stretch of the faces it crosses.
+ * Therefore the reach of a cell grows, until it covers R times the largest stretch of all faces within the reach
+ * plus the snap margin. A single degenerated face only widens the stencils around it instead of shrinking all cells.
+*/
+UVCellList::UVCellList(
+    double search_range,
+    double snap_margin,
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXi& faces_uv,
+    const UVAffineMaps& affine_maps,
+    SeamType seam_type
+) :
+    seam_type(seam_type)
+{
+    const int num_faces = faces_uv.rows();
+    if (!(search_range > 0) || num_faces == 0) {
+        throw std::invalid_argument("The cell list needs a positive search range and the UV faces");
+    }
+
+    // A collapsed 3D face has no tangent plane and gets skipped like in max_uv_stretch
+    std::vector<double> face_stretch(num_faces);
+    for (int f = 0; f < num_faces; ++f) {
+        const double stretch = affine_maps.uv_stretch(f);
+        face_stretch[f] = std::isfinite(stretch) ? stretch : 0.0;
+    }
+
+    std::vector<double> sorted_stretch = face_stretch;
+    auto typical_stretch = sorted_stretch.begin() + (num_faces - 1) * 9 / 10;
+    std::nth_element(sorted_stretch.begin(), typical_stretch, sorted_stretch.end());
+
+    const double typical_radius = search_range * *typical_stretch + snap_margin;
+    num_cells_per_side = typical_radius > 0 ? std::clamp(static_cast<int>(std::floor(1.0 / typical_radius)), 1, max_cells_per_side) : max_cells_per_side;
+    const int G = num_cells_per_side;
+
+    // Largest stretch of the faces, whose UV bounding box overlaps the cell
+    std::vector<double> cell_stretch(G * G, 0.0);
+    for (int f = 0; f < num_faces; ++f) {
+        Eigen::Vector2d lower = vertices_uv.row(faces_uv(f, 0)).head<2>().transpose();
+        Eigen::Vector2d upper = lower;
+        for (int corner = 1; corner < 3; ++corner) {
+            lower = lower.cwiseMin(vertices_uv.row(faces_uv(f, corner)).head<2>().transpose());
+            upper = upper.cwiseMax(vertices_uv.row(faces_uv(f, corner)).head<2>().transpose());
+        }
+
+        const int x_begin = std::clamp(static_cast<int>(std::floor(lower.x() * G)), 0, G - 1);
+        const int x_end = std::clamp(static_cast<int>(std::floor(upper.x() * G)), 0, G - 1);
+        const int y_begin = std::clamp(static_cast<int>(std::floor(lower.y() * G)), 0, G - 1);
+        const int y_end = std::clamp(static_cast<int>(std::floor(upper.y() * G)), 0, G - 1);
+        for (int x = x_begin; x <= x_end; ++x) {
+            for (int y = y_begin; y <= y_end; ++y) {
+                cell_stretch[x * G + y] = std::max(cell_stretch[x * G + y], face_stretch[f]);
+            }
+        }
+    }
+
+    // A reach of G covers the whole square from every cell
+    cell_reach.assign(G * G, 1);
+    std::vector<int> stencil;
+    for (int x = 0; x < G; ++x) {
+        for (int y = 0; y < G; ++y) {
+            int reach = 1;
+            while (reach < G) {
+                stencil.clear();
+                for (int dx = -reach; dx <= reach; ++dx) {
+                    for (int dy = -reach; dy <= reach; ++dy) {
+                        add_neighbor(stencil, x + dx, y + dy);
+                    }
+                }
+
+                double stretch = 0;
+                for (int cell_id : stencil) {
+                    stretch = std::max(stretch, cell_stretch[cell_id]);
+                }
+
+                const int needed_reach = static_cast<int>(std::ceil((search_range * stretch + snap_margin) * G));
+                if (needed_reach <= reach) break;
+                reach = std::min(needed_reach, G);
+            }
+            cell_reach[x * G + y] = reach;
+        }
+    }
+
+    build_neighbors();
+}
+
+
+/**
+ * @brief Stencil of every cell out of its reach, the halo cells get mapped into the square
+*/
+void UVCellList::build_neighbors() {
+    const int G = num_cells_per_side;
+    neighbors.assign(G * G, {});
+
+    for (int x = 0; x < G; ++x) {
+        for (int y = 0; y < G; ++y) {
+            const int reach = cell_reach[x * G + y];
+            for (int dx = -reach; dx <= reach; ++dx) {
+                for (int dy = -reach; dy <= reach; ++dy) {
+                    add_neighbor(neighbors[x * G + y], x + dx, y + dy);
+                }
+            }
+        }
+    }
+
+    // The mapped corners and the different reaches are not symmetric, a pair has to be found from both of its cells
+    std::vector<std::vector<int>> stencil_neighbors = neighbors;
+    for (int cell_id = 0; cell_id < G * G; ++cell_id) {
+        for (int neighbor : stencil_neighbors[cell_id]) {
+            neighbors[neighbor].push_back(cell_id);
+        }
+    }
+    for (auto& cell_neighbors : neighbors) {
+        std::sort(cell_neighbors.begin(), cell_neighbors.end());
+        cell_neighbors.erase(std::unique(cell_neighbors.begin(), cell_neighbors.end()), cell_neighbors.end());
+    }
+}
+
+
+/**
+ * @brief Add the cell (x, y), a halo cell gets replaced by the cell on the other side of the seam
+ *
+ * The diagonal seam glues the corners (1, 0) and (0, 1) to each other, so a corner halo cell maps onto both of them.
+*/
+void UVCellList::add_neighbor(std::vector<int>& cells, int x, int y) const {
+    const int G = num_cells_per_side;
+    const bool outside_x = x < 0 || x >= G;
+    const bool outside_y = y < 0 || y >= G;
+
+    cells.push_back(fold_cell(x, y));
+    if (seam_type == SeamType::Diagonal && outside_x && outside_y) {
+        cells.push_back(fold_cell(y, x));
+    }
+}
+
+
+/**
+ * @brief Cell of the square, which the halo cell (x, y) lies on, for halo cells up to G cells outside of the square
+*/
+int UVCellList::fold_cell(int x, int y) const {
+    const int G = num_cells_per_side;
+
+    if (seam_type == SeamType::Opposite) {
+        return ((x % G + G) % G) * G + (y % G + G) % G;
+    }
+
+    // Diagonal seam: leaving through (1, y) enters through (y, 1), leaving through (0, y) enters through (y, 0)
+    for (int fold = 0; fold < 4 && (x < 0 || x >= G || y < 0 || y >= G); ++fold) {
+        if (x >= G) {
+            std::tie(x, y) = std::make_pair(y, 2 * G - 1 - x);
+        }
+        else if (x < 0) {
+            std::tie(x, y) = std::make_pair(y, -1 - x);
+        }
+        else if (y >= G) {
+            std::tie(x, y) = std::make_pair(2 * G - 1 - y, x);
+        }
+        else {
+            std::tie(x, y) = std::make_pair(-1 - y, x);
+        }
+    }
+
+    return std::clamp(x, 0, G - 1) * G + std::clamp(y, 0, G - 1);
+}
+
+
+int UVCellList::cell_of(double u, double v) const {
+    const int G = num_cells_per_side;
+    const int x = std::clamp(static_cast<int>(std::floor(u * G)), 0, G - 1);
+    const int y = std::clamp(static_cast<int>(std::floor(v * G)), 0, G - 1);
+
+    return x * G + y;
+}
+
+
+/**
+ * @brief Counting sort of the particles by their cell
+*/
+void UVCellList::build(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV) {
+    const int num_part = r_UV.rows();
+    const int num_cells = neighbors.size();
+
+    std::vector<int> particle_cell(num_part);
+    cell_start.assign(num_cells + 1, 0);
+    for (int i = 0; i < num_part; ++i) {
+        particle_cell[i] = cell_of(r_UV(i, 0), r_UV(i, 1));
+        ++cell_start[particle_cell[i] + 1];
+    }
+    for (int c = 0; c < num_cells; ++c) {
+        cell_start[c + 1] += cell_start[c];
+    }
+
+    cell_particles.resize(num_part);
+    std::vector<int> next_slot(cell_start.begin(), cell_start.end() - 1);
+    for (int i = 0; i < num_part; ++i) {
+        cell_particles[next_slot[particle_cell[i]]++] = i;
+    }
+}
+
+
+std::vector<ParticlePair> UVCellList::candidate_pairs() const {
+    std::vector<ParticlePair> pairs;
+    candidate_pairs(pairs);
+
+    return pairs;
+}
+
+
+void UVCellList::candidate_pairs(std::vector<ParticlePair>& pairs) const {
+    pairs.clear();
+    const int num_cells = neighbors.size();
+
+    for (int c = 0; c < num_cells; ++c) {
+        for (int a = cell_start[c]; a < cell_start[c + 1]; ++a) {
+            const int i = cell_particles[a];
+
+            for (int neighbor : neighbors[c]) {
+                for (int b = cell_start[neighbor]; b < cell_start[neighbor + 1]; ++b) {
+                    const int j = cell_particles[b];
+                    if (j > i) {
+                        pairs.emplace_back(i, j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+const std::vector<ParticlePair>& UVCellList::find_pairs(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+    const std::vector<int>&
+){
+    ++statistics.steps;
+    ++statistics.rebuilds;
+
+    build(r_UV);
+    candidate_pairs(found_pairs);
+
+    return found_pairs;
+}
+
+
+/**
+ * @brief All pairs of the particles, e.g. for a handful of particles, which does not need a cell list
+*/
+std::vector<ParticlePair> all_particle_pairs(int num_part) {
+    std::vector<ParticlePair> pairs;
+    pairs.reserve(static_cast<size_t>(num_part) * (num_part - 1) / 2);
+
+    for (int i = 0; i < num_part; ++i) {
+        for (int j = i + 1; j < num_part; ++j) {
+            pairs.emplace_back(i, j);
+        }
+    }
+
+    return pairs;
+}
+
+
+/**
+ * @brief Upper bound of the UV length per 3D length of the parametrization
+ *
+ * On every face a 3D displacement d maps to the UV displacement J^+ d, which is at most as long as |d| times the
+ * largest singular value of J^+, i.e. 1 / σ_min of the face Jacobian J. A geodesic path runs through the faces,
+ * so the largest value over all faces bounds the UV length of every path. The search radius of the cell list is
+ * the interaction radius of the particles times this stretch.
+ * A collapsed 3D face has no tangent plane and gets skipped.
+*/
+double max_uv_stretch(const UVAffineMaps& affine_maps){
+    double stretch = 0;
+    for (int f = 0; f < affine_maps.num_faces(); ++f) {
+        stretch = std::max(stretch, affine_maps.uv_stretch(f));
+    }
+
+    return stretch;
+}
+
+
+/**
+ * @brief Longest UV edge of the faces
+ *
+ * The distances of the particles are those of the face corners, which the particles get snapped to.
+ * A particle lies at most one UV edge away from its corner, so the search radius needs twice this margin.
+*/
+double max_uv_edge_length(
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv
+){
+    double max_length = 0;
+    for (int f = 0; f < faces_uv.rows(); ++f) {
+        for (int corner = 0; corner < 3; ++corner) {
+            const double length = (halfedges_uv.row(faces_uv(f, (corner + 1) % 3)).head<2>() - halfedges_uv.row(faces_uv(f, corner)).head<2>()).norm();
+            max_length = std::max(max_length, length);
+        }
+    }
+
+    return max_length;
+}
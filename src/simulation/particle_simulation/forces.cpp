@@ -3,6 +3,9 @@
 // license: Apache License 2.0
 // version: 0.1.0
 
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
 #include <vector>
 #include <Eigen/Dense>
 
@@ -11,51 +14,166 @@
 
 
 /**
-* @brief: Calculate the force that each particle feels due to all the other particles
-*
-* @info: Unittest implemented
+ * @brief Greedy coloring of the pairs, so that no two pairs of the same color share a particle
+ *
+ * Every particle remembers the colors of its pairs as bits, each pair gets the smallest color, which is free at both
+ * of its particles. With a maximal number of neighbors d at most 2d - 1 colors are needed.
+ * The pairs get sorted by their color afterwards, so each color is a contiguous range.
 */
-Eigen::Matrix<double, Eigen::Dynamic, 2> calculate_forces_between_particles(
-    const std::vector<Eigen::MatrixXd>& dist_vect,
-    const Eigen::MatrixXd& dist_length,
+PairColors color_pairs(const std::vector<ParticlePair>& pairs, int num_part) {
+    std::vector<std::vector<uint64_t>> used_colors(num_part);
+    std::vector<int> colors(pairs.size());
+    int num_colors = 0;
+
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        std::vector<uint64_t>& used_i = used_colors[pairs[p].first];
+        std::vector<uint64_t>& used_j = used_colors[pairs[p].second];
+
+        size_t word = 0;
+        uint64_t free = 0;
+        for (; free == 0; ++word) {
+            uint64_t taken_i = word < used_i.size() ? used_i[word] : 0;
+            uint64_t taken_j = word < used_j.size() ? used_j[word] : 0;
+            free = ~(taken_i | taken_j);
+        }
+        --word;
+
+        const int bit = __builtin_ctzll(free);
+        colors[p] = 64 * word + bit;
+        num_colors = std::max(num_colors, colors[p] + 1);
+
+        if (used_i.size() <= word) used_i.resize(word + 1, 0);
+        if (used_j.size() <= word) used_j.resize(word + 1, 0);
+        used_i[word] |= uint64_t(1) << bit;
+        used_j[word] |= uint64_t(1) << bit;
+    }
+
+    // Counting sort of the pairs by their color
+    PairColors pair_colors;
+    pair_colors.color_start.assign(num_colors + 1, 0);
+    for (int color : colors) ++pair_colors.color_start[color + 1];
+    for (int color = 0; color < num_colors; ++color) pair_colors.color_start[color + 1] += pair_colors.color_start[color];
+
+    pair_colors.pair_ids.resize(pairs.size());
+    std::vector<long> next(pair_colors.color_start.begin(), pair_colors.color_start.end() - 1);
+    for (size_t p = 0; p < pairs.size(); ++p) pair_colors.pair_ids[next[colors[p]]++] = p;
+
+    return pair_colors;
+}
+
+
+/**
+ * @brief Evaluate the force law of the interacting pairs and apply equal and opposite forces to both particles
+ *
+ * The batch holds the distance and the displacement r_i - r_j of every interacting pair.
+ * The parallel reductions avoid the races of two threads adding to the same particle:
+ * - ThreadLocalBuffers: every thread adds into its own force matrix, the matrices get summed per particle afterwards
+ * - PairColoring: the pairs of one color share no particle, so each color is processed in parallel without conflicts
+ *
+ * The coloring is expensive compared with the forces, so it should be computed once per pair list and passed in.
+ * If it colors the candidate pairs instead of the interacting ones, batch_of_pair maps every candidate pair
+ * to its position in the batch, or to -1 if it does not interact. Without a coloring the interacting pairs get colored.
+ * The forces go into F and the thread buffers into thread_forces, both keep their memory from call to call.
+*/
+void accumulate_pair_forces(
+    const std::vector<ParticlePair>& interacting,
+    InteractionBatch& batch,
+    int num_part,
     double k,
     double σ,
     double r_adh,
-    double k_adh
+    double k_adh,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& F,
+    std::vector<Eigen::Matrix<double, Eigen::Dynamic, 2>>& thread_forces,
+    ForceReduction reduction,
+    const PairColors* colors,
+    const std::vector<long>* batch_of_pair
 ){
-    // Get the number of particles
-    int num_part = dist_vect[0].rows();
+    static const SimdLevel simd_level = detect_simd_level();
 
-    // Initialize force matrix with zeros
-    Eigen::Matrix<double, Eigen::Dynamic, 2> F(num_part, 2);
-    F.setZero();
+    // Below this size the threads cost more than they save
+    const long num_pairs = batch.size();
+    const bool parallel = reduction != ForceReduction::Serial && num_pairs >= 2048;
 
-    // Loop over all particle pairs
-    for (int i = 0; i < num_part; i++) {
-        for (int j = 0; j < num_part; j++) {
+    batch.fx.resize(num_pairs);
+    batch.fy.resize(num_pairs);
 
-            // Skip if particle itself
-            if (i == j) continue;
+    const long chunk_size = 1024;
+    const long num_chunks = (num_pairs + chunk_size - 1) / chunk_size;
+    #pragma omp parallel for schedule(static) if(parallel)
+    for (long chunk = 0; chunk < num_chunks; ++chunk) {
+        const long begin = chunk * chunk_size;
+        const long count = std::min(chunk_size, num_pairs - begin);
+        repulsive_adhesion_motion_batch(
+            k, σ, r_adh, k_adh,
+            batch.dist.data() + begin, batch.dx.data() + begin, batch.dy.data() + begin, batch.fx.data() + begin, batch.fy.data() + begin, count,
+            simd_level
+        );
+    }
 
-            // Distance between particles A and B
-            double dist = dist_length(i, j);
+    F.setZero(num_part, 2);
 
-            // No force if particles too far from each other 
-            if (dist >= 2 * σ) continue;
+    if (!parallel) {
+        for (long p = 0; p < num_pairs; ++p) {
+            const auto [i, j] = interacting[p];
+            F(i, 0) += batch.fx[p];
+            F(i, 1) += batch.fy[p];
+            F(j, 0) -= batch.fx[p];
+            F(j, 1) -= batch.fy[p];
+        }
+    }
+    else if (reduction == ForceReduction::ThreadLocalBuffers) {
+        if (thread_forces.size() < static_cast<size_t>(omp_get_max_threads())) {
+            thread_forces.resize(omp_get_max_threads());
+        }
 
-            // Add a small value if the distance is zero or you get nan values due to 'Fij * (dist_v / dist)' (division by zero)
-            if (dist == 0) {
-                dist += 0.001;
-            }
+        #pragma omp parallel
+        {
+            // Buffers of threads outside this team may hold the forces of an earlier call, only the team's get summed
+            const int num_threads = omp_get_num_threads();
+            Eigen::Matrix<double, Eigen::Dynamic, 2>& local_F = thread_forces[omp_get_thread_num()];
+            local_F.setZero(num_part, 2);
 
-            // Eigen::Vector3d for the 3D distance vector
-            Eigen::Vector2d dist_v(dist_vect[0](i, j), dist_vect[1](i, j));
+            #pragma omp for schedule(static)
+            for (long p = 0; p < num_pairs; ++p) {
+                const auto [i, j] = interacting[p];
+                local_F(i, 0) += batch.fx[p];
+                local_F(i, 1) += batch.fy[p];
+                local_F(j, 0) -= batch.fx[p];
+                local_F(j, 1) -= batch.fy[p];
+            }
 
-            // Calculate the force between particles A and B
-            F.row(i) += repulsive_adhesion_motion(k, σ, dist, r_adh, k_adh, dist_v);
+            // Sum the buffers per particle, so that the reduction runs in parallel as well
+            #pragma omp for schedule(static)
+            for (int i = 0; i < num_part; ++i) {
+                for (int thread = 0; thread < num_threads; ++thread) {
+                    F.row(i) += thread_forces[thread].row(i);
+                }
+            }
         }
     }
+    else {
+        PairColors interacting_colors;
+        if (!colors) {
+            interacting_colors = color_pairs(interacting, num_part);
+            colors = &interacting_colors;
+            batch_of_pair = nullptr;
+        }
+
+        #pragma omp parallel
+        for (int color = 0; color < colors->num_colors(); ++color) {
+            // The implicit barrier of the loop keeps the colors apart
+            #pragma omp for schedule(static)
+            for (long c = colors->color_start[color]; c < colors->color_start[color + 1]; ++c) {
+                const long p = batch_of_pair ? (*batch_of_pair)[colors->pair_ids[c]] : colors->pair_ids[c];
+                if (p < 0) continue;
 
-    // Actual force felt by each particle
-    return F;
+                const auto [i, j] = interacting[p];
+                F(i, 0) += batch.fx[p];
+                F(i, 1) += batch.fy[p];
+                F(j, 0) -= batch.fx[p];
+                F(j, 1) -= batch.fy[p];
+            }
+        }
+    }
 }
@@ -0,0 +1,293 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_cell_interactions.h>
+#include <particle_simulation/forces.h>
+#include <particle_simulation/pair_interactions.h>
+
+
+/**
+ * @brief Neighbors of every particle as compressed rows over all pairs, in the order of the pairs
+*/
+static void build_neighbor_rows(const std::vector<ParticlePair>& pairs, int num_part, PairWorkspace& workspace) {
+    std::vector<int>& neighbor_start = workspace.neighbor_start;
+    neighbor_start.assign(num_part + 1, 0);
+    for (const auto& [i, j] : pairs) {
+        ++neighbor_start[i + 1];
+        ++neighbor_start[j + 1];
+    }
+    for (int i = 0; i < num_part; ++i) {
+        neighbor_start[i + 1] += neighbor_start[i];
+    }
+
+    workspace.neighbors.resize(neighbor_start[num_part]);
+    std::vector<int> next(neighbor_start.begin(), neighbor_start.end() - 1);
+    for (long p = 0; p < static_cast<long>(pairs.size()); ++p) {
+        const auto [i, j] = pairs[p];
+        workspace.neighbors[next[i]++] = {j, p};
+        workspace.neighbors[next[j]++] = {i, p};
+    }
+}
+
+
+/**
+ * @brief Sums of the unit vectors within 2σ and the neighbor counts within 2.4σ, in parallel over the particles
+ *
+ * Each particle only writes its own sums over its neighbor row.
+ * The rows keep the order of the pairs, therefore the sums are exactly the same as the ones added pair by pair.
+*/
+static void sum_neighbors_per_particle(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec,
+    const std::vector<double>& pair_distances,
+    double σ,
+    const PairWorkspace& workspace,
+    PairInteractions& interactions
+){
+    const int num_part = n_vec.rows();
+    const std::vector<int>& neighbor_start = workspace.neighbor_start;
+
+    interactions.n_sum.resize(num_part, 2);
+    interactions.neighbor_count.resize(num_part);
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < num_part; ++i) {
+        double sum_x = n_vec(i, 0);
+        double sum_y = n_vec(i, 1);
+        double neighbor_count = 0;
+
+        for (int c = neighbor_start[i]; c < neighbor_start[i + 1]; ++c) {
+            const auto [other, pair] = workspace.neighbors[c];
+            const double dist = pair_distances[pair];
+
+            if (dist != 0 && dist <= 2.4 * σ) {
+                neighbor_count += 1;
+            }
+            if (dist < 2 * σ) {
+                sum_x += n_vec(other, 0);
+                sum_y += n_vec(other, 1);
+            }
+        }
+
+        interactions.n_sum(i, 0) = sum_x;
+        interactions.n_sum(i, 1) = sum_y;
+        interactions.neighbor_count(i) = neighbor_count;
+    }
+}
+
+
+/**
+ * @brief Distances and displacements of the pairs within 2σ in parallel, in the order of the pairs
+ *
+ * Every chunk of pairs counts its interacting pairs first, then it writes them to its own offset.
+ * On request every pair also gets its position in the batch, -1 if it does not interact.
+*/
+static void collect_interacting_pairs(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double σ,
+    PairWorkspace& workspace,
+    bool map_pairs
+){
+    InteractionBatch& batch = workspace.batch;
+    std::vector<ParticlePair>& interacting = workspace.interacting;
+    std::vector<long>* batch_of_pair = map_pairs ? &workspace.batch_of_pair : nullptr;
+
+    const long num_pairs = pairs.size();
+    const long chunk_size = 4096;
+    const long num_chunks = (num_pairs + chunk_size - 1) / chunk_size;
+
+    std::vector<long>& chunk_offset = workspace.chunk_offset;
+    chunk_offset.assign(num_chunks + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (long chunk = 0; chunk < num_chunks; ++chunk) {
+        const long end = std::min(num_pairs, (chunk + 1) * chunk_size);
+        for (long p = chunk * chunk_size; p < end; ++p) {
+            if (pair_distances[p] < 2 * σ) ++chunk_offset[chunk + 1];
+        }
+    }
+    for (long chunk = 0; chunk < num_chunks; ++chunk) {
+        chunk_offset[chunk + 1] += chunk_offset[chunk];
+    }
+
+    batch.dist.resize(chunk_offset[num_chunks]);
+    batch.dx.resize(chunk_offset[num_chunks]);
+    batch.dy.resize(chunk_offset[num_chunks]);
+    interacting.resize(chunk_offset[num_chunks]);
+    if (batch_of_pair) batch_of_pair->resize(num_pairs);
+
+    #pragma omp parallel for schedule(static)
+    for (long chunk = 0; chunk < num_chunks; ++chunk) {
+        const long end = std::min(num_pairs, (chunk + 1) * chunk_size);
+        long b = chunk_offset[chunk];
+
+        for (long p = chunk * chunk_size; p < end; ++p) {
+            double dist = pair_distances[p];
+            if (batch_of_pair) (*batch_of_pair)[p] = dist < 2 * σ ? b : -1;
+            if (dist >= 2 * σ) continue;
+
+            // Add a small value if the distance is zero or you get nan values due to 'Fij * (dist_v / dist)' (division by zero)
+            if (dist == 0) {
+                dist += 0.001;
+            }
+
+            const auto [i, j] = pairs[p];
+            batch.dist[b] = dist;
+            batch.dx[b] = r(i, 0) - r(j, 0);
+            batch.dy[b] = r(i, 1) - r(j, 1);
+            interacting[b] = pairs[p];
+            ++b;
+        }
+    }
+}
+
+
+/**
+ * @brief Force, alignment and neighbor count of all particles over the candidate pairs
+ *
+ * Each particle aligns with the particles within 2σ including itself, feels the force of the particles within 2σ
+ * and counts the neighbors within 2.4σ as its color.
+ * A single thread handles every pair and its distance in one pass. With several threads the alignment and the
+ * neighbor count run in parallel over the particles and the interacting pairs get collected in parallel chunks.
+ * Collecting the neighbors of each particle costs more than the sums themselves, so it only pays off with threads.
+ * Both ways give exactly the same sums, independent of the number of threads.
+ * The buffers and the results live in the workspace, so a step allocates nothing as long as the pairs stay the same.
+ * The neighbor rows and the coloring for the pair coloring reduction only get rebuilt when the pairs_generation of the
+ * workspace changes.
+*/
+const PairInteractions& calculate_pair_interactions(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    ForceReduction reduction,
+    PairWorkspace& buffers
+){
+    const int num_part = r.rows();
+
+    // Below this size the threads cost more than they save
+    const bool parallel = reduction != ForceReduction::Serial && pairs.size() >= 2048 && omp_get_max_threads() > 1;
+
+    PairInteractions& interactions = buffers.interactions;
+
+    // The force law gets evaluated afterwards for all interacting pairs in one batch
+    InteractionBatch& batch = buffers.batch;
+    std::vector<ParticlePair>& interacting = buffers.interacting;
+
+    // The coloring of all pairs also holds for the interacting ones, so it only gets computed for a new pair list
+    const PairColors* colors = nullptr;
+    const std::vector<long>* batch_of_pair = nullptr;
+
+    if (parallel) {
+        if (buffers.neighbors_generation != buffers.pairs_generation || buffers.neighbor_start.size() != static_cast<size_t>(num_part + 1)
+            || buffers.neighbors.size() != 2 * pairs.size()) {
+            build_neighbor_rows(pairs, num_part, buffers);
+            buffers.neighbors_generation = buffers.pairs_generation;
+        }
+
+        if (reduction == ForceReduction::PairColoring) {
+            if (buffers.colors_generation != buffers.pairs_generation || buffers.colors.pair_ids.size() != pairs.size()) {
+                buffers.colors = color_pairs(pairs, num_part);
+                buffers.colors_generation = buffers.pairs_generation;
+            }
+            colors = &buffers.colors;
+            batch_of_pair = &buffers.batch_of_pair;
+        }
+
+        sum_neighbors_per_particle(n_vec, pair_distances, σ, buffers, interactions);
+        collect_interacting_pairs(r, pairs, pair_distances, σ, buffers, batch_of_pair != nullptr);
+    }
+    else {
+        interactions.n_sum = n_vec;
+        interactions.neighbor_count.setZero(num_part);
+        batch.clear();
+        interacting.clear();
+
+        for (size_t p = 0; p < pairs.size(); ++p) {
+            double dist = pair_distances[p];
+            const auto [i, j] = pairs[p];
+
+            if (dist != 0 && dist <= 2.4 * σ) {
+                interactions.neighbor_count(i) += 1;
+                interactions.neighbor_count(j) += 1;
+            }
+
+            // Neither alignment nor force if particles too far from each other
+            if (dist >= 2 * σ) continue;
+
+            interactions.n_sum.row(i) += n_vec.row(j);
+            interactions.n_sum.row(j) += n_vec.row(i);
+
+            // Add a small value if the distance is zero or you get nan values due to 'Fij * (dist_v / dist)' (division by zero)
+            if (dist == 0) {
+                dist += 0.001;
+            }
+
+            batch.add(dist, r.row(i) - r.row(j));
+            interacting.push_back(pairs[p]);
+        }
+    }
+
+    // The force is antisymmetric, so particle j feels the opposite force of particle i
+    accumulate_pair_forces(
+        interacting, batch, num_part, k, σ, r_adh, k_adh, interactions.force, buffers.thread_forces,
+        parallel ? reduction : ForceReduction::Serial, colors, batch_of_pair
+    );
+
+    return interactions;
+}
+
+
+/**
+ * @brief Same as above with buffers, which only live for this call
+*/
+PairInteractions calculate_pair_interactions(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec,
+    const std::vector<ParticlePair>& pairs,
+    const std::vector<double>& pair_distances,
+    double k,
+    double σ,
+    double r_adh,
+    double k_adh,
+    ForceReduction reduction
+){
+    PairWorkspace workspace;
+    calculate_pair_interactions(r, n_vec, pairs, pair_distances, k, σ, r_adh, k_adh, reduction, workspace);
+
+    return std::move(workspace.interactions);
+}
+
+
+/**
+ * @brief The mean orientation of the neighbors is the direction of the sum of their unit vectors
+ *
+ * A sum of exactly zero has no direction, it points along the x axis like the angle atan2(0, 0) = 0 did before.
+*/
+void normalize_unit_vector_sums(const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_sum, Eigen::Matrix<double, Eigen::Dynamic, 2>& n) {
+    n.resize(n_sum.rows(), 2);
+
+    #pragma omp parallel for schedule(static) if(n_sum.rows() >= 4096)
+    for (int i = 0; i < n_sum.rows(); i++) {
+        const double norm = n_sum.row(i).norm();
+
+        if (norm > 0) {
+            n.row(i) = n_sum.row(i) / norm;
+        }
+        else {
+            n.row(i) << 1, 0;
+        }
+    }
+}
@@ -25,26 +25,23 @@
 #include <vector>
 #include <limits>
 
-#include <io/csv.h>
-#include <io/mesh_loader.h>
-
+#include <particle_simulation/neighbor_search.h>
 #include <particle_simulation/motion.h>
 
 #include <utilities/analytics.h>
-#include <utilities/dye_particle.h>
 #include <utilities/2D_mapping_fixed_border.h>
 // #include <utilities/2D_mapping_free_border.h>
-#include <utilities/2D_surface.h>
 #include <utilities/error_checking.h>
 
 #include <particle_simulation/simulation.h>
 
 
-std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::MatrixXd, Eigen::VectorXd, Eigen::VectorXd> perform_particle_simulation(
+std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::VectorXd> perform_particle_simulation(
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
-    Eigen::VectorXd& n,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
     std::vector<int>& vertices_3D_active,
-    Eigen::MatrixXd distance_matrix_v,
+    const SimulationContext& context,
+    NeighborSearch& neighbor_search,
     Eigen::VectorXd& v_order,
     double v0,
     double k,
@@ -57,28 +54,18 @@ std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::Mat
     double step_size,
     int current_step,
     int num_part,
-    std::unordered_map<int, Mesh_UV_Struct>& vertices_2DTissue_map,
+    const AngularNoise& noise,
+    ForceReduction force_reduction,
     double plotstep
 ){
-    // Get the original mesh from the dictionary
-    auto mesh_struct = vertices_2DTissue_map[0];
-    Eigen::MatrixXd halfedges_uv = mesh_struct.mesh;
-    std::vector<int64_t> h_v_mapping = mesh_struct.h_v_mapping;
-    Eigen::MatrixXd vertices_UV = mesh_struct.vertices_UV;
-    Eigen::MatrixXd vertices_3D = mesh_struct.vertices_3D;
-    std::string mesh_file_path = mesh_struct.mesh_file_path;
-    Eigen::MatrixXi faces_uv;
-    loadMeshFaces(mesh_file_path, faces_uv);
+    // Only the candidate pairs of the neighbor search can interact
+    const std::vector<ParticlePair>& pairs = neighbor_search.find_pairs(r_UV, vertices_3D_active);
 
-    // 1. Simulate the flight of the particle on the UV mesh
-    auto [r_UV_new, r_dot, dist_length] = simulate_flight(r_UV, n, vertices_3D_active, distance_matrix_v, v0, k, σ, μ, r_adh, k_adh, step_size);
+    // 1. Simulate the flight of the particle on the UV mesh, the buffers of the pair kernel stay with the pairs
+    auto [r_UV_new, r_dot, particles_color] = simulate_flight(r_UV, n, vertices_3D_active, pairs, *context.distance_matrix, v0, k, σ, μ, r_adh, k_adh, step_size, noise, current_step, force_reduction, &neighbor_search.workspace());
 
     // Map the new UV coordinates back to the UV mesh
-    auto mesh_UV_name = get_mesh_name(mesh_file_path);
-
-    // ! TODO: try to find out why the mesh parametrization can result in different UV mapping logics
-    // ? is it because of the seam edge cut line?
-    if (mesh_UV_name == "sphere_uv"){
+    if (context.seam_type == SeamType::Opposite){
         opposite_seam_edges_square_border(r_UV_new);
     }
     else {
@@ -91,11 +78,8 @@ std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, Eigen::MatrixXd, Eigen::Mat
     error_lost_particles(r_UV_new, num_part);  // 1. Check if we lost particles
     error_invalid_values(r_UV_new);  // 2. Check if there are invalid values like NaN or Inf in the output
 
-    // Dye the particles based on their distance
-    Eigen::VectorXd particles_color = dye_particles(dist_length, σ);
-
     // Calculate the order parameter
     calculate_order_parameter(v_order, r_UV, r_dot, current_step);
 
-    return std::make_tuple(r_UV_new, r_dot, dist_length, n, particles_color);
+    return std::make_tuple(r_UV_new, r_dot, n, particles_color);
 }
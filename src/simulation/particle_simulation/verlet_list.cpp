@@ -0,0 +1,99 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/verlet_list.h>
+
+
+VerletList::VerletList(
+    std::shared_ptr<NeighborSearch> candidate_search,
+    std::shared_ptr<const DistanceProvider> distance_matrix,
+    double cutoff,
+    double skin,
+    double distance_error
+) :
+    candidate_search(std::move(candidate_search)),
+    distance_matrix(std::move(distance_matrix)),
+    cutoff_distance(cutoff),
+    skin_distance(skin),
+    triangle_slack(distance_error)
+{
+    if (!this->candidate_search || !this->distance_matrix) {
+        throw std::invalid_argument("The Verlet list needs a candidate search and a distance matrix");
+    }
+    if (!(skin >= 0) || !(cutoff >= 0)) {
+        throw std::invalid_argument("The cutoff and the skin of the Verlet list have to be non-negative");
+    }
+    if (!(distance_error >= 0)) {
+        throw std::invalid_argument("The distance error of the Verlet list has to be non-negative");
+    }
+}
+
+
+const std::vector<ParticlePair>& VerletList::find_pairs(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV,
+    const std::vector<int>& vertices_3D_active
+){
+    ++statistics.steps;
+
+    if (needs_rebuild(vertices_3D_active)) {
+        rebuild(r_UV, vertices_3D_active);
+        ++statistics.rebuilds;
+    }
+
+    return neighbor_pairs;
+}
+
+
+/**
+ * @brief Rebuild if a particle moved more than half of the skin, less the distance error, since the last build
+*/
+bool VerletList::needs_rebuild(const std::vector<int>& vertices_3D_active) const {
+    if (statistics.rebuilds == 0 || vertices_3D_active.size() != vertices_at_build.size()) {
+        return true;
+    }
+
+    // Pair every particle with its own position at the last build, the vertices which did not change need no lookup
+    const int num_part = vertices_3D_active.size();
+    std::vector<int> vertices = vertices_at_build;
+    vertices.insert(vertices.end(), vertices_3D_active.begin(), vertices_3D_active.end());
+
+    std::vector<ParticlePair> moved;
+    for (int i = 0; i < num_part; ++i) {
+        if (vertices_3D_active[i] != vertices_at_build[i]) {
+            moved.emplace_back(i, num_part + i);
+        }
+    }
+
+    // Beyond the cutoff of a sparse distance matrix the displacement is infinite
+    const double max_displacement = skin_distance / 2 - triangle_slack;
+    for (double displacement : distance_matrix->distances_of_pairs(vertices, moved)) {
+        if (displacement > max_displacement) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void VerletList::rebuild(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV, const std::vector<int>& vertices_3D_active) {
+    const std::vector<ParticlePair>& candidates = candidate_search->find_pairs(r_UV, vertices_3D_active);
+    std::vector<double> candidate_distances = distance_matrix->distances_of_pairs(vertices_3D_active, candidates);
+
+    neighbor_pairs.clear();
+    for (size_t p = 0; p < candidates.size(); ++p) {
+        if (candidate_distances[p] <= cutoff_distance + skin_distance) {
+            neighbor_pairs.push_back(candidates[p]);
+        }
+    }
+
+    vertices_at_build = vertices_3D_active;
+}
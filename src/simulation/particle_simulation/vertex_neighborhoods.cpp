@@ -0,0 +1,135 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <Eigen/Dense>
+
+#include <particle_simulation/vertex_neighborhoods.h>
+
+
+/**
+ * @brief Collect the neighborhoods of all vertices as compressed sparse rows
+ *
+ * The neighborhoods get symmetrized, so that a pair of particles is found from both of its vertices,
+ * even if the distances of the provider are not exactly symmetric.
+*/
+VertexNeighborhoods::VertexNeighborhoods(const DistanceProvider& distance_matrix, double cutoff) : cutoff_distance(cutoff) {
+    if (!(cutoff >= 0)) {
+        throw std::invalid_argument("The cutoff of the vertex neighborhoods has to be non-negative");
+    }
+    if (distance_matrix.cutoff() < cutoff) {
+        throw std::invalid_argument("The cutoff " + std::to_string(distance_matrix.cutoff()) + " of the distance matrix is smaller than the cutoff "
+                                    + std::to_string(cutoff) + " of the vertex neighborhoods, the neighborhoods would miss pairs");
+    }
+
+    const int num_v = distance_matrix.rows();
+    std::vector<std::vector<int>> neighborhoods(num_v);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int v = 0; v < num_v; ++v) {
+        neighborhoods[v] = distance_matrix.vertices_within(v, cutoff);
+    }
+
+    for (int v = 0; v < num_v; ++v) {
+        for (int w : std::vector<int>(neighborhoods[v])) {
+            if (w != v) {
+                neighborhoods[w].push_back(v);
+            }
+        }
+    }
+
+    offsets.assign(num_v + 1, 0);
+    for (int v = 0; v < num_v; ++v) {
+        auto& neighborhood = neighborhoods[v];
+        neighborhood.push_back(v);
+        std::sort(neighborhood.begin(), neighborhood.end());
+        neighborhood.erase(std::unique(neighborhood.begin(), neighborhood.end()), neighborhood.end());
+
+        offsets[v + 1] = offsets[v] + neighborhood.size();
+    }
+
+    vertex_ids.reserve(offsets[num_v]);
+    for (auto& neighborhood : neighborhoods) {
+        vertex_ids.insert(vertex_ids.end(), neighborhood.begin(), neighborhood.end());
+        std::vector<int>().swap(neighborhood);
+    }
+}
+
+
+/**
+ * @brief Pairs of particles on vertices, which are within the cutoff of each other
+ *
+ * Only the occupied vertices get a bucket, so the cost scales with the particles and their neighborhoods,
+ * but not with the size of the mesh.
+*/
+std::vector<ParticlePair> VertexNeighborhoods::candidate_pairs(const std::vector<int>& vertices_3D_active) const {
+    std::vector<ParticlePair> pairs;
+    candidate_pairs(vertices_3D_active, pairs);
+
+    return pairs;
+}
+
+
+void VertexNeighborhoods::candidate_pairs(const std::vector<int>& vertices_3D_active, std::vector<ParticlePair>& pairs) const {
+    const int num_part = vertices_3D_active.size();
+
+    // Particles sorted by their vertex, each occupied vertex points to its range of particles
+    std::vector<int> particles(num_part);
+    std::iota(particles.begin(), particles.end(), 0);
+    std::sort(particles.begin(), particles.end(), [&](int a, int b) {
+        return vertices_3D_active[a] < vertices_3D_active[b];
+    });
+
+    std::unordered_map<int, std::pair<int, int>> buckets;
+    buckets.reserve(num_part);
+    for (int start = 0; start < num_part;) {
+        const int vertex_id = vertices_3D_active[particles[start]];
+        if (vertex_id < 0 || vertex_id >= num_vertices()) {
+            throw std::out_of_range("The active vertex is not part of the mesh: " + std::to_string(vertex_id));
+        }
+
+        int end = start;
+        while (end < num_part && vertices_3D_active[particles[end]] == vertex_id) ++end;
+        buckets.emplace(vertex_id, std::make_pair(start, end));
+        start = end;
+    }
+
+    pairs.clear();
+    for (int i = 0; i < num_part; ++i) {
+        auto [begin, end] = neighborhood(vertices_3D_active[i]);
+
+        for (const int* w = begin; w != end; ++w) {
+            auto bucket = buckets.find(*w);
+            if (bucket == buckets.end()) continue;
+
+            for (int b = bucket->second.first; b < bucket->second.second; ++b) {
+                const int j = particles[b];
+                if (j > i) {
+                    pairs.emplace_back(i, j);
+                }
+            }
+        }
+    }
+}
+
+
+const std::vector<ParticlePair>& VertexNeighborhoods::find_pairs(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>&,
+    const std::vector<int>& vertices_3D_active
+){
+    ++statistics.steps;
+    ++statistics.rebuilds;
+
+    candidate_pairs(vertices_3D_active, found_pairs);
+
+    return found_pairs;
+}
@@ -9,26 +9,24 @@
 #include <cstdint>
 #include <Eigen/Dense>
 #include <unordered_set>
-#include <boost/filesystem.hpp>
 
 #include <utilities/2D_3D_mapping.h>
 #include <utilities/barycentric_coord.h>
 
-const boost::filesystem::path PROJECT_PATH = PROJECT_SOURCE_DIR;
-
 // (2D Coordinates -> 3D Coordinates and Their Nearest 3D Vertice id (for the distance calculation on resimulations)) mapping
 std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
-    const Eigen::Matrix<double, Eigen::Dynamic, 2> r,
-    const Eigen::MatrixXd halfedges_uv,
-    const Eigen::MatrixXi faces_uv,
-    const Eigen::MatrixXd vertices_uv,
-    const Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXd& vertices_3D,
+    const std::vector<int64_t>& h_v_mapping
 ){
     int num_r = r.rows();
     Eigen::MatrixXd new_3D_points(num_r, 3);
     std::vector<int> nearest_vertices_ids(num_r);
 
+    #pragma omp parallel for schedule(dynamic, 16)
     for (int i = 0; i < num_r; ++i) {
         auto [barycentric_coord, nearest_vertex_id] = calculate_barycentric_3D_coord(r, halfedges_uv, faces_uv, vertices_uv, vertices_3D, h_v_mapping, i);
         new_3D_points.row(i) = barycentric_coord;
@@ -39,37 +37,59 @@ std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
 }
 
 
-// (3D Coordinates -> 2D Coordinates and Their Nearest 2D Vertice id) mapping
-Eigen::Matrix<double, Eigen::Dynamic, 2> get_r2d(
-    const Eigen::MatrixXd r,
-    const Eigen::MatrixXd vertices_uv,
-    const Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping
+// Same mapping, but the UV faces get located with the face grid of the simulation context instead of scanning all faces
+std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const SimulationContext& context
 ){
-    // ! TODO: This is a temporary solution. The mesh file path should be passed as an argument.
-    std::string mesh_3D_file_path = PROJECT_PATH.string() + "/meshes/ellipsoid_x4.off";
+    std::vector<int> particle_faces(r.rows(), -1);
+    return get_r3d(r, context, particle_faces);
+}
 
-    Eigen::MatrixXi faces_3D_static;
-    loadMeshFaces(mesh_3D_file_path, faces_3D_static);
 
+/**
+ * @param particle_faces UV face of each particle at the last call, -1 if unknown. Gets updated to the current faces.
+ *
+ * @brief Particles only move a fraction of a face per step, so they are found by walking from their last face
+ * to the adjacent faces. Only if the walk fails, the particle gets located with the face grid.
+*/
+std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const SimulationContext& context,
+    std::vector<int>& particle_faces
+){
     int num_r = r.rows();
-    Eigen::Matrix<double, Eigen::Dynamic, 2> new_2D_points(num_r, 2);
+    std::vector<int> nearest_vertices_ids(num_r);
 
+    // New particles start without a face
+    particle_faces.resize(num_r, -1);
+
+    #pragma omp parallel for schedule(static)
     for (int i = 0; i < num_r; ++i) {
-        Eigen::Vector3d uv_coord_test = calculate_barycentric_2D_coord(r, faces_3D_static, vertices_uv, vertices_3D, h_v_mapping, i);
-        Eigen::Vector2d uv_coord(uv_coord_test[0], uv_coord_test[1]);
+        const Eigen::Vector2d point = r.row(i).transpose();
 
-        new_2D_points.row(i) = uv_coord;
+        int face = -1;
+        if (particle_faces[i] >= 0) {
+            face = walk_to_face(point, particle_faces[i], context.uv_face_adjacency, context.halfedges_uv, context.faces_uv);
+        }
+        if (face < 0) {
+            face = context.uv_face_grid.nearest_face(point);
+        }
+        particle_faces[i] = face;
+        nearest_vertices_ids[i] = context.face_vertex_ids(face, context.uv_affine_maps.nearest_corner(point, face));
     }
 
-    return new_2D_points;
+    // Lift the particles with the affine map of their face
+    Eigen::MatrixXd new_3D_points = context.uv_affine_maps.lift(r, particle_faces);
+
+    return std::make_pair(new_3D_points, nearest_vertices_ids);
 }
 
 
 // (3D Vertice id -> 3D Vertice row position of the h-v map) mapping
 std::vector<int> find_vertice_rows_index(
-    std::vector<int64_t> h_v_mapping_vector,
-    std::vector<int> r3d_vertices
+    const std::vector<int64_t>& h_v_mapping_vector,
+    const std::vector<int>& r3d_vertices
 ){
     std::unordered_set<int> found_ids;
     std::vector<int> indices;
@@ -88,8 +108,8 @@ std::vector<int> find_vertice_rows_index(
 
 // (3D Vertice row position -> nD Vertice coordinates) mapping
 Eigen::MatrixXd get_coordinates(
-    std::vector<int> indices,
-    Eigen::MatrixXd coord
+    const std::vector<int>& indices,
+    const Eigen::MatrixXd& coord
 ){
     Eigen::MatrixXd found_coord(indices.size(), coord.cols());
 
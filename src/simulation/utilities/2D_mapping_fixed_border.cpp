@@ -3,6 +3,9 @@
 // license: Apache License 2.0
 // version: 0.1.0
 
+#include <string>
+#include <boost/filesystem.hpp>
+
 #include <utilities/2D_mapping_fixed_border.h>
 
 
@@ -39,7 +42,16 @@ int calculateSteepnessSwitch(double steepness) {
     return 0;
 }
 
-std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::Vector2d& pointA, const Eigen::Vector2d& point_outside, double n) {
+// The seam turns the flight direction by ±90 degrees, which rotates the unit vector without any trigonometry
+Eigen::Vector2d rotate_counterclockwise(const Eigen::Vector2d& n) {
+    return Eigen::Vector2d(-n[1], n[0]);
+}
+
+Eigen::Vector2d rotate_clockwise(const Eigen::Vector2d& n) {
+    return Eigen::Vector2d(n[1], -n[0]);
+}
+
+std::tuple<Eigen::Vector2d, Eigen::Vector2d, Eigen::Vector2d> processPoints(const Eigen::Vector2d& pointA, const Eigen::Vector2d& point_outside, Eigen::Vector2d n) {
     Eigen::Vector2d entry_angle(1, 1);
     Eigen::Vector2d entry_point(1, 1);
     Eigen::Vector2d new_point(2, 1);
@@ -64,7 +76,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
                 entry_angle.row(0) *= steepness_switch;  // has to be variable
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point - rotated_displacement;
-                n -= 90;
+                n = rotate_clockwise(n);
             }
             // obere Grenze passiert
             else {
@@ -80,7 +92,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
 
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point - rotated_displacement;
-                n += 90;
+                n = rotate_counterclockwise(n);
             }
         }
         // unten oder rechts
@@ -100,7 +112,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
                 entry_angle.row(0) *= steepness_switch;
                 Eigen::Vector2d rotated_displacement = displacement.array()  * entry_angle.array();
                 new_point = entry_point - rotated_displacement;
-                n -= 90;
+                n = rotate_clockwise(n);
             }
             // unten Grenze passiert
             else {
@@ -117,7 +129,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
 
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point + rotated_displacement;
-                n += 90;
+                n = rotate_counterclockwise(n);
             }
         }
         // oben oder links
@@ -136,7 +148,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
                 entry_angle.row(0) *= steepness_switch;
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point + rotated_displacement;
-                n -= 90;
+                n = rotate_clockwise(n);
             }
             // obere Grenze passiert
             else {
@@ -152,7 +164,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
                 entry_angle.row(1) *= steepness_switch;
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point - rotated_displacement;
-                n += 90;
+                n = rotate_counterclockwise(n);
             }
         }
         // unten oder links
@@ -173,7 +185,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
 
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point + rotated_displacement;
-                n -= 90;
+                n = rotate_clockwise(n);
             }
             // unten Grenze passiert
             else {
@@ -189,7 +201,7 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
                 entry_angle.row(1) *= steepness_switch;
                 Eigen::Vector2d rotated_displacement = displacement.array() * entry_angle.array();
                 new_point = entry_point + rotated_displacement;
-                n += 90;
+                n = rotate_counterclockwise(n);
             }
         }
     }
@@ -200,6 +212,19 @@ std::tuple<Eigen::Vector2d, double, Eigen::Vector2d> processPoints(const Eigen::
 }
 
 
+/**
+ * @brief Seam of the cached UV mesh, the UV mesh file name starts with the name of its 3D mesh
+ *
+ * ! TODO: try to find out why the mesh parametrization can result in different UV mapping logics
+ * ? is it because of the seam edge cut line?
+*/
+SeamType get_seam_type(const std::string& uv_mesh_path){
+    const std::string mesh_UV_name = boost::filesystem::path(uv_mesh_path).stem().string();
+
+    return mesh_UV_name.rfind("sphere_uv", 0) == 0 ? SeamType::Opposite : SeamType::Diagonal;
+}
+
+
 /**
  * @param r_UV_new new UV mesh coordinates
  *
@@ -214,14 +239,14 @@ void opposite_seam_edges_square_border(Eigen::Matrix<double, Eigen::Dynamic, 2>&
 /**
  * @param r_UV old UV mesh coordinates
  * @param r_UV_new new UV mesh coordinates
- * @param n_UV_new particle flight direction
+ * @param n_UV_new particle flight direction as unit vectors
  *
  * @brief By using the '&' we pass the reference of the variable to the function, so we can change the value of the variable inside the function
 */
 void diagonal_seam_edges_square_border(
     Eigen::Matrix<double, Eigen::Dynamic, 2> r_UV,
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r_UV_new,
-    Eigen::VectorXd& n_UV_new
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n_UV_new
 ){
     bool valid;
     do {
@@ -229,11 +254,11 @@ void diagonal_seam_edges_square_border(
         for (int i = 0; i < r_UV.rows(); ++i) {
             Eigen::Vector2d pointA = r_UV.row(i).head<2>(); // only takes the first two columns for the ith row
             Eigen::Vector2d point_outside = r_UV_new.row(i).head<2>(); // only takes the first two columns for the ith row
-            double n = n_UV_new(i);
+            Eigen::Vector2d n = n_UV_new.row(i);
 
             auto results = processPoints(pointA, point_outside, n);
             auto new_point = std::get<0>(results);
-            n_UV_new(i) = std::get<1>(results);
+            n_UV_new.row(i) = std::get<1>(results);
             auto entry_point = std::get<2>(results);
 
             // ! TODO: this logic can be improved
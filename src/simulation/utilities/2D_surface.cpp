@@ -5,9 +5,14 @@
 
 // known Issue: https://github.com/CGAL/cgal/issues/2994
 
+#include <algorithm>
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -25,14 +30,14 @@
 #include <CGAL/Surface_mesh_parameterization/parameterize.h>
 
 #include <io/csv.h>
+#include <io/mesh_loader.h>
+#include <io/precompute_cache.h>
 #include <utilities/mesh_descriptor.h>
 #include <utilities/2D_surface.h>
 
 namespace SMP = CGAL::Surface_mesh_parameterization;
 namespace fs = boost::filesystem;
 
-const fs::path PROJECT_PATH = PROJECT_SOURCE_DIR;
-const fs::path MESH_FOLDER = PROJECT_PATH  / "meshes";
 const unsigned int PARAMETERIZATION_ITERATIONS = 9;
 
 
@@ -64,32 +69,26 @@ std::string get_mesh_name(
 
 /**
  * @brief Save the generated UV mesh to a file
+ *
+ * The file is addressed by the content of the 3D mesh and the start vertex of the cut line,
+ * so that jobs on different meshes with the same name never overwrite each other's UV mesh.
 */
 int save_UV_mesh(
     UV::Mesh _mesh,
     UV::halfedge_descriptor _bhd,
     _3D::UV_pmap _uvmap,
     const std::string mesh_path,
-    int uv_mesh_number
+    int uv_mesh_number,
+    const std::string cache_root
 ){
-    // Get the mesh name without the extension
-    auto mesh_3D_name = get_mesh_name(mesh_path);
-
-    // Create the output file path based on uv_mesh_number
-    fs::path output_file_path;
-
-    if (uv_mesh_number == 0) {
-        output_file_path = MESH_FOLDER / (mesh_3D_name + "_uv.off");
-    } else {
-        output_file_path = MESH_FOLDER / (mesh_3D_name + "_uv_" + std::to_string(uv_mesh_number) + ".off");
-    }
-    std::string output_file_path_str = output_file_path.string();
+    std::string output_file_path_str = get_cache_path(mesh_path, "uv", "start_vertex=" + std::to_string(uv_mesh_number), ".off", cache_root);
 
-    // Create the output file stream
-    std::ofstream out(output_file_path_str);
-
-    // Write the UV map to the output file
+    // Write the UV map into a temporary file first, the rename makes it visible in one step
+    std::string temporary_file_path = temporary_cache_path(output_file_path_str);
+    std::ofstream out(temporary_file_path);
     SMP::IO::output_uvmap_to_off(_mesh, _bhd, _uvmap, out);
+    out.close();
+    commit_cache_file(temporary_file_path, output_file_path_str);
 
     // Store the file path as a meta data
     meshmeta.mesh_path = output_file_path_str;
@@ -265,6 +264,60 @@ SMP::Error_code parameterize_UV_mesh(
 }
 
 
+/**
+ * @brief Check that face f of the table is face f of the 3D mesh, with the same corners in the same orientation
+*/
+static void check_face_table(const _3D::Mesh& sm, const UVFaceTable& face_table, const std::string& mesh_file_path){
+    if (face_table.vertex_rows.rows() != static_cast<Eigen::Index>(num_faces(sm))) {
+        throw std::runtime_error("The UV face table of " + mesh_file_path + " has " + std::to_string(face_table.vertex_rows.rows())
+                                 + " faces, the 3D mesh has " + std::to_string(num_faces(sm)));
+    }
+
+    int face_row = 0;
+    for (_3D::face_descriptor fd : faces(sm)) {
+        int corner = 0;
+        for (_3D::halfedge_descriptor hd : halfedges_around_face(halfedge(fd, sm), sm)) {
+            if (corner >= 3 || face_table.vertex_ids(face_row, corner) != static_cast<int64_t>(target(hd, sm))) {
+                throw std::runtime_error("Face " + std::to_string(face_row) + " of the UV face table does not match the 3D mesh " + mesh_file_path);
+            }
+            ++corner;
+        }
+        if (corner != 3) {
+            throw std::runtime_error("Face " + std::to_string(face_row) + " of the 3D mesh " + mesh_file_path + " is not a triangle");
+        }
+        ++face_row;
+    }
+}
+
+
+/**
+ * @brief Check that every face of the table has the corners of the same face of the shared 3D mesh
+ *
+ * Assimp keeps the positions in single precision and may store each face corner as its own vertex,
+ * so the corners get compared by position up to float rounding. check_face_table already covers their orientation.
+*/
+static void check_face_positions(const MeshAsset& mesh_3D, const UVFaceTable& face_table, const Eigen::MatrixXd& vertices_3D, const std::string& mesh_file_path){
+    if (mesh_3D.faces.rows() != face_table.vertex_rows.rows()) {
+        throw std::runtime_error("The UV face table of " + mesh_file_path + " has " + std::to_string(face_table.vertex_rows.rows())
+                                 + " faces, the loaded mesh has " + std::to_string(mesh_3D.faces.rows()));
+    }
+
+    for (Eigen::Index f = 0; f < mesh_3D.faces.rows(); ++f) {
+        for (int corner = 0; corner < 3; ++corner) {
+            const Eigen::Vector3d position = vertices_3D.row(face_table.vertex_rows(f, corner));
+
+            double closest = std::numeric_limits<double>::infinity();
+            for (int c = 0; c < 3; ++c) {
+                closest = std::min(closest, (mesh_3D.vertices.row(mesh_3D.faces(f, c)).transpose() - position).norm());
+            }
+            if (closest > 1e-5 * (1 + position.norm())) {
+                throw std::runtime_error("Face " + std::to_string(f) + " of the UV face table does not lie on the loaded mesh " + mesh_file_path);
+            }
+        }
+    }
+}
+
+
 /**
  * @brief Calculate the UV coordinates of the 3D mesh and also return their mapping to the 3D coordinates
 */
@@ -273,7 +326,9 @@ std::vector<int64_t> calculate_uv_surface(
     _3D::vertex_descriptor start_node,
     int uv_mesh_number,
     Eigen::MatrixXd& vertices_UV,
-    Eigen::MatrixXd& vertices_3D
+    Eigen::MatrixXd& vertices_3D,
+    UVFaceTable& face_table,
+    const std::string cache_root
 ){
     // Load the 3D mesh
     _3D::Mesh sm;
@@ -296,21 +351,43 @@ std::vector<int64_t> calculate_uv_surface(
     SMP::Error_code err = parameterize_UV_mesh(mesh, bhd, uvmap);
 
     // Save the uv mesh
-    save_UV_mesh(mesh, bhd, uvmap, mesh_file_path, uv_mesh_number);
+    save_UV_mesh(mesh, bhd, uvmap, mesh_file_path, uv_mesh_number, cache_root);
 
     std::vector<Point_2> points_uv;
     std::vector<Point_3> points;
     std::vector<int64_t> h_v_mapping_vector;
+    std::map<UV::vertex_descriptor, int> vertex_rows;
     for (UV::vertex_descriptor vd : vertices(mesh)) {
         int64_t target_vertice = target(vd, sm);
         auto point_3D = sm.point(target(vd, sm));
         auto uv = get(uvmap, halfedge(vd, mesh));
 
+        vertex_rows[vd] = static_cast<int>(h_v_mapping_vector.size());
         h_v_mapping_vector.push_back(target_vertice);
         points.push_back(point_3D);
         points_uv.push_back(uv);
     }
 
+    // The corners of the faces as rows of the vertices, the seam mesh already tells the duplicates along the seam apart.
+    // The faces keep the order and orientation of the 3D mesh faces.
+    face_table.vertex_rows.resize(num_faces(mesh), 3);
+    face_table.vertex_ids.resize(num_faces(mesh), 3);
+    int face_row = 0;
+    for (UV::face_descriptor fd : faces(mesh)) {
+        int corner = 0;
+        for (UV::halfedge_descriptor hd : halfedges_around_face(halfedge(fd, mesh), mesh)) {
+            if (corner >= 3) {
+                throw std::runtime_error("The mesh " + mesh_file_path + " has a face with more than three corners");
+            }
+            const int row = vertex_rows.at(target(hd, mesh));
+            face_table.vertex_rows(face_row, corner) = row;
+            face_table.vertex_ids(face_row, corner) = h_v_mapping_vector[row];
+            ++corner;
+        }
+        ++face_row;
+    }
+    check_face_table(sm, face_table, mesh_file_path);
+
     vertices_3D.resize(points.size(), 3);
     vertices_UV.resize(points.size(), 3);
     for (size_t i = 0; i < points.size(); ++i)
@@ -333,22 +410,23 @@ std::vector<int64_t> calculate_uv_surface(
 /**
  * @brief Create the UV surface
 */
-std::tuple<std::vector<int64_t>, Eigen::MatrixXd, Eigen::MatrixXd, std::string> create_uv_surface(
+std::tuple<std::vector<int64_t>, Eigen::MatrixXd, Eigen::MatrixXd, std::string, UVFaceTable> create_uv_surface(
     std::string mesh_path,
-    int32_t start_node_int
+    int32_t start_node_int,
+    const std::string cache_root
 ){
-    // Load the 3D mesh
-    _3D::Mesh sm;
-    std::ifstream in(CGAL::data_file_path(mesh_path));
-    in >> sm;
+    // The shared view of the 3D mesh, every simulation on this mesh reuses its parse
+    std::shared_ptr<const MeshAsset> mesh_3D = load_mesh(mesh_path);
 
     _3D::vertex_descriptor start_node(start_node_int);
     Eigen::MatrixXd vertices_UV;
     Eigen::MatrixXd vertices_3D;
-    auto h_v_mapping_vector = calculate_uv_surface(mesh_path, start_node, start_node_int, vertices_UV, vertices_3D);
+    UVFaceTable face_table;
+    auto h_v_mapping_vector = calculate_uv_surface(mesh_path, start_node, start_node_int, vertices_UV, vertices_3D, face_table, cache_root);
+    check_face_positions(*mesh_3D, face_table, vertices_3D, mesh_path);
 
     std::string mesh_file_path = meshmeta.mesh_path;
 
-    return std::make_tuple(h_v_mapping_vector, vertices_UV, vertices_3D, mesh_file_path);
+    return std::make_tuple(h_v_mapping_vector, vertices_UV, vertices_3D, mesh_file_path, face_table);
 }
 
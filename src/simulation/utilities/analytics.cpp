@@ -11,13 +11,17 @@
 
 void calculate_order_parameter(
     Eigen::VectorXd& v_order, 
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r, 
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r_dot, 
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r_dot,
     int current_step
 ) {
     int num_part = r.rows();
-    // Define a vector normal to position vector and velocity vector
-    Eigen::MatrixXd v_tp = calculate_3D_cross_product(r, r_dot);
+    // Define a vector normal to position vector and velocity vector, the UV vectors lie in the z = 0 plane
+    Eigen::MatrixXd r_3D = Eigen::MatrixXd::Zero(num_part, 3);
+    Eigen::MatrixXd r_dot_3D = Eigen::MatrixXd::Zero(num_part, 3);
+    r_3D.leftCols(2) = r;
+    r_dot_3D.leftCols(2) = r_dot;
+    Eigen::MatrixXd v_tp = calculate_3D_cross_product(r_3D, r_dot_3D);
 
     // Normalize v_tp
     Eigen::MatrixXd v_norm = v_tp.rowwise().normalized();
@@ -32,4 +32,19 @@ Eigen::Matrix<double, Eigen::Dynamic, 2> angles_to_unit_vectors(const Eigen::Vec
     }
 
     return n_vec;
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Convert the 2D unit vectors back to angle degrees in the range [0, 360)
+*/
+Eigen::VectorXd unit_vectors_to_angles(const Eigen::Matrix<double, Eigen::Dynamic, 2>& n_vec) {
+    Eigen::VectorXd angles_degrees(n_vec.rows());
+
+    for (int i = 0; i < n_vec.rows(); ++i) {
+        double angle_degrees = std::atan2(n_vec(i, 1), n_vec(i, 0)) * 180.0 / M_PI;
+        angles_degrees(i) = angle_degrees < 0 ? angle_degrees + 360 : angle_degrees;
+    }
+
+    return angles_degrees;
+}
@@ -76,7 +76,7 @@ double pointTriangleDistance(
 int closestRow(const Eigen::MatrixXd& vertices_uv, const Eigen::Vector2d& halfedge_coord) {
     Eigen::VectorXd dists(vertices_uv.rows());
     for (int i = 0; i < vertices_uv.rows(); ++i) {
-        dists[i] = (vertices_uv.row(i) - halfedge_coord.transpose()).squaredNorm();
+        dists[i] = (vertices_uv.row(i).head<2>() - halfedge_coord.transpose()).squaredNorm();
     }
 
     Eigen::VectorXd::Index minRow;
@@ -86,13 +86,68 @@ int closestRow(const Eigen::MatrixXd& vertices_uv, const Eigen::Vector2d& halfed
 }
 
 
+/**
+ * @brief Interpolate the 3D point of the UV point with its barycentric coordinates on the UV face
+ *
+ * Same interpolation as the affine maps of the simulation context, so both paths lift a particle onto the same 3D point.
+ * A collapsed UV face maps every point onto its first corner.
+ * The returned vertex is the corner with the largest barycentric coordinate.
+ *
+ * @param rows rows of the face corners in vertices_3D
+ * @param vertex_ids 3D vertex ids of the face corners
+*/
+static std::pair<Eigen::Vector3d, int> interpolate_on_face(
+    const Eigen::Vector2d& point,
+    const Eigen::Vector2d& halfedge_a_coord,
+    const Eigen::Vector2d& halfedge_b_coord,
+    const Eigen::Vector2d& halfedge_c_coord,
+    const Eigen::Vector3i& rows,
+    const Eigen::Matrix<int64_t, 3, 1>& vertex_ids,
+    const Eigen::MatrixXd& vertices_3D
+){
+    // Get the 3D coordinates of the 3 halfedges
+    Eigen::Vector3d a = vertices_3D.row(rows[0]);
+    Eigen::Vector3d b = vertices_3D.row(rows[1]);
+    Eigen::Vector3d c = vertices_3D.row(rows[2]);
+
+    // Solve point = a + λ_b (b - a) + λ_c (c - a) in UV
+    Eigen::Matrix2d edges_uv;
+    edges_uv << halfedge_b_coord - halfedge_a_coord, halfedge_c_coord - halfedge_a_coord;
+    Eigen::Vector2d lambda = Eigen::Vector2d::Zero();
+    if (edges_uv.determinant() != 0) {
+        lambda = edges_uv.inverse() * (point - halfedge_a_coord);
+    }
+    Eigen::Vector3d barycentric(1 - lambda[0] - lambda[1], lambda[0], lambda[1]);
+
+    // Compute the new 3D point using the barycentric coordinates
+    Eigen::Vector3d newPoint = barycentric[0] * a + barycentric[1] * b + barycentric[2] * c;
+
+    // The particle belongs to the corner closest to the 3D point, the first one on a tie,
+    // like UVAffineMaps::nearest_corner, so the scan and the face walk of get_r3d pick the same vertex
+    const Eigen::Vector3d corners[3] = {a, b, c};
+    int closest_corner = 0;
+    double min_distance = (newPoint - a).squaredNorm();
+    for (int k = 1; k < 3; ++k) {
+        const double distance = (newPoint - corners[k]).squaredNorm();
+        if (distance < min_distance) {
+            min_distance = distance;
+            closest_corner = k;
+        }
+    }
+
+    int closest_vertice_id = vertex_ids[closest_corner];
+
+    return std::make_pair(newPoint, closest_vertice_id);
+}
+
+
 std::pair<Eigen::Vector3d, int>calculate_barycentric_3D_coord(
-    const Eigen::Matrix<double, Eigen::Dynamic, 2> r,
-    const Eigen::MatrixXd halfedges_uv,
-    const Eigen::MatrixXi faces_uv,
-    Eigen::MatrixXd vertices_uv,
-    Eigen::MatrixXd vertices_3D,
-    std::vector<int64_t> h_v_mapping,
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXd& vertices_3D,
+    const std::vector<int64_t>& h_v_mapping,
     int interator
 ){
     std::vector<std::pair<double, int>> distances(faces_uv.rows());
@@ -102,7 +157,8 @@ std::pair<Eigen::Vector3d, int>calculate_barycentric_3D_coord(
         Eigen::Vector3d uv_b = halfedges_uv.row(faces_uv(j, 1));
         Eigen::Vector3d uv_c = halfedges_uv.row(faces_uv(j, 2));
 
-        distances[j] = {pointTriangleDistance(r.row(interator).head(2), uv_a, uv_b, uv_c), j};
+        Eigen::Vector3d point(r(interator, 0), r(interator, 1), 0);
+        distances[j] = {pointTriangleDistance(point, uv_a, uv_b, uv_c), j};
     }
 
     std::pair<double, int> min_distance = *std::min_element(distances.begin(), distances.end());
@@ -111,51 +167,21 @@ std::pair<Eigen::Vector3d, int>calculate_barycentric_3D_coord(
     int halfedge_b = faces_uv(min_distance.second, 1);
     int halfedge_c = faces_uv(min_distance.second, 2);
 
-    Eigen::Vector2d halfedge_a_coord = halfedges_uv.row(halfedge_a);
-    Eigen::Vector2d halfedge_b_coord = halfedges_uv.row(halfedge_b);
-    Eigen::Vector2d halfedge_c_coord = halfedges_uv.row(halfedge_c);
+    Eigen::Vector2d halfedge_a_coord = halfedges_uv.row(halfedge_a).head<2>();
+    Eigen::Vector2d halfedge_b_coord = halfedges_uv.row(halfedge_b).head<2>();
+    Eigen::Vector2d halfedge_c_coord = halfedges_uv.row(halfedge_c).head<2>();
 
     // Inside your loop...
-    int closest_a = closestRow(vertices_uv, halfedge_a_coord);
-    int closest_b = closestRow(vertices_uv, halfedge_b_coord);
-    int closest_c = closestRow(vertices_uv, halfedge_c_coord);
-
-    // Get the 3D coordinates of the 3 halfedges
-    Eigen::Vector3d a = vertices_3D.row(closest_a);
-    Eigen::Vector3d b = vertices_3D.row(closest_b);
-    Eigen::Vector3d c = vertices_3D.row(closest_c);
-
-    // Compute the weights (distances in UV space)
-    double w_a = (r.row(interator).head(2).transpose() - halfedge_a_coord).norm();
-    double w_b = (r.row(interator).head(2).transpose() - halfedge_b_coord).norm();
-    double w_c = (r.row(interator).head(2).transpose() - halfedge_c_coord).norm();
-
-    // Compute the barycentric coordinates
-    double sum_weights = w_a + w_b + w_c;
-    w_a /= sum_weights;
-    w_b /= sum_weights;
-    w_c /= sum_weights;
-
-    // Compute the new 3D point using the barycentric coordinates
-    Eigen::Vector3d newPoint = w_a * a + w_b * b + w_c * c;
-
-    // Compute distances from newPoint to a, b, c
-    double dist_a = (newPoint - a).norm();
-    double dist_b = (newPoint - b).norm();
-    double dist_c = (newPoint - c).norm();
-
-    // Find the vertex with the minimum distance to newPoint
-    double min_dist = std::min({dist_a, dist_b, dist_c});
-
-    int closest_row_id;
-    if (min_dist == dist_a) closest_row_id = closest_a;
-    else if (min_dist == dist_b) closest_row_id = closest_b;
-    else closest_row_id = closest_c;
+    Eigen::Vector3i rows(
+        closestRow(vertices_uv, halfedge_a_coord),
+        closestRow(vertices_uv, halfedge_b_coord),
+        closestRow(vertices_uv, halfedge_c_coord)
+    );
 
     // Get the vertice of h_v_mapping
-    int closest_vertice_id = h_v_mapping[closest_row_id];
+    Eigen::Matrix<int64_t, 3, 1> vertex_ids(h_v_mapping[rows[0]], h_v_mapping[rows[1]], h_v_mapping[rows[2]]);
 
-    return std::make_pair(newPoint, closest_vertice_id);
+    return interpolate_on_face(r.row(interator).transpose(), halfedge_a_coord, halfedge_b_coord, halfedge_c_coord, rows, vertex_ids, vertices_3D);
 }
 
 
@@ -164,7 +190,7 @@ Eigen::Vector3d calculate_barycentric_2D_coord(
     const Eigen::MatrixXi& faces_3D_static,
     const Eigen::MatrixXd& vertices_UV,
     const Eigen::MatrixXd& vertices_3D,
-    std::vector<int64_t>& h_v_mapping,
+    const std::vector<int64_t>& h_v_mapping,
     int iterator
 ){
     std::vector<std::pair<double, int>> distances(faces_3D_static.rows());
@@ -0,0 +1,50 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-28
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <array>
+#include <cstdint>
+
+#include <utilities/counter_rng.h>
+
+
+std::array<uint32_t, 4> CounterRNG::philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    constexpr uint32_t M0 = 0xD2511F53;
+    constexpr uint32_t M1 = 0xCD9E8D57;
+    constexpr uint32_t W0 = 0x9E3779B9;
+    constexpr uint32_t W1 = 0xBB67AE85;
+
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t product0 = static_cast<uint64_t>(M0) * counter[0];
+        const uint64_t product1 = static_cast<uint64_t>(M1) * counter[2];
+
+        counter = {
+            static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<uint32_t>(product1),
+            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<uint32_t>(product0)
+        };
+
+        key[0] += W0;
+        key[1] += W1;
+    }
+
+    return counter;
+}
+
+
+std::array<double, 2> CounterRNG::uniform(RandomStream stream, uint32_t step, uint64_t id) const {
+    std::array<uint32_t, 4> bits = philox4x32(
+        {static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32), step, static_cast<uint32_t>(stream)},
+        {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+    );
+
+    // The upper 53 bits of each 64 bit word fill the mantissa of a double
+    auto to_unit_interval = [](uint32_t high, uint32_t low) {
+        const uint64_t word = (static_cast<uint64_t>(high) << 32) | low;
+        return (word >> 11) * 0x1.0p-53;
+    };
+
+    return {to_unit_interval(bits[0], bits[1]), to_unit_interval(bits[2], bits[3])};
+}
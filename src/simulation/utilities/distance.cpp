@@ -9,18 +9,42 @@ The heat method package returns an Approximation of the Geodesic Distance for al
 As a rule of thumb, the method works well on triangle meshes, which are Delaunay.
 
 Disclaimer: The heat method solver is the bottle neck of the algorithm.
+Therefore, the factorization of the heat method is reused for all source vertices of a thread.
+The batched heat method, which the full precomputation can use instead, solves whole blocks of source vertices at once.
 */
 
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/Heat_method_3/Surface_mesh_geodesic_distances_3.h>
+#include <CGAL/boost/graph/iterator.h>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <omp.h>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include <Eigen/Dense>
 
+#include <io/binary_matrix.h>
+#include <io/distance_shards.h>
+#include <io/precompute_cache.h>
+#include <io/row_checkpoint.h>
 #include <utilities/distance.h>
+#include <utilities/heat_method.h>
+
+namespace fs = boost::filesystem;
 
 using Kernel = CGAL::Simple_cartesian<double>;
 using Point_3 = Kernel::Point_3;
@@ -58,51 +82,401 @@ std::vector<double> geo_distance(const std::string mesh_path, int32_t start_node
 }
 
 
-/*
-atomic variable to keep track of the current index of the vector of distances, and each thread processes a
-different index until all the distances have been added to the distance matrix.
+Triangle_mesh load_triangle_mesh(const std::string& mesh_path){
+    std::ifstream filename(CGAL::data_file_path(mesh_path));
+    Triangle_mesh tm;
+    filename >> tm;
+
+    return tm;
+}
+
+
+/**
+ * @brief Number of vertices of the mesh, i.e. of rows and columns of its distance matrix
 */
-void fill_distance_matrix(
-    const std::string mesh_path,
-    Eigen::MatrixXd &distance_matrix,
-    int closest_vertice
-){
-    if (distance_matrix.row(closest_vertice).head(2).isZero()) {
-        // get the distance of all vertices to all other vertices
-        std::vector<double> vertices_3D_distance_map = geo_distance(mesh_path, closest_vertice);
-        distance_matrix.row(closest_vertice) = Eigen::Map<Eigen::VectorXd>(vertices_3D_distance_map.data(), vertices_3D_distance_map.size());
+int get_mesh_vertex_count(const std::string mesh_path){
+    return num_vertices(load_triangle_mesh(mesh_path));
+}
+
+
+/**
+ * @brief Vertex positions and triangle indices of the mesh, indexed like the vertex descriptors
+*/
+std::pair<Eigen::MatrixXd, Eigen::MatrixXi> get_vertices_and_faces(const Triangle_mesh& tm){
+    Eigen::MatrixXd vertices_3D(num_vertices(tm), 3);
+    for (vertex_descriptor vd : vertices(tm)) {
+        const Point_3& point = tm.point(vd);
+        vertices_3D.row(vd.idx()) << point.x(), point.y(), point.z();
     }
+
+    Eigen::MatrixXi faces_3D(num_faces(tm), 3);
+    int face_id = 0;
+    for (auto fd : faces(tm)) {
+        int corner = 0;
+        for (vertex_descriptor vd : CGAL::vertices_around_face(tm.halfedge(fd), tm)) {
+            faces_3D(face_id, corner++) = vd.idx();
+        }
+        ++face_id;
+    }
+
+    return std::make_pair(vertices_3D, faces_3D);
 }
 
 
-int get_all_distances(std::string mesh_path){
-    std::cout << mesh_path << std::endl;
-    std::string mesh_name = mesh_path.substr(mesh_path.find_last_of("/\\") + 1);
-    mesh_name = mesh_name.substr(0, mesh_name.find_last_of("."));
+/**
+ * @brief Calculate the geodesic distances of the source vertices to all vertices and hand each row to the row handler
+ *
+ * Intrinsic Delaunay heat method (HeatMethodVariant::IntrinsicDelaunay):
+ * Every OpenMP thread builds a single CGAL heat method object on its own copy of the mesh,
+ * so the cotan Laplacian and the heat flow system get factorized once per thread instead of once per source vertex.
+ * Afterwards each thread only swaps the source vertex.
+ *
+ * Batched heat method (HeatMethodVariant::Batched):
+ * The systems get factorized only once and the threads solve blocks of block_size sources as dense right hand side matrices.
+ * It works on the cotan Laplacian of the mesh itself, so its distances differ slightly on meshes with non-Delaunay edges.
+ * With a finite cutoff every source only gets solved on the patch of the mesh within twice the cutoff along the mesh
+ * edges instead, so the time per row no longer grows with the mesh size. The rows are infinity beyond the cutoff.
+ * Nearby sources of a block share their patch, so consecutive source ids make up for larger blocks.
+ *
+ * The handler gets called concurrently, but never twice for the same row.
+*/
+template <typename RowHandler>
+void calculate_distance_rows(const Triangle_mesh& tm, const std::vector<int>& source_ids, HeatMethodVariant heat_method, int block_size, double cutoff, RowHandler handle_row){
+    if (heat_method == HeatMethodVariant::Batched && block_size < 1) {
+        throw std::invalid_argument("The batched heat method needs at least one source per block");
+    }
+
+    const int num_vertices_3D = num_vertices(tm);
+    const int num_sources = source_ids.size();
+
+    int num_threads = 1;
+    auto start = std::chrono::steady_clock::now();
+
+    auto solve_blocks = [&](const auto& solver) {
+        #pragma omp parallel
+        {
+            #pragma omp single
+            num_threads = omp_get_num_threads();
+
+            std::vector<double> distances(num_vertices_3D);
+
+            #pragma omp for schedule(dynamic, 1)
+            for (int block_start = 0; block_start < num_sources; block_start += block_size) {
+                const int block_end = std::min(block_start + block_size, num_sources);
+                std::vector<int> block_ids(source_ids.begin() + block_start, source_ids.begin() + block_end);
+
+                Eigen::MatrixXd block_distances = solver.distances(block_ids);
+
+                for (int k = 0; k < block_end - block_start; ++k) {
+                    std::copy(block_distances.col(k).data(), block_distances.col(k).data() + num_vertices_3D, distances.begin());
+                    handle_row(block_ids[k], distances);
+                }
+            }
+        }
+    };
+
+    if (heat_method == HeatMethodVariant::Batched) {
+        auto [vertices_3D, faces_3D] = get_vertices_and_faces(tm);
 
+        if (std::isinf(cutoff)) {
+            solve_blocks(HeatMethodSolver(vertices_3D, faces_3D));
+        }
+        else {
+            solve_blocks(TruncatedHeatMethodSolver(vertices_3D, faces_3D, cutoff));
+        }
+    }
+    else {
+        #pragma omp parallel
+        {
+            #pragma omp single
+            num_threads = omp_get_num_threads();
+
+            // Each thread works on its own mesh copy, as the heat method attaches property maps to the mesh
+            Triangle_mesh tm_thread = tm;
+            Vertex_distance_map vertex_distance = tm_thread.add_property_map<vertex_descriptor, double>("v:distance", 0).first;
+
+            // The factorization happens here, in the constructor of the heat method
+            Heat_method hm_idt(tm_thread);
+            std::vector<double> distances(num_vertices_3D);
+
+            #pragma omp for schedule(dynamic, 16)
+            for (int i = 0; i < num_sources; ++i) {
+                hm_idt.clear_sources();
+                hm_idt.add_source(vertex_descriptor(source_ids[i]));
+                hm_idt.estimate_geodesic_distances(vertex_distance);
+
+                for (vertex_descriptor vd : vertices(tm_thread)) {
+                    distances[vd.idx()] = get(vertex_distance, vd);
+                }
+                handle_row(source_ids[i], distances);
+            }
+        }
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Calculated " << num_sources << " distance rows on " << num_threads << " threads in " << duration.count() << " seconds ("
+              << num_sources / duration.count() << " rows/s)" << std::endl;
+}
+
+
+/**
+ * @brief Distance rows of the given source vertices, e.g. to benchmark the per source against the batched heat method
+*/
+RowMajorMatrixXd get_distance_rows(const std::string mesh_path, const std::vector<int>& source_ids, HeatMethodVariant heat_method, int block_size){
     std::ifstream filename(CGAL::data_file_path(mesh_path));
     Triangle_mesh tm;
     filename >> tm;
 
-    Eigen::MatrixXd distance_matrix_v(num_vertices(tm), num_vertices(tm));
-    // ! dieser Schritt ist der Bottleneck der Simulation!
-    // ! wir müssen nämlich n mal die geo distance ausrechnen und die kostet jeweils min 25ms pro Start Vertex
-    // loop over all vertices and fill the distance matrix
-    for (auto vi = vertices(tm).first; vi != vertices(tm).second; ++vi) {
-        fill_distance_matrix(mesh_path, distance_matrix_v, *vi);
+    RowMajorMatrixXd distance_rows(source_ids.size(), num_vertices(tm));
+    std::unordered_map<int, int> source_rows;
+    for (size_t i = 0; i < source_ids.size(); ++i) {
+        source_rows[source_ids[i]] = i;
+    }
+
+    calculate_distance_rows(tm, source_ids, heat_method, block_size, std::numeric_limits<double>::infinity(), [&](int source_id, const std::vector<double>& distances) {
+        std::copy(distances.begin(), distances.end(), distance_rows.row(source_rows.at(source_id)).data());
+    });
+
+    return distance_rows;
+}
+
+
+/**
+ * @brief Calculate the distance rows of the given blocks and checkpoint every completed block
+ *
+ * All rows are solved in one go, so the heat method gets factorized only once per thread.
+ * The thread, which finishes the last row of a block, writes the block, so the heat method keeps running on all threads.
+*/
+template <typename RowStore>
+void calculate_checkpointed_distance_rows(const Triangle_mesh& tm, HeatMethodVariant heat_method, int block_size, double cutoff, RowCheckpoint& checkpoint, const std::vector<int>& block_ids, RowStore& store){
+    std::vector<int> source_ids;
+    std::vector<std::atomic<int>> remaining_rows(checkpoint.num_blocks());
+
+    for (int block_id : block_ids) {
+        remaining_rows[block_id] = checkpoint.block_size(block_id);
+        for (int i = 0; i < checkpoint.block_size(block_id); ++i) {
+            source_ids.push_back(checkpoint.block_start(block_id) + i);
+        }
+    }
+    if (source_ids.empty()) {
+        return;
+    }
+
+    const int block_rows = checkpoint.block_size(0);
+    calculate_distance_rows(tm, source_ids, heat_method, block_size, cutoff, [&](int source_id, const std::vector<double>& distances) {
+        store.set(source_id, distances);
+
+        const int block_id = source_id / block_rows;
+        if (--remaining_rows[block_id] == 0) {
+            store.save_block(checkpoint, block_id);
+            store.release(checkpoint.block_start(block_id), checkpoint.block_size(block_id));
+        }
+    });
+}
+
+
+// Mesh and factorized heat method of a row solver, the heat method keeps a reference to the mesh
+struct HeatMethodRowSolver {
+    Triangle_mesh tm;
+    Vertex_distance_map vertex_distance;
+    std::unique_ptr<Heat_method> hm_idt;
+};
+
+
+// Idle row solvers, every concurrent solve takes its own one, so each one gets factorized at most once per thread
+struct HeatMethodRowSolverPool {
+    Triangle_mesh tm;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<HeatMethodRowSolver>> idle;
+
+    std::unique_ptr<HeatMethodRowSolver> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                std::unique_ptr<HeatMethodRowSolver> solver = std::move(idle.back());
+                idle.pop_back();
+                return solver;
+            }
+        }
+
+        // The factorization happens here, in the constructor of the heat method
+        auto solver = std::make_unique<HeatMethodRowSolver>();
+        solver->tm = tm;
+        solver->vertex_distance = solver->tm.add_property_map<vertex_descriptor, double>("v:distance", 0).first;
+        solver->hm_idt = std::make_unique<Heat_method>(solver->tm);
+        return solver;
+    }
+
+    void release(std::unique_ptr<HeatMethodRowSolver> solver) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(solver));
     }
+};
+
+
+/**
+ * @brief Distance rows of the mesh, which get computed with the heat method the first time their vertex becomes active
+ *
+ * The simulation can start right away without the precomputed distance matrix.
+ * The lazy distance rows solve different rows concurrently, so every concurrent solve gets its own heat method.
+ * The heat methods get reused, so each one gets factorized only once.
+*/
+std::shared_ptr<LazyDistanceRows> make_lazy_distance_rows(
+    const std::string mesh_path,
+    size_t max_bytes,
+    std::string spill_directory
+){
+    auto pool = std::make_shared<HeatMethodRowSolverPool>();
+
+    std::ifstream filename(CGAL::data_file_path(mesh_path));
+    filename >> pool->tm;
+
+    auto solve_row = [pool](int source_id) {
+        std::unique_ptr<HeatMethodRowSolver> solver = pool->acquire();
+
+        solver->hm_idt->clear_sources();
+        solver->hm_idt->add_source(vertex_descriptor(source_id));
+        solver->hm_idt->estimate_geodesic_distances(solver->vertex_distance);
+
+        std::vector<double> distances(num_vertices(solver->tm));
+        for (vertex_descriptor vd : vertices(solver->tm)) {
+            distances[vd.idx()] = get(solver->vertex_distance, vd);
+        }
 
-    // save the distance matrix to a csv file using comma as delimiter
-    const static Eigen::IOFormat CSVFormat(Eigen::StreamPrecision, Eigen::DontAlignCols, ", ", "\n");
+        pool->release(std::move(solver));
+        return distances;
+    };
+
+    // The spill key names the spill files after the mesh content and the solver, so meshes can share a spill directory
+    const uint64_t spill_key = cache_key(file_checksum(mesh_path), "distance_rows", "heat_method=cgal_idt");
+    return std::make_shared<LazyDistanceRows>(num_vertices(pool->tm), solve_row, max_bytes, spill_directory, spill_key);
+}
+
+
+/**
+ * @brief Path of the binary distance matrix cache file of the mesh
+ *
+ * The file is addressed by the mesh content and every parameter, which changes the stored values:
+ * storage precision, cutoff and heat method variant. With a cutoff the batched heat method solves on patches around
+ * the sources, which gets its own key. The block size of the batched heat method does not change the values.
+*/
+std::string get_distance_matrix_path(const std::string mesh_path, MatrixDtype dtype, double cutoff, HeatMethodVariant heat_method, const std::string cache_root){
+    std::ostringstream parameters;
+    parameters << std::setprecision(17)
+               << "dtype=" << dtype_name(dtype)
+               << ";cutoff=" << cutoff
+               << ";heat_method=" << (heat_method == HeatMethodVariant::IntrinsicDelaunay ? "cgal_idt" : std::isinf(cutoff) ? "batched_direct" : "patch_direct");
+
+    return get_cache_path(mesh_path, "distance_matrix", parameters.str(), ".bin", cache_root);
+}
+
+
+template <typename RowStore>
+void precompute_distances(const Triangle_mesh& tm, const std::string& mesh_path, RowStore& store, MatrixDtype dtype, double cutoff, HeatMethodVariant heat_method, int block_size, const std::string& cache_root, int checkpoint_rows){
+    const int num_vertices_3D = num_vertices(tm);
+    const uint64_t mesh_checksum = file_checksum(mesh_path);
+
+    // save the distance matrix as binary file, which can be memory mapped by the simulation without parsing
+    std::string distance_matrix_path = get_distance_matrix_path(mesh_path, dtype, cutoff, heat_method, cache_root);
+    RowCheckpoint checkpoint(distance_matrix_path + ".checkpoint", mesh_checksum, num_vertices_3D, num_vertices_3D, checkpoint_rows);
+
+    // Another job might have finished the cache file, while this one waited for the lock of the checkpoint
+    if (is_valid_binary_matrix(distance_matrix_path, mesh_checksum, dtype, cutoff)) {
+        checkpoint.remove();
+        std::cout << "The distance matrix got precomputed by another job: " << distance_matrix_path << std::endl;
+        return;
+    }
+
+    std::vector<int> pending_blocks = checkpoint.pending_blocks();
+    std::vector<int> completed_blocks = checkpoint.completed_blocks();
+    if (!completed_blocks.empty()) {
+        std::cout << "Resuming the distance precomputation with " << pending_blocks.size() << " of " << checkpoint.num_blocks() << " blocks left" << std::endl;
+    }
 
-    const boost::filesystem::path PROJECT_PATH = PROJECT_SOURCE_DIR;
+    load_checkpointed_rows(checkpoint, completed_blocks, store);
+    calculate_checkpointed_distance_rows(tm, heat_method, block_size, cutoff, checkpoint, pending_blocks, store);
+    save_distance_rows(distance_matrix_path, store, mesh_checksum, dtype, cutoff);
 
-    std::cout << "Saving distance matrix to file..." << std::endl;
-    std::string distance_matrix_path = PROJECT_PATH.string() + "/meshes/data/" + mesh_name + "_distance_matrix_static.csv";
-    std::ofstream file(distance_matrix_path);
-    file << distance_matrix_v.format(CSVFormat);
-    file.close();
+    checkpoint.remove();
     std::cout << "saved" << std::endl;
+}
+
+
+/**
+ * @brief Precompute the distance matrix of the mesh and save it into the cache
+ *
+ * The rows get checkpointed in blocks of checkpoint_rows next to the cache file, so an interrupted precomputation
+ * resumes from its last completed block. The checkpoint gets removed once the cache file is written.
+ * A second job on the same cache file waits for the lock of the checkpoint and then finds the finished cache file.
+*/
+int get_all_distances(std::string mesh_path, MatrixDtype dtype, double cutoff, HeatMethodVariant heat_method, int block_size, const std::string cache_root, int checkpoint_rows){
+    std::cout << mesh_path << std::endl;
+    Triangle_mesh tm = load_triangle_mesh(mesh_path);
+
+    if (std::isinf(cutoff)) {
+        DenseRowStore store(num_vertices(tm));
+        precompute_distances(tm, mesh_path, store, dtype, cutoff, heat_method, block_size, cache_root, checkpoint_rows);
+    }
+    else {
+        SparseRowStore store(num_vertices(tm), cutoff);
+        precompute_distances(tm, mesh_path, store, dtype, cutoff, heat_method, block_size, cache_root, checkpoint_rows);
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Compute the rows of one shard of the distance matrix, independent of all other shards
+ *
+ * Shard k of n owns the k-th of n contiguous ranges of row blocks and checkpoints them into its own directory
+ * next to the cache file. The shards share nothing but the mesh file, so they can run as separate processes
+ * or batch jobs. A restarted shard resumes from its last completed block.
+ * The rows are kept at full precision and only truncated to the cutoff, the merge quantizes them to the dtype.
+*/
+int compute_distance_shard(std::string mesh_path, int shard, int num_shards, MatrixDtype dtype, double cutoff, HeatMethodVariant heat_method, int block_size, const std::string cache_root, int checkpoint_rows){
+    if (num_shards <= 0 || shard < 0 || shard >= num_shards) {
+        throw std::invalid_argument("The shard has to be in the range [0, " + std::to_string(num_shards) + ")");
+    }
+
+    Triangle_mesh tm = load_triangle_mesh(mesh_path);
+    const int num_vertices_3D = num_vertices(tm);
+
+    std::string distance_matrix_path = get_distance_matrix_path(mesh_path, dtype, cutoff, heat_method, cache_root);
+    const uint64_t mesh_checksum = file_checksum(mesh_path);
+    RowCheckpoint checkpoint(get_distance_shard_path(distance_matrix_path, shard, num_shards), mesh_checksum, num_vertices_3D, num_vertices_3D, checkpoint_rows);
+
+    // The shards got merged already, e.g. by a rerun of the array job
+    if (is_valid_binary_matrix(distance_matrix_path, mesh_checksum, dtype, cutoff)) {
+        checkpoint.remove();
+        std::cout << "The distance matrix got merged already: " << distance_matrix_path << std::endl;
+        return 0;
+    }
+
+    std::vector<int> pending_blocks;
+    for (int block_id : checkpoint.shard_blocks(shard, num_shards)) {
+        if (!checkpoint.is_complete(block_id)) {
+            pending_blocks.push_back(block_id);
+        }
+    }
+    std::cout << "Shard " << shard << " of " << num_shards << ": " << pending_blocks.size() << " of "
+              << checkpoint.shard_blocks(shard, num_shards).size() << " blocks left" << std::endl;
+
+    ShardRowStore store(num_vertices_3D, cutoff);
+    calculate_checkpointed_distance_rows(tm, heat_method, block_size, cutoff, checkpoint, pending_blocks, store);
+
+    return 0;
+}
+
+
+/**
+ * @brief Assemble the cache file out of all shards of the mesh
+*/
+int merge_distance_shards(std::string mesh_path, int num_shards, MatrixDtype dtype, double cutoff, HeatMethodVariant heat_method, const std::string cache_root, int checkpoint_rows){
+    const int num_vertices_3D = get_mesh_vertex_count(mesh_path);
+    std::string distance_matrix_path = get_distance_matrix_path(mesh_path, dtype, cutoff, heat_method, cache_root);
+
+    merge_distance_shard_files(distance_matrix_path, file_checksum(mesh_path), num_vertices_3D, num_shards, dtype, cutoff, checkpoint_rows);
 
     return 0;
 }
@@ -0,0 +1,190 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-20
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance_matrix.h>
+
+
+/**
+ * @brief Symmetrize the matrix with the same minimum rule as the precomputation
+ *
+ * Without a cutoff the packed upper triangle is kept, otherwise only the sparse rows of the pairs within the cutoff.
+*/
+DistanceMatrix::DistanceMatrix(const Eigen::MatrixXd& matrix, MatrixDtype dtype, double cutoff) {
+    BinaryMatrixHeader header{};
+    header.dtype = static_cast<uint32_t>(dtype);
+    header.rows = matrix.rows();
+    header.cols = matrix.cols();
+    header.cutoff = cutoff;
+
+    std::shared_ptr<std::vector<char>> buffer;
+    if (std::isinf(cutoff)) {
+        std::vector<double> packed_values = pack_symmetric_upper(matrix);
+
+        header.layout = static_cast<uint32_t>(MatrixLayout::PackedUpper);
+        header.nonzeros = packed_values.size();
+        header.scale = quantization_scale(packed_values, dtype);
+
+        buffer = std::make_shared<std::vector<char>>(packed_values.size() * dtype_size(dtype));
+        encode_values(packed_values, dtype, header.scale, buffer->data());
+    }
+    else {
+        SparseMatrixCSR sparse_matrix = truncate_symmetric(matrix, cutoff);
+
+        header.layout = static_cast<uint32_t>(MatrixLayout::SparseCSR);
+        header.nonzeros = sparse_matrix.values.size();
+        header.scale = quantization_scale(sparse_matrix.values, dtype);
+
+        buffer = std::make_shared<std::vector<char>>(sparse_payload_bytes(sparse_matrix, dtype));
+        encode_sparse_matrix(sparse_matrix, dtype, header.scale, buffer->data());
+    }
+
+    attach(buffer->data(), header);
+    storage = buffer;
+}
+
+
+/**
+ * @brief Memory map the binary distance matrix file instead of parsing it
+*/
+DistanceMatrix DistanceMatrix::load(const std::string& path) {
+    auto mapping = std::make_shared<MemoryMappedFile>(path);
+
+    BinaryMatrixHeader header;
+    if (mapping->size() < sizeof(header)) {
+        throw std::runtime_error("The distance matrix file is too small: " + path);
+    }
+    std::memcpy(&header, mapping->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, BINARY_MATRIX_MAGIC, sizeof(header.magic)) != 0 || header.version != BINARY_MATRIX_VERSION) {
+        throw std::runtime_error("Unknown distance matrix file format: " + path);
+    }
+    if (header.dtype > static_cast<uint32_t>(MatrixDtype::UInt16)) {
+        throw std::runtime_error("Unsupported distance matrix dtype: " + path);
+    }
+    if (header.layout > static_cast<uint32_t>(MatrixLayout::SparseCSR) || header.rows != header.cols) {
+        throw std::runtime_error("Unsupported distance matrix layout: " + path);
+    }
+    MatrixDtype dtype = static_cast<MatrixDtype>(header.dtype);
+
+    size_t expected_bytes = 0;
+    if (static_cast<MatrixLayout>(header.layout) == MatrixLayout::SparseCSR) {
+        expected_bytes = sparse_values_offset(header.rows, header.nonzeros) + header.nonzeros * dtype_size(dtype);
+    }
+    else {
+        expected_bytes = packed_upper_size(header.rows) * dtype_size(dtype);
+    }
+
+    if (header.payload_bytes != expected_bytes || mapping->size() < sizeof(header) + header.payload_bytes) {
+        throw std::runtime_error("The distance matrix file is truncated: " + path);
+    }
+
+    DistanceMatrix distance_matrix;
+    distance_matrix.attach(mapping->data() + sizeof(header), header);
+    distance_matrix.storage = mapping;
+
+    if (distance_matrix.value_layout == MatrixLayout::SparseCSR && distance_matrix.row_offsets[header.rows] != static_cast<int64_t>(header.nonzeros)) {
+        throw std::runtime_error("The sparse distance matrix file is corrupted: " + path);
+    }
+
+    return distance_matrix;
+}
+
+
+/**
+ * @brief Point the lookup at the payload described by the header
+*/
+void DistanceMatrix::attach(const char* payload, const BinaryMatrixHeader& header) {
+    num_vertices = header.rows;
+    value_dtype = static_cast<MatrixDtype>(header.dtype);
+    value_layout = static_cast<MatrixLayout>(header.layout);
+    scale = header.scale;
+    cutoff_distance = header.cutoff;
+
+    if (value_layout == MatrixLayout::SparseCSR) {
+        row_offsets = reinterpret_cast<const int64_t*>(payload);
+        col_indices = reinterpret_cast<const int32_t*>(payload + (header.rows + 1) * sizeof(int64_t));
+        values = payload + sparse_values_offset(header.rows, header.nonzeros);
+    }
+    else {
+        values = payload;
+    }
+}
+
+
+int64_t DistanceMatrix::nonzeros() const {
+    if (value_layout == MatrixLayout::SparseCSR) {
+        return row_offsets[num_vertices];
+    }
+    return packed_upper_size(num_vertices);
+}
+
+
+Eigen::MatrixXd DistanceMatrix::distances_between(const std::vector<int>& vertex_ids) const {
+    const int num_ids = vertex_ids.size();
+    Eigen::MatrixXd distances(num_ids, num_ids);
+
+    for (int i = 0; i < num_ids; ++i) {
+        for (int j = 0; j < num_ids; ++j) {
+            distances(i, j) = (*this)(vertex_ids[i], vertex_ids[j]);
+        }
+    }
+
+    return distances;
+}
+
+
+std::vector<double> DistanceMatrix::distances_of_pairs(const std::vector<int>& vertex_ids, const std::vector<ParticlePair>& pairs) const {
+    std::vector<double> distances(pairs.size());
+
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        distances[p] = (*this)(vertex_ids[pairs[p].first], vertex_ids[pairs[p].second]);
+    }
+
+    return distances;
+}
+
+
+Eigen::VectorXd DistanceMatrix::row(int row) const {
+    Eigen::VectorXd distances(num_vertices);
+
+    for (int col = 0; col < num_vertices; ++col) {
+        distances(col) = (*this)(row, col);
+    }
+
+    return distances;
+}
+
+
+/**
+ * @brief Vertices within the cutoff, the sparse layout only has to look at the stored pairs of the row
+*/
+std::vector<int> DistanceMatrix::vertices_within(int row, double cutoff) const {
+    std::vector<int> vertex_ids;
+
+    if (value_layout == MatrixLayout::SparseCSR) {
+        for (int64_t index = row_offsets[row]; index < row_offsets[row + 1]; ++index) {
+            if (value_at(index) <= cutoff) {
+                vertex_ids.push_back(col_indices[index]);
+            }
+        }
+        return vertex_ids;
+    }
+
+    for (int col = 0; col < num_vertices; ++col) {
+        if ((*this)(row, col) <= cutoff) {
+            vertex_ids.push_back(col);
+        }
+    }
+    return vertex_ids;
+}
@@ -0,0 +1,338 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-22
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <Eigen/Dense>
+
+#include <io/precompute_cache.h>
+#include <utilities/distance_provider.h>
+
+namespace fs = boost::filesystem;
+
+
+std::vector<int> DistanceProvider::vertices_within(int row, double cutoff) const {
+    Eigen::VectorXd distances = this->row(row);
+
+    std::vector<int> vertex_ids;
+    for (int vertex_id = 0; vertex_id < distances.size(); ++vertex_id) {
+        if (distances(vertex_id) <= cutoff) {
+            vertex_ids.push_back(vertex_id);
+        }
+    }
+    return vertex_ids;
+}
+
+
+LazyDistanceRows::LazyDistanceRows(
+    int num_vertices,
+    DistanceRowSolver solve_row,
+    size_t max_bytes,
+    std::string spill_directory,
+    uint64_t spill_key
+) :
+    num_vertices(num_vertices),
+    solve_row(std::move(solve_row)),
+    spill_directory(std::move(spill_directory)),
+    spill_key(spill_key)
+{
+    if (num_vertices <= 0) {
+        throw std::invalid_argument("The lazy distance rows need at least one vertex");
+    }
+
+    // Keep at least a single row, otherwise every lookup would recompute its row
+    max_rows = std::max<size_t>(1, max_bytes / (num_vertices * sizeof(double)));
+
+    if (!this->spill_directory.empty()) {
+        fs::create_directories(this->spill_directory);
+    }
+}
+
+
+/**
+ * @brief Rows of the distinct vertices, the missing rows get solved in parallel
+ *
+ * The returned rows stay alive even if the cache evicts them, so the lookup may exceed the byte budget.
+*/
+std::unordered_map<int, LazyDistanceRows::Row> LazyDistanceRows::get_rows(const std::vector<int>& vertex_ids) const {
+    std::vector<int> distinct_ids = vertex_ids;
+    std::sort(distinct_ids.begin(), distinct_ids.end());
+    distinct_ids.erase(std::unique(distinct_ids.begin(), distinct_ids.end()), distinct_ids.end());
+
+    std::vector<Row> distinct_rows(distinct_ids.size());
+    std::exception_ptr error;
+
+    #pragma omp parallel for schedule(dynamic, 1) if(distinct_ids.size() > 1)
+    for (size_t i = 0; i < distinct_ids.size(); ++i) {
+        try {
+            distinct_rows[i] = get_row(distinct_ids[i]);
+        }
+        catch (...) {
+            #pragma omp critical
+            error = std::current_exception();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::unordered_map<int, Row> rows;
+    for (size_t i = 0; i < distinct_ids.size(); ++i) {
+        rows.emplace(distinct_ids[i], std::move(distinct_rows[i]));
+    }
+    return rows;
+}
+
+
+/**
+ * @brief Distances between all pairs of the given vertices
+ *
+ * Every distinct vertex needs its row only once. The rows stay alive for the whole lookup,
+ * even if the cache has to evict them in between because of a small byte budget.
+*/
+Eigen::MatrixXd LazyDistanceRows::distances_between(const std::vector<int>& vertex_ids) const {
+    std::unordered_map<int, Row> rows = get_rows(vertex_ids);
+
+    const int num_ids = vertex_ids.size();
+    Eigen::MatrixXd distances(num_ids, num_ids);
+
+    for (int i = 0; i < num_ids; ++i) {
+        const std::vector<double>& row_i = *rows[vertex_ids[i]];
+
+        for (int j = i; j < num_ids; ++j) {
+            const std::vector<double>& row_j = *rows[vertex_ids[j]];
+            distances(i, j) = distances(j, i) = std::min(row_i[vertex_ids[j]], row_j[vertex_ids[i]]);
+        }
+    }
+
+    return distances;
+}
+
+
+/**
+ * @brief Distances of the candidate pairs, only the rows of the vertices in a pair get loaded or computed
+*/
+std::vector<double> LazyDistanceRows::distances_of_pairs(const std::vector<int>& vertex_ids, const std::vector<ParticlePair>& pairs) const {
+    std::vector<int> pair_vertices;
+    pair_vertices.reserve(2 * pairs.size());
+    for (const auto& [i, j] : pairs) {
+        pair_vertices.push_back(vertex_ids[i]);
+        pair_vertices.push_back(vertex_ids[j]);
+    }
+    std::unordered_map<int, Row> rows = get_rows(pair_vertices);
+
+    std::vector<double> distances(pairs.size());
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        const int vertex_i = vertex_ids[pairs[p].first];
+        const int vertex_j = vertex_ids[pairs[p].second];
+        distances[p] = std::min((*rows.at(vertex_i))[vertex_j], (*rows.at(vertex_j))[vertex_i]);
+    }
+
+    return distances;
+}
+
+
+Eigen::VectorXd LazyDistanceRows::row(int row) const {
+    Row distances = get_row(row);
+
+    return Eigen::Map<const Eigen::VectorXd>(distances->data(), distances->size());
+}
+
+
+size_t LazyDistanceRows::cached_rows() const {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return cache.size();
+}
+
+
+size_t LazyDistanceRows::cached_bytes() const {
+    return cached_rows() * num_vertices * sizeof(double);
+}
+
+
+/**
+ * @brief Return the cached row or load or compute it, and evict the least recently used rows above the budget
+ *
+ * The row gets marked as in flight and solved without the lock, the threads waiting for it get woken up afterwards.
+ * The evicted rows get spilled without the lock as well, until then a lookup takes them back from the spill queue.
+*/
+LazyDistanceRows::Row LazyDistanceRows::get_row(int vertex_id) const {
+    if (vertex_id < 0 || vertex_id >= num_vertices) {
+        throw std::out_of_range("The vertex id is not part of the mesh: " + std::to_string(vertex_id));
+    }
+
+    std::unique_lock<std::mutex> lock(cache_mutex);
+
+    while (true) {
+        auto it = cache.find(vertex_id);
+        if (it != cache.end()) {
+            lru_order.splice(lru_order.begin(), lru_order, it->second.second);
+            return it->second.first;
+        }
+        if (rows_in_flight.count(vertex_id) == 0) break;
+
+        row_finished.wait(lock);
+    }
+
+    Row distances;
+    bool computed = false;
+    auto spilling = rows_in_spill.find(vertex_id);
+    if (spilling != rows_in_spill.end()) {
+        distances = spilling->second;
+    }
+    else {
+        rows_in_flight.insert(vertex_id);
+        lock.unlock();
+
+        try {
+            distances = load_spilled_row(vertex_id);
+            if (!distances) {
+                distances = std::make_shared<const std::vector<double>>(solve_row(vertex_id));
+                computed = true;
+
+                if (distances->size() != static_cast<size_t>(num_vertices)) {
+                    throw std::runtime_error("The distance row solver returned a row of the wrong size");
+                }
+            }
+        }
+        catch (...) {
+            lock.lock();
+            rows_in_flight.erase(vertex_id);
+            row_finished.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        rows_in_flight.erase(vertex_id);
+    }
+    if (computed) ++num_computed;
+
+    lru_order.push_front(vertex_id);
+    cache.emplace(vertex_id, std::make_pair(distances, lru_order.begin()));
+
+    // A row, which another thread is still spilling, needs no second write
+    std::vector<std::pair<int, Row>> evicted_rows;
+    while (cache.size() > max_rows) {
+        auto evicted = cache.find(lru_order.back());
+        if (!spill_directory.empty() && rows_in_spill.emplace(evicted->first, evicted->second.first).second) {
+            evicted_rows.emplace_back(evicted->first, evicted->second.first);
+        }
+        cache.erase(evicted);
+        lru_order.pop_back();
+    }
+    row_finished.notify_all();
+    lock.unlock();
+
+    std::exception_ptr error;
+    for (const auto& [evicted_id, evicted_row] : evicted_rows) {
+        try {
+            spill_row(evicted_id, *evicted_row);
+        }
+        catch (...) {
+            if (!error) error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> spill_lock(cache_mutex);
+        rows_in_spill.erase(evicted_id);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return distances;
+}
+
+
+/**
+ * @brief Spill file of the row, named by the spill key, so that the rows of different keys never replace each other
+*/
+std::string LazyDistanceRows::spill_path(int vertex_id) const {
+    std::ostringstream file_name;
+    file_name << "distance_row_" << std::hex << std::setw(16) << std::setfill('0') << spill_key
+              << "_" << std::dec << vertex_id << ".bin";
+
+    return (fs::path(spill_directory) / file_name.str()).string();
+}
+
+
+LazyDistanceRows::Row LazyDistanceRows::load_spilled_row(int vertex_id) const {
+    if (spill_directory.empty()) {
+        return nullptr;
+    }
+
+    std::ifstream file(spill_path(vertex_id), std::ios::binary);
+    if (!file.is_open() || !read_spill_header(file)) {
+        return nullptr;
+    }
+
+    auto distances = std::make_shared<std::vector<double>>(num_vertices);
+    file.read(reinterpret_cast<char*>(distances->data()), num_vertices * sizeof(double));
+
+    // A truncated spill file gets ignored and the row recomputed
+    if (file.gcount() != static_cast<std::streamsize>(num_vertices * sizeof(double))) {
+        return nullptr;
+    }
+
+    return distances;
+}
+
+
+/**
+ * @brief Check, that the spill file has the own key and vertex count, a damaged or foreign file gets recomputed
+*/
+bool LazyDistanceRows::read_spill_header(std::istream& file) const {
+    uint64_t file_key = 0;
+    int64_t file_num_vertices = 0;
+    file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+    file.read(reinterpret_cast<char*>(&file_num_vertices), sizeof(file_num_vertices));
+
+    return file.good() && file_key == spill_key && file_num_vertices == num_vertices;
+}
+
+
+/**
+ * @brief Write the evicted row into the spill directory, rows already on disk are not written again
+ *
+ * A spill file with another header gets replaced.
+*/
+void LazyDistanceRows::spill_row(int vertex_id, const std::vector<double>& distances) const {
+    if (spill_directory.empty()) {
+        return;
+    }
+
+    const std::string path = spill_path(vertex_id);
+    std::ifstream existing_file(path, std::ios::binary);
+    if (existing_file.is_open() && read_spill_header(existing_file)) {
+        return;
+    }
+    existing_file.close();
+
+    // Write into a temporary file first, so that an interrupted write never leaves a truncated row behind
+    const std::string temporary_path = temporary_cache_path(path);
+    const int64_t header_num_vertices = num_vertices;
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&spill_key), sizeof(spill_key));
+    file.write(reinterpret_cast<const char*>(&header_num_vertices), sizeof(header_num_vertices));
+    file.write(reinterpret_cast<const char*>(distances.data()), distances.size() * sizeof(double));
+    file.close();
+
+    if (!file.good()) {
+        fs::remove(temporary_path);
+        throw std::runtime_error("Failed to spill the distance row: " + path);
+    }
+    commit_cache_file(temporary_path, path);
+    ++num_spilled;
+}
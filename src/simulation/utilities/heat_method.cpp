@@ -0,0 +1,484 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-24
+// license: Apache License 2.0
+// version: 0.1.0
+
+/*
+Heat method after Crane et al. (2013), "Geodesics in Heat":
+1. Integrate the heat flow (M + t L) u = δ for a short time t
+2. Normalize the negative gradient of u per face: X = -∇u / |∇u|
+3. Solve the Poisson equation L φ = ∇·X and shift φ, so that the smallest distance is zero
+
+L is the positive semi-definite cotan Laplacian, which is built as G^T A G out of the per face gradient operator G
+and the face areas A. Therefore the divergence is G^T A as well and all operators stay consistent with each other.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+#include <utilities/heat_method.h>
+
+
+std::string heat_method_name(HeatMethodVariant variant) {
+    switch (variant) {
+        case HeatMethodVariant::IntrinsicDelaunay: return "idt";
+        case HeatMethodVariant::Batched: return "batched";
+    }
+    throw std::invalid_argument("Unknown heat method variant");
+}
+
+
+HeatMethodVariant parse_heat_method(const std::string& name) {
+    for (HeatMethodVariant variant : {HeatMethodVariant::IntrinsicDelaunay, HeatMethodVariant::Batched}) {
+        if (heat_method_name(variant) == name) {
+            return variant;
+        }
+    }
+    throw std::invalid_argument("Unknown heat method: " + name + " (expected idt or batched)");
+}
+
+
+HeatMethodSolver::HeatMethodSolver(const Eigen::MatrixXd& vertices, const Eigen::MatrixXi& faces, double time_factor) {
+    const int num_v = vertices.rows();
+    const int num_f = faces.rows();
+    if (num_v == 0 || num_f == 0) {
+        throw std::invalid_argument("The heat method needs a mesh with vertices and faces");
+    }
+
+    std::vector<Eigen::Triplet<double>> gradient_entries;
+    gradient_entries.reserve(9 * num_f);
+    Eigen::VectorXd face_area_stacked = Eigen::VectorXd::Zero(3 * num_f);
+    mass = Eigen::VectorXd::Zero(num_v);
+
+    for (int f = 0; f < num_f; ++f) {
+        const Eigen::Vector3d p[3] = {vertices.row(faces(f, 0)), vertices.row(faces(f, 1)), vertices.row(faces(f, 2))};
+
+        Eigen::Vector3d normal = (p[1] - p[0]).cross(p[2] - p[0]);
+        const double double_area = normal.norm();
+
+        // Degenerated faces have no gradient
+        if (double_area <= 0) continue;
+        normal /= double_area;
+
+        for (int corner = 0; corner < 3; ++corner) {
+            // The gradient of the hat function points from the opposite edge towards the corner
+            Eigen::Vector3d opposite_edge = p[(corner + 2) % 3] - p[(corner + 1) % 3];
+            Eigen::Vector3d hat_gradient = normal.cross(opposite_edge) / double_area;
+
+            for (int c = 0; c < 3; ++c) {
+                gradient_entries.emplace_back(3 * f + c, faces(f, corner), hat_gradient(c));
+            }
+            mass(faces(f, corner)) += double_area / 6;
+        }
+        face_area_stacked.segment<3>(3 * f).setConstant(double_area / 2);
+    }
+
+    gradient.resize(3 * num_f, num_v);
+    gradient.setFromTriplets(gradient_entries.begin(), gradient_entries.end());
+
+    divergence = gradient.transpose() * face_area_stacked.asDiagonal();
+    Eigen::SparseMatrix<double> laplacian = divergence * gradient;
+
+    // Time step of the heat flow: squared mean edge length
+    const double h = mean_edge_length(vertices, faces);
+    const double t = time_factor * h * h;
+
+    Eigen::SparseMatrix<double> heat_operator = t * laplacian;
+    heat_operator += Eigen::SparseMatrix<double>(mass.asDiagonal());
+    heat_factor = factorize(heat_operator);
+
+    // The Laplacian is singular (constant functions), so vertex 0 gets pinned for the Poisson equation
+    Eigen::SparseMatrix<double> poisson_operator = laplacian;
+    poisson_operator.prune([](int row, int col, double) { return row != 0 && col != 0; });
+    poisson_operator.coeffRef(0, 0) = 1.0;
+    poisson_factor = factorize(poisson_operator);
+}
+
+
+/**
+ * @brief Mean edge length of the mesh, the interior edges count twice like in the time step of Crane et al.
+*/
+double HeatMethodSolver::mean_edge_length(const Eigen::MatrixXd& vertices, const Eigen::MatrixXi& faces) {
+    double edge_length_sum = 0;
+    for (int f = 0; f < faces.rows(); ++f) {
+        for (int corner = 0; corner < 3; ++corner) {
+            edge_length_sum += (vertices.row(faces(f, corner)) - vertices.row(faces(f, (corner + 1) % 3))).norm();
+        }
+    }
+
+    return edge_length_sum / (3.0 * faces.rows());
+}
+
+
+HeatMethodSolver::LDLTFactor HeatMethodSolver::factorize(const Eigen::SparseMatrix<double>& matrix) {
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(matrix);
+    if (solver.info() != Eigen::Success) {
+        throw std::runtime_error("Failed to factorize the heat method systems");
+    }
+
+    LDLTFactor factor;
+    factor.L = solver.matrixL();
+    factor.D = solver.vectorD();
+    factor.P = solver.permutationP();
+    factor.P_inverse = solver.permutationPinv();
+
+    return factor;
+}
+
+
+/**
+ * @brief Solve A X = B for all columns of the block at once
+ *
+ * Eigen solves a dense right hand side column by column and thus traverses the factor once per column.
+ * Here every nonzero of L gets loaded once and updates a whole contiguous row of the row major block.
+*/
+void HeatMethodSolver::solve_in_place(const LDLTFactor& factor, RowMajorBlock& block) {
+    const Eigen::SparseMatrix<double>& L = factor.L;
+    block = factor.P * block;
+
+    // L Y = P B
+    for (Eigen::Index j = 0; j < L.outerSize(); ++j) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(L, j); it; ++it) {
+            if (it.row() > j) {
+                block.row(it.row()) -= it.value() * block.row(j);
+            }
+        }
+    }
+
+    // D Z = Y
+    for (Eigen::Index i = 0; i < block.rows(); ++i) {
+        block.row(i) /= factor.D(i);
+    }
+
+    // L^T X = Z
+    for (Eigen::Index j = L.outerSize() - 1; j >= 0; --j) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(L, j); it; ++it) {
+            if (it.row() > j) {
+                block.row(j) -= it.value() * block.row(it.row());
+            }
+        }
+    }
+
+    block = factor.P_inverse * block;
+}
+
+
+/**
+ * @brief Geodesic distances to a block of source vertices
+*/
+Eigen::MatrixXd HeatMethodSolver::distances(const std::vector<int>& source_ids) const {
+    const int num_v = num_vertices();
+    const int block_size = source_ids.size();
+
+    RowMajorBlock heat = RowMajorBlock::Zero(num_v, block_size);
+    for (int k = 0; k < block_size; ++k) {
+        if (source_ids[k] < 0 || source_ids[k] >= num_v) {
+            throw std::out_of_range("The source vertex is not part of the mesh");
+        }
+        heat(source_ids[k], k) = 1.0;
+    }
+
+    // 1. Heat flow of all sources of the block
+    solve_in_place(heat_factor, heat);
+
+    // 2. Normalized negative gradient per face, the stacked rows 3f, 3f+1 and 3f+2 are one face vector
+    RowMajorBlock field = gradient * heat;
+    for (Eigen::Index f = 0; f < field.rows(); f += 3) {
+        auto face_vectors = field.middleRows<3>(f);
+        Eigen::RowVectorXd norms = face_vectors.colwise().norm();
+
+        for (int k = 0; k < block_size; ++k) {
+            face_vectors.col(k) *= norms(k) > 0 ? -1.0 / norms(k) : 0.0;
+        }
+    }
+
+    // 3. Poisson equation with the divergence of the field
+    RowMajorBlock distances = divergence * field;
+    distances.row(0).setZero();
+    solve_in_place(poisson_factor, distances);
+
+    for (int k = 0; k < block_size; ++k) {
+        distances.col(k).array() -= distances.col(k).minCoeff();
+    }
+
+    return distances;
+}
+
+
+TruncatedHeatMethodSolver::TruncatedHeatMethodSolver(
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& faces,
+    double cutoff,
+    double patch_factor,
+    double time_factor
+) :
+    vertices(vertices),
+    faces(faces),
+    cutoff(cutoff),
+    time_factor(time_factor)
+{
+    if (!(cutoff > 0) || !std::isfinite(cutoff)) {
+        throw std::invalid_argument("The truncated heat method needs a finite, positive cutoff");
+    }
+    if (patch_factor < 1) {
+        throw std::invalid_argument("The patch has to reach at least as far as the cutoff");
+    }
+    if (vertices.rows() == 0 || faces.rows() == 0) {
+        throw std::invalid_argument("The heat method needs a mesh with vertices and faces");
+    }
+    mean_edge_length = HeatMethodSolver::mean_edge_length(vertices, faces);
+
+    const int num_v = vertices.rows();
+    std::vector<std::vector<std::pair<int, double>>> edges(num_v);
+    std::vector<std::vector<int>> faces_around(num_v);
+    double max_edge_length = 0;
+
+    for (int f = 0; f < faces.rows(); ++f) {
+        for (int corner = 0; corner < 3; ++corner) {
+            const int a = faces(f, corner);
+            const int b = faces(f, (corner + 1) % 3);
+            const double length = (vertices.row(a) - vertices.row(b)).norm();
+
+            // Interior edges show up in both of their faces, the duplicates do not change the Dijkstra distances
+            edges[a].emplace_back(b, length);
+            edges[b].emplace_back(a, length);
+            faces_around[a].push_back(f);
+            max_edge_length = std::max(max_edge_length, length);
+        }
+    }
+
+    // The patch needs at least the faces around the source, even for a cutoff below the edge length
+    patch_radius = std::max(patch_factor * cutoff, 2 * max_edge_length);
+
+    edge_offsets.assign(1, 0);
+    face_offsets.assign(1, 0);
+    for (int v = 0; v < num_v; ++v) {
+        for (const auto& [target, length] : edges[v]) {
+            edge_targets.push_back(target);
+            edge_lengths.push_back(length);
+        }
+        vertex_faces.insert(vertex_faces.end(), faces_around[v].begin(), faces_around[v].end());
+        edge_offsets.push_back(edge_targets.size());
+        face_offsets.push_back(vertex_faces.size());
+    }
+}
+
+
+/**
+ * @brief Vertices within the radius of the source along the mesh edges (Dijkstra), ordered by their edge distance
+*/
+std::vector<std::pair<int, double>> TruncatedHeatMethodSolver::edge_ball(int source_id, double radius) const {
+    if (source_id < 0 || source_id >= num_vertices()) {
+        throw std::out_of_range("The source vertex is not part of the mesh");
+    }
+
+    std::unordered_map<int, double> edge_distance {{source_id, 0.0}};
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+    queue.emplace(0.0, source_id);
+
+    std::vector<std::pair<int, double>> ball;
+    while (!queue.empty()) {
+        const auto [distance, v] = queue.top();
+        queue.pop();
+        if (distance > edge_distance.at(v)) continue;
+
+        ball.emplace_back(v, distance);
+        for (int e = edge_offsets[v]; e < edge_offsets[v + 1]; ++e) {
+            const double next_distance = distance + edge_lengths[e];
+            if (next_distance > radius) continue;
+
+            auto [it, inserted] = edge_distance.try_emplace(edge_targets[e], next_distance);
+            if (inserted || next_distance < it->second) {
+                it->second = next_distance;
+                queue.emplace(next_distance, edge_targets[e]);
+            }
+        }
+    }
+
+    return ball;
+}
+
+
+std::vector<int> TruncatedHeatMethodSolver::patch_vertices(int source_id) const {
+    std::vector<int> patch;
+    for (const auto& [v, distance] : edge_ball(source_id, patch_radius)) {
+        patch.push_back(v);
+    }
+    return patch;
+}
+
+
+/**
+ * @brief Solve the heat method of a group of sources on one shared patch and write their distances into the columns
+ *
+ * The patch starts with the first source and has to cover the patch radius around every source of the group.
+*/
+void TruncatedHeatMethodSolver::solve_group(
+    const std::vector<int>& patch,
+    const std::vector<int>& group_sources,
+    const std::vector<int>& group_columns,
+    Eigen::MatrixXd& block
+) const {
+    if (2 * patch.size() > static_cast<size_t>(num_vertices())) {
+        std::call_once(whole_mesh_once, [this]() {
+            whole_mesh_solver = std::make_unique<HeatMethodSolver>(vertices, faces, time_factor);
+        });
+        Eigen::MatrixXd whole_mesh_distances = whole_mesh_solver->distances(group_sources);
+        ++num_group_solves;
+        for (size_t k = 0; k < group_sources.size(); ++k) {
+            for (int v = 0; v < num_vertices(); ++v) {
+                if (whole_mesh_distances(v, k) <= cutoff) {
+                    block(v, group_columns[k]) = whole_mesh_distances(v, k);
+                }
+            }
+        }
+        return;
+    }
+
+    std::unordered_map<int, int> patch_ids;
+    for (size_t i = 0; i < patch.size(); ++i) {
+        patch_ids.emplace(patch[i], i);
+    }
+
+    // Faces with all corners in the patch, each one gets added at its corner with the smallest patch id
+    std::vector<std::vector<int>> patch_faces_around(patch.size());
+    std::vector<Eigen::Vector3i> patch_faces;
+    for (size_t i = 0; i < patch.size(); ++i) {
+        for (int e = face_offsets[patch[i]]; e < face_offsets[patch[i] + 1]; ++e) {
+            const int f = vertex_faces[e];
+            Eigen::Vector3i corners;
+            bool inside = true;
+            for (int corner = 0; corner < 3 && inside; ++corner) {
+                auto it = patch_ids.find(faces(f, corner));
+                inside = it != patch_ids.end();
+                if (inside) corners(corner) = it->second;
+            }
+
+            if (inside && corners.minCoeff() == static_cast<int>(i)) {
+                for (int corner = 0; corner < 3; ++corner) {
+                    patch_faces_around[corners(corner)].push_back(patch_faces.size());
+                }
+                patch_faces.push_back(corners);
+            }
+        }
+    }
+
+    // Only the faces connected to the first source belong to the solve, the Laplacian of other components would be singular
+    std::vector<int> local_ids(patch.size(), -1);
+    std::vector<int> local_vertices {0};
+    local_ids[0] = 0;
+    for (size_t next = 0; next < local_vertices.size(); ++next) {
+        for (int f : patch_faces_around[local_vertices[next]]) {
+            for (int corner = 0; corner < 3; ++corner) {
+                const int v = patch_faces[f](corner);
+                if (local_ids[v] < 0) {
+                    local_ids[v] = local_vertices.size();
+                    local_vertices.push_back(v);
+                }
+            }
+        }
+    }
+
+    Eigen::MatrixXd local_positions(local_vertices.size(), 3);
+    for (size_t i = 0; i < local_vertices.size(); ++i) {
+        local_positions.row(i) = vertices.row(patch[local_vertices[i]]);
+    }
+
+    std::vector<Eigen::Vector3i> local_faces;
+    for (const Eigen::Vector3i& corners : patch_faces) {
+        if (local_ids[corners(0)] >= 0) {
+            local_faces.emplace_back(local_ids[corners(0)], local_ids[corners(1)], local_ids[corners(2)]);
+        }
+    }
+    Eigen::MatrixXi local_face_matrix(local_faces.size(), 3);
+    for (size_t f = 0; f < local_faces.size(); ++f) {
+        local_face_matrix.row(f) = local_faces[f].transpose();
+    }
+
+    // A source outside of the component of the first one gets solved on its own patch
+    std::vector<int> local_sources;
+    std::vector<int> local_columns;
+    for (size_t k = 0; k < group_sources.size(); ++k) {
+        const int local_id = local_ids[patch_ids.at(group_sources[k])];
+        if (local_id >= 0) {
+            local_sources.push_back(local_id);
+            local_columns.push_back(group_columns[k]);
+        }
+        else {
+            solve_group(patch_vertices(group_sources[k]), {group_sources[k]}, {group_columns[k]}, block);
+        }
+    }
+
+    // All sources of the group are one block of the solve, the time factor keeps the time step of the whole mesh
+    const double local_mean_edge_length = HeatMethodSolver::mean_edge_length(local_positions, local_face_matrix);
+    const double local_time_factor = time_factor * std::pow(mean_edge_length / local_mean_edge_length, 2);
+    Eigen::MatrixXd local_distances = HeatMethodSolver(local_positions, local_face_matrix, local_time_factor).distances(local_sources);
+    ++num_group_solves;
+
+    for (size_t k = 0; k < local_sources.size(); ++k) {
+        for (size_t i = 0; i < local_vertices.size(); ++i) {
+            if (local_distances(i, k) <= cutoff) {
+                block(patch[local_vertices[i]], local_columns[k]) = local_distances(i, k);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Truncated geodesic distances to a block of source vertices
+ *
+ * The patch radius is patch_factor times the cutoff, but at least two edge lengths, so the distances up to the cutoff
+ * stay away from the patch border. The sources within half of the patch radius of a first source form a group.
+ * The group gets solved as one block on the patch around the first source.
+ * That patch grows by twice the distance to the farthest source of the group. Growing it by this distance once
+ * would already contain the patch radius around every source. The sources off the center still lost accuracy near
+ * the patch border that way, so the patch grows by the distance twice. A source without a group keeps its own patch.
+*/
+Eigen::MatrixXd TruncatedHeatMethodSolver::distances(const std::vector<int>& source_ids) const {
+    Eigen::MatrixXd block = Eigen::MatrixXd::Constant(num_vertices(), source_ids.size(), std::numeric_limits<double>::infinity());
+    std::vector<bool> solved(source_ids.size(), false);
+    const double group_radius = patch_radius / 2;
+
+    for (size_t first = 0; first < source_ids.size(); ++first) {
+        if (solved[first]) continue;
+
+        std::vector<std::pair<int, double>> ball = edge_ball(source_ids[first], patch_radius + 2 * group_radius);
+        std::unordered_map<int, double> edge_distance(ball.begin(), ball.end());
+
+        std::vector<int> group_sources;
+        std::vector<int> group_columns;
+        double group_extent = 0;
+        for (size_t k = first; k < source_ids.size(); ++k) {
+            auto it = edge_distance.find(source_ids[k]);
+            if (!solved[k] && it != edge_distance.end() && it->second <= group_radius) {
+                group_sources.push_back(source_ids[k]);
+                group_columns.push_back(k);
+                group_extent = std::max(group_extent, it->second);
+                solved[k] = true;
+            }
+        }
+
+        // The ball is ordered by the edge distance, so the patch is a prefix of it
+        std::vector<int> patch;
+        for (const auto& [v, distance] : ball) {
+            if (distance > patch_radius + 2 * group_extent) break;
+            patch.push_back(v);
+        }
+
+        solve_group(patch, group_sources, group_columns, block);
+    }
+
+    return block;
+}
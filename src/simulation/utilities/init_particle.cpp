@@ -5,8 +5,9 @@
 
 #include <iostream>
 #include <Eigen/Dense>
-#include <random>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
 
 #include <utilities/init_particle.h>
 
@@ -31,20 +32,17 @@ void init_particle_position(
     const Eigen::MatrixXd halfedges_uv,
     int num_part,
     Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
-    Eigen::VectorXd& n
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
+    const CounterRNG& rng
 ) {
     int faces_length = faces_uv.rows();
     std::vector<int> faces_list(faces_length);
     std::iota(faces_list.begin(), faces_list.end(), 1);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(-1.0, 1.0);
-    std::uniform_int_distribution<> dis_face(0, faces_length - 1);
-    std::uniform_int_distribution<> dis_angle(0, 359);
-
     for (int i = 0; i < num_part; ++i) {
-        int random_face = dis_face(gen);
+        // Random face and whole degree angle of the particle, reproducible by the seed
+        auto [u_face, u_angle] = rng.uniform(RandomStream::InitialParticles, 0, i);
+        int random_face = static_cast<int>(u_face * faces_length);
         auto it = std::find(faces_list.begin(), faces_list.end(), random_face);
         if (it != faces_list.end()) {
             faces_list.erase(it);
@@ -53,6 +51,8 @@ void init_particle_position(
         Eigen::Vector3i r_face_uv = faces_uv.row(random_face);
         r.row(i) = get_face_gravity_center_coord(halfedges_uv, r_face_uv);
 
-        n.row(i) << dis_angle(gen);
+        // The orientation is a unit vector, the angle degrees are only drawn here
+        double angle_radians = std::floor(u_angle * 360) * M_PI / 180.0;
+        n.row(i) << std::cos(angle_radians), std::sin(angle_radians);
     }
 }
\ No newline at end of file
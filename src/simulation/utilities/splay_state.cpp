@@ -93,7 +93,7 @@ std::tuple<Eigen::Matrix<double, Eigen::Dynamic, 2>, std::vector<int>> get_splay
 
 
 std::vector<int> get_3D_splay_vertices(
-    Eigen::MatrixXd distance_matrix,
+    const DistanceMatrix& distance_matrix,
     int number_vertices
 ){
     std::vector<int> selected_vertices;
@@ -0,0 +1,156 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-28
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/uv_affine_maps.h>
+
+
+UVAffineMaps::UVAffineMaps(
+    const Eigen::MatrixXd& vertices_uv,
+    const Eigen::MatrixXi& face_vertex_rows,
+    const Eigen::MatrixXd& vertices_3D
+){
+    if (vertices_uv.rows() != vertices_3D.rows()) {
+        throw std::invalid_argument("The UV and the 3D vertices need the same rows");
+    }
+
+    const int num_faces = face_vertex_rows.rows();
+    lift_maps.resize(num_faces, 9);
+    barycentric_maps.resize(num_faces, 6);
+    inverse_jacobians.resize(num_faces, 6);
+    corners_3D.resize(num_faces, 9);
+
+    #pragma omp parallel for schedule(static)
+    for (int f = 0; f < num_faces; ++f) {
+        const Eigen::Vector2d uv_a = vertices_uv.row(face_vertex_rows(f, 0)).head<2>();
+        const Eigen::Vector2d uv_b = vertices_uv.row(face_vertex_rows(f, 1)).head<2>();
+        const Eigen::Vector2d uv_c = vertices_uv.row(face_vertex_rows(f, 2)).head<2>();
+        const Eigen::Vector3d a = vertices_3D.row(face_vertex_rows(f, 0)).head<3>();
+        const Eigen::Vector3d b = vertices_3D.row(face_vertex_rows(f, 1)).head<3>();
+        const Eigen::Vector3d c = vertices_3D.row(face_vertex_rows(f, 2)).head<3>();
+
+        Eigen::Matrix2d edges_uv;
+        edges_uv << uv_b - uv_a, uv_c - uv_a;
+        Eigen::Matrix<double, 3, 2> edges_3D;
+        edges_3D << b - a, c - a;
+
+        // A collapsed UV face maps every point onto its first corner
+        Eigen::Matrix2d inverse_edges_uv = Eigen::Matrix2d::Zero();
+        if (edges_uv.determinant() != 0) {
+            inverse_edges_uv = edges_uv.inverse();
+        }
+
+        const Eigen::Matrix<double, 3, 2> jacobian = edges_3D * inverse_edges_uv;
+        const Eigen::Vector3d offset = a - jacobian * uv_a;
+
+        // The tangent plane of a collapsed 3D face has no inverse, its velocities map to zero
+        Eigen::Matrix<double, 2, 3> inverse_jacobian = Eigen::Matrix<double, 2, 3>::Zero();
+        const Eigen::Matrix2d metric = jacobian.transpose() * jacobian;
+        if (metric.determinant() > 0) {
+            inverse_jacobian = metric.inverse() * jacobian.transpose();
+        }
+
+        lift_maps.row(f) << jacobian.row(0), jacobian.row(1), jacobian.row(2), offset.transpose();
+        barycentric_maps.row(f) << inverse_edges_uv.row(0), inverse_edges_uv.row(1), uv_a.transpose();
+        inverse_jacobians.row(f) << inverse_jacobian.row(0), inverse_jacobian.row(1);
+        corners_3D.row(f) << a.transpose(), b.transpose(), c.transpose();
+    }
+}
+
+
+Eigen::Vector3d UVAffineMaps::lift(const Eigen::Vector2d& point, int face) const {
+    const double* m = lift_maps.row(face).data();
+    return Eigen::Vector3d(
+        m[0] * point.x() + m[1] * point.y() + m[6],
+        m[2] * point.x() + m[3] * point.y() + m[7],
+        m[4] * point.x() + m[5] * point.y() + m[8]
+    );
+}
+
+
+Eigen::MatrixXd UVAffineMaps::lift(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r, const std::vector<int>& faces) const {
+    const int num_part = r.rows();
+    Eigen::MatrixXd r_3D(num_part, 3);
+
+    const double* u = r.col(0).data();
+    const double* v = r.col(1).data();
+    double* x = r_3D.col(0).data();
+    double* y = r_3D.col(1).data();
+    double* z = r_3D.col(2).data();
+    const double* maps = lift_maps.data();
+    const int* face = faces.data();
+
+    // Gather the map of the face, then one multiply-add per coordinate
+    #pragma omp parallel for simd schedule(static)
+    for (int i = 0; i < num_part; ++i) {
+        const double* m = maps + 9 * face[i];
+        x[i] = m[0] * u[i] + m[1] * v[i] + m[6];
+        y[i] = m[2] * u[i] + m[3] * v[i] + m[7];
+        z[i] = m[4] * u[i] + m[5] * v[i] + m[8];
+    }
+
+    return r_3D;
+}
+
+
+Eigen::Vector3d UVAffineMaps::barycentric(const Eigen::Vector2d& point, int face) const {
+    const double* m = barycentric_maps.row(face).data();
+    const double du = point.x() - m[4];
+    const double dv = point.y() - m[5];
+    const double lambda_b = m[0] * du + m[1] * dv;
+    const double lambda_c = m[2] * du + m[3] * dv;
+    return Eigen::Vector3d(1 - lambda_b - lambda_c, lambda_b, lambda_c);
+}
+
+
+int UVAffineMaps::nearest_corner(const Eigen::Vector2d& point, int face) const {
+    const Eigen::Vector3d point_3D = lift(point, face);
+    const double* corners = corners_3D.row(face).data();
+
+    int corner = 0;
+    double min_distance = (point_3D - Eigen::Map<const Eigen::Vector3d>(corners)).squaredNorm();
+    for (int k = 1; k < 3; ++k) {
+        const double distance = (point_3D - Eigen::Map<const Eigen::Vector3d>(corners + 3 * k)).squaredNorm();
+        if (distance < min_distance) {
+            min_distance = distance;
+            corner = k;
+        }
+    }
+    return corner;
+}
+
+
+Eigen::Vector3d UVAffineMaps::lift_velocity(const Eigen::Vector2d& velocity_uv, int face) const {
+    const double* m = lift_maps.row(face).data();
+    return Eigen::Vector3d(
+        m[0] * velocity_uv.x() + m[1] * velocity_uv.y(),
+        m[2] * velocity_uv.x() + m[3] * velocity_uv.y(),
+        m[4] * velocity_uv.x() + m[5] * velocity_uv.y()
+    );
+}
+
+
+Eigen::Vector2d UVAffineMaps::uv_velocity(const Eigen::Vector3d& velocity_3D, int face) const {
+    const double* m = inverse_jacobians.row(face).data();
+    return Eigen::Vector2d(
+        m[0] * velocity_3D.x() + m[1] * velocity_3D.y() + m[2] * velocity_3D.z(),
+        m[3] * velocity_3D.x() + m[4] * velocity_3D.y() + m[5] * velocity_3D.z()
+    );
+}
+
+
+double UVAffineMaps::uv_stretch(int face) const {
+    const Eigen::Map<const Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> inverse_jacobian(inverse_jacobians.row(face).data());
+    const Eigen::Matrix2d gram = inverse_jacobian * inverse_jacobian.transpose();
+
+    // Largest eigenvalue of the symmetric 2x2 matrix
+    const double half_trace = 0.5 * (gram(0, 0) + gram(1, 1));
+    const double half_gap = 0.5 * (gram(0, 0) - gram(1, 1));
+    return std::sqrt(half_trace + std::hypot(half_gap, gram(0, 1)));
+}
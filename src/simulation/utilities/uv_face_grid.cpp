@@ -0,0 +1,131 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/barycentric_coord.h>
+#include <utilities/uv_face_grid.h>
+
+
+UVFaceGrid::UVFaceGrid(
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    int cells_per_side
+){
+    if (faces_uv.rows() == 0) {
+        throw std::invalid_argument("The UV face grid needs at least one face");
+    }
+
+    const int num_faces = faces_uv.rows();
+    num_cells_per_side = cells_per_side > 0 ? cells_per_side : std::max(1, static_cast<int>(std::ceil(std::sqrt(num_faces / 2.0))));
+
+    corners.resize(num_faces);
+    min_corner = Eigen::Vector2d::Constant(std::numeric_limits<double>::infinity());
+    Eigen::Vector2d max_corner = -min_corner;
+    for (int f = 0; f < num_faces; ++f) {
+        for (int c = 0; c < 3; ++c) {
+            const Eigen::Vector2d uv = halfedges_uv.row(faces_uv(f, c)).head<2>();
+            corners[f][c] << uv, 0;
+            min_corner = min_corner.cwiseMin(uv);
+            max_corner = max_corner.cwiseMax(uv);
+        }
+    }
+
+    // Square cells, so that the ring search bound is the same in both directions
+    cell_size = std::max((max_corner - min_corner).maxCoeff() / num_cells_per_side, std::numeric_limits<double>::min());
+
+    // Count the faces per cell, then fill them in (counting sort)
+    auto face_cells = [&](int f) {
+        Eigen::Vector2d lower = corners[f][0].head<2>().cwiseMin(corners[f][1].head<2>()).cwiseMin(corners[f][2].head<2>());
+        Eigen::Vector2d upper = corners[f][0].head<2>().cwiseMax(corners[f][1].head<2>()).cwiseMax(corners[f][2].head<2>());
+        return std::array<int, 4>{
+            cell_coord(lower.x(), min_corner.x()), cell_coord(upper.x(), min_corner.x()),
+            cell_coord(lower.y(), min_corner.y()), cell_coord(upper.y(), min_corner.y())
+        };
+    };
+
+    cell_start.assign(num_cells_per_side * num_cells_per_side + 1, 0);
+    for (int f = 0; f < num_faces; ++f) {
+        auto [x0, x1, y0, y1] = face_cells(f);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                ++cell_start[cell_id(x, y) + 1];
+            }
+        }
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    cell_faces.resize(cell_start.back());
+    std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+    for (int f = 0; f < num_faces; ++f) {
+        auto [x0, x1, y0, y1] = face_cells(f);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                cell_faces[fill[cell_id(x, y)]++] = f;
+            }
+        }
+    }
+}
+
+
+int UVFaceGrid::cell_coord(double value, double min) const {
+    const int coord = static_cast<int>(std::floor((value - min) / cell_size));
+    return std::clamp(coord, 0, num_cells_per_side - 1);
+}
+
+
+int UVFaceGrid::nearest_face(const Eigen::Vector2d& point) const {
+    const Eigen::Vector3d p(point.x(), point.y(), 0);
+    const int center_x = cell_coord(point.x(), min_corner.x());
+    const int center_y = cell_coord(point.y(), min_corner.y());
+
+    std::pair<double, int> best(std::numeric_limits<double>::infinity(), -1);
+
+    for (int ring = 0; ring < num_cells_per_side; ++ring) {
+        const int x0 = center_x - ring;
+        const int x1 = center_x + ring;
+        const int y0 = center_y - ring;
+        const int y1 = center_y + ring;
+
+        // Only the cells on the border of the ring are new
+        for (int y = std::max(y0, 0); y <= std::min(y1, num_cells_per_side - 1); ++y) {
+            const bool border_row = (y == y0 || y == y1);
+            for (int x = std::max(x0, 0); x <= std::min(x1, num_cells_per_side - 1); ++x) {
+                if (!border_row && x != x0 && x != x1) {
+                    continue;
+                }
+                const int c = cell_id(x, y);
+                for (int i = cell_start[c]; i < cell_start[c + 1]; ++i) {
+                    const int f = cell_faces[i];
+                    const std::pair<double, int> candidate(pointTriangleDistance(p, corners[f][0], corners[f][1], corners[f][2]), f);
+                    best = std::min(best, candidate);
+                }
+            }
+        }
+
+        // Every face, which was not found yet, lies beyond one of the open sides of the searched block.
+        // Sides on the border of the grid are closed, because no face lies beyond them.
+        double bound = std::numeric_limits<double>::infinity();
+        if (x0 > 0) bound = std::min(bound, point.x() - (min_corner.x() + x0 * cell_size));
+        if (x1 < num_cells_per_side - 1) bound = std::min(bound, min_corner.x() + (x1 + 1) * cell_size - point.x());
+        if (y0 > 0) bound = std::min(bound, point.y() - (min_corner.y() + y0 * cell_size));
+        if (y1 < num_cells_per_side - 1) bound = std::min(bound, min_corner.y() + (y1 + 1) * cell_size - point.y());
+
+        // The slack keeps equally distant faces of the next ring, which could have a smaller index
+        if (bound - 1e-12 > best.first) {
+            break;
+        }
+    }
+
+    return best.second;
+}
@@ -0,0 +1,131 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/uv_face_walk.h>
+
+
+FaceAdjacency calculate_face_adjacency(const Eigen::MatrixXd& halfedges_uv, const Eigen::MatrixXi& faces_uv){
+    const int num_faces = faces_uv.rows();
+
+    // Identify the vertices by their UV coordinates
+    std::map<std::pair<double, double>, int> vertex_ids;
+    auto vertex_id = [&](int halfedge) {
+        auto key = std::make_pair(halfedges_uv(halfedge, 0), halfedges_uv(halfedge, 1));
+        return vertex_ids.emplace(key, static_cast<int>(vertex_ids.size())).first->second;
+    };
+
+    // Every edge of every face, keyed by its two vertices
+    struct FaceEdge {
+        std::pair<int, int> vertices;
+        int face;
+        int8_t corner;
+    };
+    std::vector<FaceEdge> edges;
+    edges.reserve(3 * num_faces);
+    for (int f = 0; f < num_faces; ++f) {
+        const int ids[3] = {vertex_id(faces_uv(f, 0)), vertex_id(faces_uv(f, 1)), vertex_id(faces_uv(f, 2))};
+        for (int8_t corner = 0; corner < 3; ++corner) {
+            const int v = ids[(corner + 1) % 3];
+            const int w = ids[(corner + 2) % 3];
+            edges.push_back({std::minmax(v, w), f, corner});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const FaceEdge& a, const FaceEdge& b) {
+        return std::tie(a.vertices, a.face, a.corner) < std::tie(b.vertices, b.face, b.corner);
+    });
+
+    // Faces listing the same edge are neighbors
+    std::vector<std::vector<std::pair<int, int8_t>>> face_neighbors(num_faces);
+    for (size_t begin = 0; begin < edges.size();) {
+        size_t end = begin + 1;
+        while (end < edges.size() && edges[end].vertices == edges[begin].vertices) {
+            ++end;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = begin; j < end; ++j) {
+                if (edges[i].face != edges[j].face) {
+                    face_neighbors[edges[i].face].emplace_back(edges[j].face, edges[i].corner);
+                }
+            }
+        }
+        begin = end;
+    }
+
+    FaceAdjacency adjacency;
+    adjacency.offsets.resize(num_faces + 1, 0);
+    for (int f = 0; f < num_faces; ++f) {
+        adjacency.offsets[f + 1] = adjacency.offsets[f] + static_cast<int>(face_neighbors[f].size());
+        for (const auto& [neighbor, corner] : face_neighbors[f]) {
+            adjacency.neighbors.push_back(neighbor);
+            adjacency.opposite_corner.push_back(corner);
+        }
+    }
+
+    return adjacency;
+}
+
+
+int walk_to_face(
+    const Eigen::Vector2d& point,
+    int start_face,
+    const FaceAdjacency& adjacency,
+    const Eigen::MatrixXd& halfedges_uv,
+    const Eigen::MatrixXi& faces_uv,
+    int max_steps
+){
+    // Points closer to an edge than this fraction of the face are left to the global lookup,
+    // which decides between the faces sharing the edge
+    constexpr double edge_tolerance = 1e-9;
+
+    auto cross = [](const Eigen::Vector2d& u, const Eigen::Vector2d& v) {
+        return u.x() * v.y() - u.y() * v.x();
+    };
+
+    int face = start_face;
+    for (int step = 0; step <= max_steps; ++step) {
+        const Eigen::Vector2d a = halfedges_uv.row(faces_uv(face, 0)).head<2>();
+        const Eigen::Vector2d b = halfedges_uv.row(faces_uv(face, 1)).head<2>();
+        const Eigen::Vector2d c = halfedges_uv.row(faces_uv(face, 2)).head<2>();
+
+        const double area = cross(b - a, c - a);
+        if (area == 0) {
+            return -1;
+        }
+
+        // Barycentric coordinates of the point, a negative one means the point lies beyond the opposite edge
+        const Eigen::Vector3d lambda(cross(b - point, c - point) / area, cross(c - point, a - point) / area, cross(a - point, b - point) / area);
+
+        Eigen::Index corner;
+        const double min_lambda = lambda.minCoeff(&corner);
+        if (min_lambda >= edge_tolerance) {
+            return face;
+        }
+        if (min_lambda > -edge_tolerance) {
+            return -1;
+        }
+
+        // Step across the edge opposite to the most negative corner
+        int next_face = -1;
+        for (int i = adjacency.offsets[face]; i < adjacency.offsets[face + 1]; ++i) {
+            if (adjacency.opposite_corner[i] == corner) {
+                next_face = adjacency.neighbors[i];
+                break;
+            }
+        }
+        if (next_face < 0) {
+            return -1;
+        }
+        face = next_face;
+    }
+
+    return -1;
+}
@@ -0,0 +1,213 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-20
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <Eigen/Dense>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance_matrix.h>
+
+namespace fs = boost::filesystem;
+
+
+class BinaryMatrixTest : public ::testing::Test {
+protected:
+    std::string path;
+    RowMajorMatrixXd matrix;
+    const uint64_t checksum = 42;
+
+    void SetUp() override {
+        path = (fs::temp_directory_path() / fs::unique_path("binary_matrix_%%%%-%%%%.bin")).string();
+
+        matrix.resize(3, 3);
+        matrix << 0, 1.5, 2.25,
+                  1.5, 0, 4.125,
+                  2.25, 4.125, 0;
+    }
+
+    void TearDown() override {
+        fs::remove(path);
+    }
+};
+
+TEST_F(BinaryMatrixTest, RoundTrip) {
+    save_binary_matrix(path, matrix, checksum);
+
+    DistanceMatrix distance_matrix = DistanceMatrix::load(path);
+
+    ASSERT_EQ(distance_matrix.rows(), 3);
+    ASSERT_EQ(distance_matrix.cols(), 3);
+    for (int i = 0; i < matrix.rows(); ++i) {
+        for (int j = 0; j < matrix.cols(); ++j) {
+            EXPECT_DOUBLE_EQ(distance_matrix(i, j), matrix(i, j));
+        }
+    }
+    EXPECT_TRUE(distance_matrix.row(1).isApprox(matrix.row(1).transpose()));
+}
+
+TEST_F(BinaryMatrixTest, StoresOnlyTheUpperTriangle) {
+    save_binary_matrix(path, matrix, checksum);
+
+    BinaryMatrixHeader header;
+    ASSERT_TRUE(read_binary_matrix_header(path, header));
+    EXPECT_EQ(header.payload_bytes, 6 * sizeof(double));
+    EXPECT_EQ(fs::file_size(path), sizeof(BinaryMatrixHeader) + 6 * sizeof(double));
+}
+
+TEST_F(BinaryMatrixTest, ValidatesChecksum) {
+    save_binary_matrix(path, matrix, checksum);
+
+    EXPECT_TRUE(is_valid_binary_matrix(path, checksum));
+    EXPECT_FALSE(is_valid_binary_matrix(path, checksum + 1));
+    EXPECT_FALSE(is_valid_binary_matrix(path + ".missing", checksum));
+}
+
+TEST_F(BinaryMatrixTest, RejectsTruncatedFile) {
+    save_binary_matrix(path, matrix, checksum);
+    fs::resize_file(path, sizeof(BinaryMatrixHeader) + 8);
+
+    EXPECT_THROW(DistanceMatrix::load(path), std::runtime_error);
+}
+
+TEST_F(BinaryMatrixTest, StreamsThePackedValuesOfEveryDtype) {
+    // Large enough for several chunks, with a different value in each direction of a pair
+    const int n = 1100;
+    RowMajorMatrixXd asymmetric = RowMajorMatrixXd::Random(n, n).cwiseAbs() * 10;
+    std::vector<double> values = pack_symmetric_upper(asymmetric);
+
+    for (MatrixDtype dtype : {MatrixDtype::Float64, MatrixDtype::Float32, MatrixDtype::UInt16}) {
+        save_binary_matrix(path, asymmetric, checksum, dtype);
+
+        const double scale = quantization_scale(values, dtype);
+        std::vector<char> expected(values.size() * dtype_size(dtype));
+        encode_values(values, dtype, scale, expected.data());
+
+        BinaryMatrixHeader header;
+        ASSERT_TRUE(read_binary_matrix_header(path, header));
+        EXPECT_EQ(header.scale, scale);
+        EXPECT_EQ(header.nonzeros, values.size());
+
+        std::vector<char> payload(expected.size());
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(sizeof(BinaryMatrixHeader));
+        file.read(payload.data(), payload.size());
+        EXPECT_EQ(file.gcount(), static_cast<std::streamsize>(payload.size()));
+        EXPECT_EQ(fs::file_size(path), sizeof(BinaryMatrixHeader) + expected.size());
+        EXPECT_TRUE(payload == expected) << dtype_name(dtype);
+    }
+}
+
+TEST_F(BinaryMatrixTest, SparseRoundTrip) {
+    const double cutoff = 2.5;
+    save_sparse_binary_matrix(path, truncate_symmetric(matrix, cutoff), checksum, MatrixDtype::Float64, cutoff);
+
+    DistanceMatrix distance_matrix = DistanceMatrix::load(path);
+
+    ASSERT_EQ(distance_matrix.rows(), 3);
+    EXPECT_EQ(distance_matrix.layout(), MatrixLayout::SparseCSR);
+    EXPECT_EQ(distance_matrix.nonzeros(), 7);
+    EXPECT_DOUBLE_EQ(distance_matrix.cutoff(), cutoff);
+    for (int i = 0; i < matrix.rows(); ++i) {
+        for (int j = 0; j < matrix.cols(); ++j) {
+            if (matrix(i, j) <= cutoff) {
+                EXPECT_DOUBLE_EQ(distance_matrix(i, j), matrix(i, j));
+            }
+            else {
+                EXPECT_TRUE(std::isinf(distance_matrix(i, j)));
+            }
+        }
+    }
+}
+
+TEST_F(BinaryMatrixTest, ValidatesCutoff) {
+    save_sparse_binary_matrix(path, truncate_symmetric(matrix, 2.5), checksum, MatrixDtype::Float32, 2.5);
+
+    EXPECT_TRUE(is_valid_binary_matrix(path, checksum, MatrixDtype::Float32, 2.5));
+    EXPECT_FALSE(is_valid_binary_matrix(path, checksum, MatrixDtype::Float32, 3.0));
+    EXPECT_FALSE(is_valid_binary_matrix(path, checksum, MatrixDtype::Float32));
+}
+
+TEST(PackedUpperTest, IndexCoversTriangleOnce) {
+    const int n = 5;
+    std::vector<int> hits(packed_upper_size(n), 0);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = i; j < n; ++j) {
+            hits[packed_upper_index(i, j, n)]++;
+            EXPECT_EQ(packed_upper_index(i, j, n), packed_upper_index(j, i, n));
+        }
+    }
+
+    for (int hit : hits) {
+        EXPECT_EQ(hit, 1);
+    }
+}
+
+TEST(PackedUpperTest, SymmetrizesWithMinimum) {
+    RowMajorMatrixXd matrix(3, 3);
+    matrix << 0, 2, 3,
+              1, 0, 6,
+              7, 5, 0;
+
+    std::vector<double> values = pack_symmetric_upper(matrix);
+
+    std::vector<double> expected {0, 1, 3, 0, 5, 0};
+    EXPECT_EQ(values, expected);
+}
+
+TEST(SparseMatrixTest, SymmetrizesWithMinimum) {
+    // The pair (0, 2) is only within the cutoff in one direction, (0, 1) in both
+    std::vector<SparseRow> rows {
+        {{0, 0.0}, {1, 2.0}, {2, 3.0}},
+        {{0, 1.0}, {1, 0.0}},
+        {{2, 0.0}}
+    };
+
+    SparseMatrixCSR matrix = symmetric_csr_from_rows(rows);
+
+    std::vector<int64_t> expected_offsets {0, 3, 5, 7};
+    std::vector<int32_t> expected_indices {0, 1, 2, 0, 1, 0, 2};
+    std::vector<double> expected_values {0, 1, 3, 1, 0, 3, 0};
+    EXPECT_EQ(matrix.row_offsets, expected_offsets);
+    EXPECT_EQ(matrix.col_indices, expected_indices);
+    EXPECT_EQ(matrix.values, expected_values);
+}
+
+TEST(MatrixDtypeTest, ParsesTheDtypeNames) {
+    for (MatrixDtype dtype : {MatrixDtype::Float64, MatrixDtype::Float32, MatrixDtype::UInt16}) {
+        EXPECT_EQ(parse_dtype(dtype_name(dtype)), dtype);
+    }
+    EXPECT_THROW(parse_dtype("f16"), std::invalid_argument);
+}
+
+TEST(FileChecksumTest, DependsOnContent) {
+    std::string path_a = (fs::temp_directory_path() / fs::unique_path("checksum_%%%%-%%%%.off")).string();
+    std::string path_b = (fs::temp_directory_path() / fs::unique_path("checksum_%%%%-%%%%.off")).string();
+    std::ofstream(path_a) << "OFF\n3 1 0\n";
+    std::ofstream(path_b) << "OFF\n4 1 0\n";
+
+    EXPECT_EQ(file_checksum(path_a), file_checksum(path_a));
+    EXPECT_NE(file_checksum(path_a), file_checksum(path_b));
+
+    fs::remove(path_a);
+    fs::remove(path_b);
+}
+
+TEST(DistanceMatrixTest, OwnsInMemoryMatrix) {
+    Eigen::MatrixXd matrix(2, 2);
+    matrix << 0, 1,
+              2, 0;
+
+    DistanceMatrix distance_matrix(matrix);
+    DistanceMatrix copy = distance_matrix;
+
+    EXPECT_DOUBLE_EQ(copy(0, 1), 1);
+    EXPECT_DOUBLE_EQ(copy(1, 0), 1);
+}
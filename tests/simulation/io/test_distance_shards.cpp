@@ -0,0 +1,189 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <io/binary_matrix.h>
+#include <io/distance_shards.h>
+#include <io/row_checkpoint.h>
+#include <utilities/distance.h>
+#include <utilities/distance_matrix.h>
+
+namespace fs = boost::filesystem;
+const fs::path PROJECT_PATH = PROJECT_SOURCE_DIR;
+const fs::path MESH_FOLDER = PROJECT_PATH  / "meshes";
+
+
+/**
+ * @brief Shards of a known, asymmetric matrix, which get written like compute_distance_shard writes them
+*/
+class DistanceShardMergeTest : public ::testing::Test {
+protected:
+    const double inf = std::numeric_limits<double>::infinity();
+    const int num_vertices = 23;
+    const int num_shards = 3;
+    const int checkpoint_rows = 4;
+    const uint64_t mesh_checksum = 42;
+    RowMajorMatrixXd matrix;
+    std::string cache_root;
+    std::string distance_matrix_path;
+
+    void SetUp() override {
+        std::mt19937 gen(5);
+        std::uniform_real_distribution<double> uniform(0.1, 3.0);
+        matrix.resize(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                matrix(i, j) = i == j ? 0.0 : uniform(gen);
+            }
+        }
+
+        cache_root = (fs::temp_directory_path() / fs::unique_path("distance_shard_merge_%%%%-%%%%")).string();
+        fs::create_directories(cache_root);
+        distance_matrix_path = (fs::path(cache_root) / "mesh_distance_matrix.bin").string();
+    }
+
+    void TearDown() override {
+        fs::remove_all(cache_root);
+    }
+
+    void write_shard(int shard, double cutoff, int skipped_block = -1) {
+        RowCheckpoint checkpoint(get_distance_shard_path(distance_matrix_path, shard, num_shards), mesh_checksum, num_vertices, num_vertices, checkpoint_rows);
+        ShardRowStore store(num_vertices, cutoff);
+
+        for (int block_id : checkpoint.shard_blocks(shard, num_shards)) {
+            if (block_id == skipped_block || checkpoint.is_complete(block_id)) continue;
+
+            for (int row = checkpoint.block_start(block_id); row < checkpoint.block_start(block_id) + checkpoint.block_size(block_id); ++row) {
+                store.set(row, std::vector<double>(matrix.row(row).data(), matrix.row(row).data() + num_vertices));
+            }
+            store.save_block(checkpoint, block_id);
+            store.release(checkpoint.block_start(block_id), checkpoint.block_size(block_id));
+        }
+    }
+
+    // Both directions are symmetrized with their minimum, a pair beyond the cutoff reads as infinity
+    double expected_distance(int i, int j, double cutoff) const {
+        const double distance = std::min(matrix(i, j), matrix(j, i));
+        return distance <= cutoff ? distance : inf;
+    }
+};
+
+TEST_F(DistanceShardMergeTest, MergesTheShardsIntoTheDistanceMatrix) {
+    for (double cutoff : {inf, 1.0}) {
+        for (int shard = 0; shard < num_shards; ++shard) {
+            write_shard(shard, cutoff);
+        }
+        merge_distance_shard_files(distance_matrix_path, mesh_checksum, num_vertices, num_shards, MatrixDtype::Float64, cutoff, checkpoint_rows);
+
+        DistanceMatrix distance_matrix = DistanceMatrix::load(distance_matrix_path);
+        ASSERT_EQ(distance_matrix.rows(), num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                EXPECT_EQ(distance_matrix(i, j), expected_distance(i, j, cutoff)) << "cutoff " << cutoff << ", pair " << i << ", " << j;
+            }
+        }
+
+        // The merged shards are not needed anymore
+        for (int shard = 0; shard < num_shards; ++shard) {
+            EXPECT_FALSE(fs::exists(get_distance_shard_path(distance_matrix_path, shard, num_shards)));
+        }
+        fs::remove(distance_matrix_path);
+    }
+}
+
+TEST_F(DistanceShardMergeTest, RefusesAnIncompleteShard) {
+    write_shard(0, inf);
+    write_shard(1, inf, 2);
+    EXPECT_THROW(merge_distance_shard_files(distance_matrix_path, mesh_checksum, num_vertices, num_shards, MatrixDtype::Float64, inf, checkpoint_rows), std::runtime_error);
+
+    write_shard(2, inf);
+    EXPECT_THROW(merge_distance_shard_files(distance_matrix_path, mesh_checksum, num_vertices, num_shards, MatrixDtype::Float64, inf, checkpoint_rows), std::runtime_error);
+    EXPECT_FALSE(fs::exists(distance_matrix_path));
+
+    // The resumed shard only adds its missing block, then the merge succeeds
+    write_shard(1, inf);
+    merge_distance_shard_files(distance_matrix_path, mesh_checksum, num_vertices, num_shards, MatrixDtype::Float64, inf, checkpoint_rows);
+    EXPECT_TRUE(fs::exists(distance_matrix_path));
+}
+
+
+/**
+ * @brief Shards of the sphere mesh, which get computed with the CGAL heat method by compute_distance_shard
+*/
+class DistanceShardsTest : public ::testing::Test {
+protected:
+    const double inf = std::numeric_limits<double>::infinity();
+    const std::string mesh_path = (MESH_FOLDER / "sphere.off").string();
+    const int num_shards = 2;
+    const int checkpoint_rows = 100;
+    std::string cache_root;
+
+    void SetUp() override {
+        cache_root = (fs::temp_directory_path() / fs::unique_path("distance_shards_%%%%-%%%%")).string();
+    }
+
+    void TearDown() override {
+        fs::remove_all(cache_root);
+    }
+
+    std::string shard_path(int shard) const {
+        std::string distance_matrix_path = get_distance_matrix_path(mesh_path, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root);
+        return get_distance_shard_path(distance_matrix_path, shard, num_shards);
+    }
+};
+
+TEST_F(DistanceShardsTest, MergesTheShardsIntoTheDistanceMatrix) {
+    for (int shard = 0; shard < num_shards; ++shard) {
+        compute_distance_shard(mesh_path, shard, num_shards, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, 0, cache_root, checkpoint_rows);
+    }
+    merge_distance_shards(mesh_path, num_shards, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root, checkpoint_rows);
+
+    DistanceMatrix distance_matrix = DistanceMatrix::load(get_distance_matrix_path(mesh_path, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root));
+
+    std::vector<int> source_ids(get_mesh_vertex_count(mesh_path));
+    std::iota(source_ids.begin(), source_ids.end(), 0);
+    RowMajorMatrixXd expected = get_distance_rows(mesh_path, source_ids);
+
+    ASSERT_EQ(distance_matrix.rows(), expected.rows());
+    for (int row = 0; row < expected.rows(); ++row) {
+        for (int col = 0; col < expected.cols(); ++col) {
+            EXPECT_NEAR(distance_matrix(row, col), std::min(expected(row, col), expected(col, row)), 1e-12);
+        }
+    }
+
+    // The merged shards are not needed anymore
+    for (int shard = 0; shard < num_shards; ++shard) {
+        EXPECT_FALSE(fs::exists(shard_path(shard)));
+    }
+}
+
+TEST_F(DistanceShardsTest, KeepsTheShardsOnMismatchedMergeOptions) {
+    for (int shard = 0; shard < num_shards; ++shard) {
+        compute_distance_shard(mesh_path, shard, num_shards, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, 0, cache_root, checkpoint_rows);
+    }
+
+    // Options of the cache key look for other shards, the checkpoint size does not match the manifests
+    EXPECT_THROW(merge_distance_shards(mesh_path, num_shards, MatrixDtype::Float32, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root, checkpoint_rows), std::runtime_error);
+    EXPECT_THROW(merge_distance_shards(mesh_path, num_shards, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root, checkpoint_rows + 1), std::runtime_error);
+
+    const int num_vertices = get_mesh_vertex_count(mesh_path);
+    for (int shard = 0; shard < num_shards; ++shard) {
+        auto checkpoint = RowCheckpoint::open_existing(shard_path(shard), file_checksum(mesh_path), num_vertices, num_vertices, checkpoint_rows);
+        EXPECT_EQ(checkpoint->completed_blocks(), checkpoint->shard_blocks(shard, num_shards));
+    }
+
+    // The merge with the options of the shards still finds every block
+    merge_distance_shards(mesh_path, num_shards, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root, checkpoint_rows);
+    EXPECT_TRUE(fs::exists(get_distance_matrix_path(mesh_path, MatrixDtype::Float64, inf, HeatMethodVariant::IntrinsicDelaunay, cache_root)));
+}
@@ -0,0 +1,199 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <io/mesh_registry.h>
+
+namespace fs = boost::filesystem;
+
+
+/**
+ * @brief The fake mesh files contain a single number, which becomes the one vertex of the parsed mesh
+*/
+class MeshRegistryTest : public ::testing::Test {
+protected:
+    std::string directory;
+    std::atomic<int> loads{0};
+
+    void SetUp() override {
+        directory = (fs::temp_directory_path() / fs::unique_path("mesh_registry_%%%%-%%%%")).string();
+        fs::create_directories(directory);
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+    }
+
+    std::string write_mesh(const std::string& name, const std::string& content) {
+        std::string path = (fs::path(directory) / name).string();
+        std::ofstream file(path);
+        file << content;
+        return path;
+    }
+
+    MeshRegistry make_registry() {
+        return MeshRegistry([this](const std::string& path, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces) {
+            ++loads;
+            double value;
+            std::ifstream(path) >> value;
+            vertices = Eigen::MatrixXd::Constant(1, 3, value);
+            faces = Eigen::MatrixXi::Zero(1, 3);
+        });
+    }
+};
+
+TEST_F(MeshRegistryTest, ParsesEachFileOnce) {
+    MeshRegistry registry = make_registry();
+    std::string path = write_mesh("ellipsoid.off", "1");
+
+    auto first = registry.get(path);
+    auto second = registry.get(path);
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(loads, 1);
+    EXPECT_EQ(registry.parsed_files(), 1);
+    EXPECT_DOUBLE_EQ(first->vertices(0, 0), 1);
+}
+
+TEST_F(MeshRegistryTest, KeysByTheCanonicalPath) {
+    MeshRegistry registry = make_registry();
+    std::string path = write_mesh("ellipsoid.off", "1");
+    write_mesh("torus.off", "2");
+
+    auto mesh = registry.get(path);
+    auto alias = registry.get((fs::path(directory) / "." / "ellipsoid.off").string());
+    auto other = registry.get((fs::path(directory) / "torus.off").string());
+
+    EXPECT_EQ(mesh, alias);
+    EXPECT_NE(mesh, other);
+    EXPECT_EQ(registry.size(), 2u);
+    EXPECT_EQ(loads, 2);
+}
+
+TEST_F(MeshRegistryTest, ReparsesAChangedFile) {
+    MeshRegistry registry = make_registry();
+    std::string path = write_mesh("ellipsoid_uv.off", "1");
+    auto old_mesh = registry.get(path);
+
+    write_mesh("ellipsoid_uv.off", "22");
+    auto new_mesh = registry.get(path);
+
+    EXPECT_EQ(loads, 2);
+    EXPECT_DOUBLE_EQ(new_mesh->vertices(0, 0), 22);
+    EXPECT_DOUBLE_EQ(old_mesh->vertices(0, 0), 1);
+}
+
+TEST_F(MeshRegistryTest, ReparsesAFileRewrittenWithinTheSameSecond) {
+    MeshRegistry registry = make_registry();
+    std::string path = write_mesh("ellipsoid_uv.off", "1");
+    const auto write_time = std::filesystem::last_write_time(path);
+    registry.get(path);
+
+    // Same size and the same whole second, only the sub-second part of the time differs
+    write_mesh("ellipsoid_uv.off", "2");
+    std::filesystem::last_write_time(path, write_time + std::chrono::milliseconds(1));
+    auto new_mesh = registry.get(path);
+
+    EXPECT_EQ(loads, 2);
+    EXPECT_DOUBLE_EQ(new_mesh->vertices(0, 0), 2);
+}
+
+TEST_F(MeshRegistryTest, ViewsOutliveTheRegistryEntry) {
+    MeshRegistry registry = make_registry();
+    auto mesh = registry.get(write_mesh("ellipsoid.off", "3"));
+
+    registry.clear();
+
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_DOUBLE_EQ(mesh->vertices(0, 0), 3);
+}
+
+TEST_F(MeshRegistryTest, ConcurrentRequestsShareOneParse) {
+    MeshRegistry registry = make_registry();
+    std::string path = write_mesh("ellipsoid.off", "1");
+
+    std::vector<std::shared_ptr<const MeshAsset>> meshes(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        threads.emplace_back([&, i] { meshes[i] = registry.get(path); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(loads, 1);
+    for (const auto& mesh : meshes) {
+        EXPECT_EQ(mesh, meshes[0]);
+    }
+}
+
+TEST_F(MeshRegistryTest, ParsesDifferentFilesInParallel) {
+    std::promise<void> slow_started;
+    std::promise<void> fast_parsed;
+    std::future<void> fast_parsed_future = fast_parsed.get_future();
+    bool slow_saw_fast = false;
+
+    // The slow mesh only finishes once the fast one got parsed, which a registry wide lock would prevent
+    MeshRegistry registry([&](const std::string& path, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces) {
+        double value;
+        std::ifstream(path) >> value;
+        if (value == 1) {
+            slow_started.set_value();
+            slow_saw_fast = fast_parsed_future.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        }
+        else {
+            fast_parsed.set_value();
+        }
+        vertices = Eigen::MatrixXd::Constant(1, 3, value);
+        faces = Eigen::MatrixXi::Zero(1, 3);
+    });
+    std::string slow = write_mesh("bear.off", "1");
+    std::string fast = write_mesh("sphere.off", "2");
+
+    std::thread thread([&] { registry.get(slow); });
+    slow_started.get_future().wait();
+    registry.get(fast);
+    thread.join();
+
+    EXPECT_TRUE(slow_saw_fast);
+    EXPECT_EQ(registry.parsed_files(), 2);
+}
+
+TEST_F(MeshRegistryTest, RetriesAFailedParse) {
+    bool fail = true;
+    MeshRegistry registry([&](const std::string&, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces) {
+        if (fail) {
+            throw std::runtime_error("Failed to load model");
+        }
+        vertices = Eigen::MatrixXd::Zero(1, 3);
+        faces = Eigen::MatrixXi::Zero(1, 3);
+    });
+    std::string path = write_mesh("ellipsoid.off", "1");
+
+    EXPECT_THROW(registry.get(path), std::runtime_error);
+    EXPECT_EQ(registry.size(), 0u);
+
+    fail = false;
+    EXPECT_NE(registry.get(path), nullptr);
+    EXPECT_EQ(registry.parsed_files(), 1);
+}
+
+TEST_F(MeshRegistryTest, RejectsAMissingFile) {
+    MeshRegistry registry = make_registry();
+    EXPECT_THROW(registry.get((fs::path(directory) / "missing.off").string()), std::runtime_error);
+    EXPECT_EQ(loads, 0);
+}
@@ -0,0 +1,90 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-25
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <unistd.h>
+
+#include <io/precompute_cache.h>
+#include <utilities/2D_mapping_fixed_border.h>
+
+namespace fs = boost::filesystem;
+
+
+class PrecomputeCacheTest : public ::testing::Test {
+protected:
+    fs::path directory;
+    std::string mesh_path;
+
+    void SetUp() override {
+        directory = fs::temp_directory_path() / fs::unique_path("precompute_cache_%%%%-%%%%");
+        fs::create_directories(directory);
+
+        mesh_path = (directory / "ellipsoid.off").string();
+        std::ofstream(mesh_path) << "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 2\n";
+    }
+
+    void TearDown() override {
+        unsetenv(CACHE_ROOT_ENV);
+        fs::remove_all(directory);
+    }
+};
+
+TEST_F(PrecomputeCacheTest, ResolvesTheCacheRoot) {
+    unsetenv(CACHE_ROOT_ENV);
+    EXPECT_EQ(get_cache_root(), (fs::path(PROJECT_SOURCE_DIR) / "meshes" / "data").string());
+
+    setenv(CACHE_ROOT_ENV, "/shared/cache", 1);
+    EXPECT_EQ(get_cache_root(), "/shared/cache");
+    EXPECT_EQ(get_cache_root("/explicit"), "/explicit");
+}
+
+TEST_F(PrecomputeCacheTest, PathDependsOnMeshContentAndParameters) {
+    std::string root = (directory / "cache").string();
+
+    std::string path = get_cache_path(mesh_path, "uv", "start_vertex=0", ".off", root);
+    EXPECT_EQ(fs::path(path).parent_path(), fs::path(root));
+    EXPECT_EQ(fs::path(path).extension(), ".off");
+    EXPECT_EQ(fs::path(path).filename().string().rfind("ellipsoid_uv_", 0), 0);
+
+    EXPECT_EQ(get_cache_path(mesh_path, "uv", "start_vertex=0", ".off", root), path);
+    EXPECT_NE(get_cache_path(mesh_path, "uv", "start_vertex=1", ".off", root), path);
+    EXPECT_NE(get_cache_path(mesh_path, "distance_matrix", "start_vertex=0", ".off", root), path);
+
+    // A re-exported mesh with the same name gets another cache file
+    std::ofstream(mesh_path) << "OFF\n3 1 0\n0 0 0\n2 0 0\n0 1 0\n3 0 1 2\n";
+    EXPECT_NE(get_cache_path(mesh_path, "uv", "start_vertex=0", ".off", root), path);
+}
+
+TEST_F(PrecomputeCacheTest, SeamTypeFollowsTheCachedUVMeshName) {
+    std::string root = (directory / "cache").string();
+    std::string sphere_path = (directory / "sphere.off").string();
+    std::ofstream(sphere_path) << "OFF\n3 1 0\n0 0 0\n1 0 0\n0 1 0\n3 0 1 2\n";
+
+    EXPECT_EQ(get_seam_type(get_cache_path(sphere_path, "uv", "start_vertex=0", ".off", root)), SeamType::Opposite);
+    EXPECT_EQ(get_seam_type(get_cache_path(mesh_path, "uv", "start_vertex=0", ".off", root)), SeamType::Diagonal);
+}
+
+TEST_F(PrecomputeCacheTest, CommitsTheCompleteFileAtOnce) {
+    std::string path = (directory / "artifact.bin").string();
+    std::string temporary_path = temporary_cache_path(path);
+    EXPECT_NE(temporary_cache_path(path), temporary_path);
+
+    // The temporary file stays next to the cache file and names its host, the process ids of other nodes may collide
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    EXPECT_EQ(fs::path(temporary_path).parent_path(), directory);
+    EXPECT_NE(temporary_path.find(std::string(".tmp.") + host + "."), std::string::npos);
+
+    std::ofstream(temporary_path) << "content";
+    EXPECT_FALSE(fs::exists(path));
+
+    commit_cache_file(temporary_path, path);
+    EXPECT_TRUE(fs::exists(path));
+    EXPECT_FALSE(fs::exists(temporary_path));
+}
@@ -0,0 +1,194 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-25
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <io/binary_matrix.h>
+#include <io/row_checkpoint.h>
+
+namespace fs = boost::filesystem;
+
+
+class RowCheckpointTest : public ::testing::Test {
+protected:
+    std::string directory;
+
+    void SetUp() override {
+        directory = (fs::temp_directory_path() / fs::unique_path("row_checkpoint_%%%%-%%%%")).string();
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+        fs::remove(directory + ".lock");
+    }
+
+    // Whether another job could take the lock of the checkpoint right now
+    bool try_lock() const {
+        int fd = open((directory + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+        const bool locked = flock(fd, LOCK_EX | LOCK_NB) == 0;
+        close(fd);
+        return locked;
+    }
+};
+
+TEST_F(RowCheckpointTest, RoundTripsFullAndTruncatedRows) {
+    RowCheckpoint checkpoint(directory, 42, 5, 3, 2);
+    ASSERT_EQ(checkpoint.num_blocks(), 3);
+    EXPECT_EQ(checkpoint.block_size(2), 1);
+
+    std::vector<SparseRow> rows = {
+        {{0, 0.0}, {1, 1.5}, {2, 2.5}},
+        {{1, 0.0}}
+    };
+    checkpoint.save_block(0, rows);
+
+    std::vector<SparseRow> loaded = checkpoint.load_block(0);
+    EXPECT_EQ(loaded, rows);
+    EXPECT_TRUE(checkpoint.is_complete(0));
+    EXPECT_EQ(checkpoint.pending_blocks(), std::vector<int>({1, 2}));
+}
+
+TEST_F(RowCheckpointTest, ResumesTheCompletedBlocks) {
+    {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 2);
+        checkpoint.save_block(1, {{{3, 1.0}}, {{2, 0.5}}});
+    }
+
+    RowCheckpoint resumed(directory, 42, 4, 4, 2);
+    EXPECT_EQ(resumed.pending_blocks(), std::vector<int>({0}));
+    EXPECT_EQ(resumed.load_block(1)[1], SparseRow({{2, 0.5}}));
+}
+
+TEST_F(RowCheckpointTest, DiscardsAForeignCheckpoint) {
+    {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 2);
+        checkpoint.save_block(0, {{}, {}});
+    }
+
+    // Another mesh or block size must not reuse the old blocks
+    {
+        RowCheckpoint other_mesh(directory, 43, 4, 4, 2);
+        EXPECT_EQ(other_mesh.pending_blocks(), std::vector<int>({0, 1}));
+    }
+
+    RowCheckpoint other_blocks(directory, 43, 4, 4, 4);
+    EXPECT_EQ(other_blocks.pending_blocks(), std::vector<int>({0}));
+}
+
+TEST_F(RowCheckpointTest, RemovesTheCheckpoint) {
+    RowCheckpoint checkpoint(directory, 42, 2, 2, 2);
+    checkpoint.save_block(0, {{}, {}});
+    checkpoint.remove();
+
+    EXPECT_FALSE(fs::exists(directory));
+}
+
+TEST_F(RowCheckpointTest, ShardsCoverEveryBlockOnce) {
+    RowCheckpoint checkpoint(directory, 42, 10, 10, 1);
+
+    std::vector<int> covered;
+    for (int shard = 0; shard < 3; ++shard) {
+        std::vector<int> block_ids = checkpoint.shard_blocks(shard, 3);
+        EXPECT_GE(block_ids.size(), 3u);
+        covered.insert(covered.end(), block_ids.begin(), block_ids.end());
+    }
+
+    std::vector<int> all_blocks = checkpoint.pending_blocks();
+    EXPECT_EQ(covered, all_blocks);
+    EXPECT_THROW(checkpoint.shard_blocks(3, 3), std::invalid_argument);
+}
+
+TEST_F(RowCheckpointTest, WritesDenseRowsAsCompleteRows) {
+    RowMajorMatrixXd matrix(3, 2);
+    matrix << 0.0, 1.0,
+              1.0, 0.0,
+              2.0, 3.0;
+
+    {
+        RowCheckpoint checkpoint(directory, 42, 3, 2, 2);
+        checkpoint.save_block(0, matrix.middleRows(0, 2));
+        checkpoint.save_block(1, matrix.middleRows(2, 1));
+        EXPECT_THROW(checkpoint.save_block(0, matrix.middleRows(0, 1)), std::invalid_argument);
+    }
+
+    RowCheckpoint resumed(directory, 42, 3, 2, 2);
+    EXPECT_TRUE(resumed.pending_blocks().empty());
+    EXPECT_EQ(resumed.load_block(0)[1], SparseRow({{0, 1.0}, {1, 0.0}}));
+    EXPECT_EQ(resumed.load_block(1)[0], SparseRow({{0, 2.0}, {1, 3.0}}));
+}
+
+TEST_F(RowCheckpointTest, OpensAnExistingCheckpointReadOnly) {
+    EXPECT_THROW(RowCheckpoint::open_existing(directory, 42, 4, 4, 2), std::runtime_error);
+
+    {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 2);
+        checkpoint.save_block(0, {{{1, 1.0}}, {{0, 1.0}}});
+    }
+
+    // A mismatch must neither be resumed nor wipe the blocks
+    EXPECT_THROW(RowCheckpoint::open_existing(directory, 43, 4, 4, 2), std::runtime_error);
+    EXPECT_THROW(RowCheckpoint::open_existing(directory, 42, 4, 4, 3), std::runtime_error);
+
+    auto existing = RowCheckpoint::open_existing(directory, 42, 4, 4, 2);
+    EXPECT_EQ(existing->completed_blocks(), std::vector<int>({0}));
+    EXPECT_EQ(existing->load_block(0)[0], SparseRow({{1, 1.0}}));
+    EXPECT_THROW(existing->save_block(1, {{}, {}}), std::logic_error);
+}
+
+TEST_F(RowCheckpointTest, LocksTheCheckpointForOneJob) {
+    {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 2);
+        EXPECT_FALSE(try_lock());
+
+        // The lock outlives the removal of the checkpoint directory
+        checkpoint.remove();
+        EXPECT_FALSE(try_lock());
+    }
+    EXPECT_TRUE(try_lock());
+
+    // A refused read-only checkpoint releases its lock
+    {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 2);
+    }
+    EXPECT_THROW(RowCheckpoint::open_existing(directory, 43, 4, 4, 2), std::runtime_error);
+    EXPECT_TRUE(try_lock());
+}
+
+TEST_F(RowCheckpointTest, SecondJobWaitsForTheFirstOne) {
+    auto first_job = std::make_unique<RowCheckpoint>(directory, 42, 4, 4, 2);
+    first_job->save_block(0, {{}, {}});
+
+    // The second job uses another block size, which would discard the blocks of the first job
+    std::atomic<bool> second_job_started{false};
+    std::vector<int> second_job_pending;
+    std::thread second_job([&]() {
+        RowCheckpoint checkpoint(directory, 42, 4, 4, 4);
+        second_job_started = true;
+        second_job_pending = checkpoint.pending_blocks();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(second_job_started);
+    EXPECT_EQ(first_job->load_block(0).size(), 2u);
+
+    first_job->remove();
+    first_job.reset();
+    second_job.join();
+
+    EXPECT_TRUE(second_job_started);
+    EXPECT_EQ(second_job_pending, std::vector<int>({0}));
+    EXPECT_TRUE(fs::exists(directory));
+}
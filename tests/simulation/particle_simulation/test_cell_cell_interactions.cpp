@@ -4,6 +4,8 @@
 // version: 0.1.0
 
 #include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
 #include <Eigen/Dense>
 
 #include <particle_simulation/cell_cell_interactions.h>
@@ -35,4 +37,50 @@ TEST_F(RepulsiveAdhesionTest, Test2) {
 
     ASSERT_NEAR(result[0], expected_result[0], 1e-5);
     ASSERT_NEAR(result[1], expected_result[1], 1e-5);
-}
\ No newline at end of file
+}
+
+TEST_F(RepulsiveAdhesionTest, BatchMatchesTheScalarForceOnEveryInstructionSet) {
+    // Distances with repulsion, adhesion and no force at all, more pairs than fit into a register plus a remainder
+    const double r_adh_wide = 4 * σ;
+    std::vector<double> dist, dx, dy;
+    for (int p = 0; p < 37; ++p) {
+        dist.push_back(0.001 + p * 0.15 * σ);
+        dx.push_back(std::cos(p) * 0.3);
+        dy.push_back(std::sin(p) * 0.3);
+    }
+
+    std::vector<SimdLevel> levels {SimdLevel::Scalar};
+    if (detect_simd_level() >= SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+    if (detect_simd_level() >= SimdLevel::AVX512) levels.push_back(SimdLevel::AVX512);
+
+    for (double adhesion_range : {r_adh, r_adh_wide}) {
+        for (SimdLevel level : levels) {
+            std::vector<double> fx(dist.size()), fy(dist.size());
+            repulsive_adhesion_motion_batch(k, σ, adhesion_range, k_adh, dist.data(), dx.data(), dy.data(), fx.data(), fy.data(), dist.size(), level);
+
+            for (size_t p = 0; p < dist.size(); ++p) {
+                Eigen::Vector2d expected = repulsive_adhesion_motion(k, σ, dist[p], adhesion_range, k_adh, Eigen::Vector2d(dx[p], dy[p]));
+                EXPECT_NEAR(fx[p], expected[0], 1e-12) << "pair " << p << ", level " << static_cast<int>(level);
+                EXPECT_NEAR(fy[p], expected[1], 1e-12) << "pair " << p << ", level " << static_cast<int>(level);
+            }
+        }
+    }
+}
+
+TEST_F(RepulsiveAdhesionTest, EmptyBatch) {
+    InteractionBatch batch;
+    repulsive_adhesion_motion_batch(k, σ, r_adh, k_adh, batch);
+    EXPECT_TRUE(batch.fx.empty());
+}
+
+TEST_F(RepulsiveAdhesionTest, ClearedBatchHasNoStaleForces) {
+    InteractionBatch batch;
+    batch.add(0.5, Eigen::Vector2d(0.3, 0.4));
+    repulsive_adhesion_motion_batch(k, σ, r_adh, k_adh, batch);
+    ASSERT_EQ(batch.fx.size(), 1u);
+
+    batch.clear();
+    EXPECT_EQ(batch.size(), 0u);
+    EXPECT_TRUE(batch.fx.empty());
+    EXPECT_TRUE(batch.fy.empty());
+}
@@ -0,0 +1,262 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_list.h>
+
+
+/**
+ * @brief UV distance, which also takes the shortcuts across the seam of the UV square into account
+*/
+double seam_distance(const Eigen::Vector2d& a, const Eigen::Vector2d& b, SeamType seam_type) {
+    std::vector<Eigen::Vector2d> images {b};
+
+    if (seam_type == SeamType::Opposite) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                images.push_back(b + Eigen::Vector2d(dx, dy));
+            }
+        }
+    }
+    else {
+        // Image of b behind the right, top, left and bottom border
+        images.push_back(Eigen::Vector2d(2 - b.y(), b.x()));
+        images.push_back(Eigen::Vector2d(b.y(), 2 - b.x()));
+        images.push_back(Eigen::Vector2d(-b.y(), b.x()));
+        images.push_back(Eigen::Vector2d(b.y(), -b.x()));
+    }
+
+    double distance = std::numeric_limits<double>::infinity();
+    for (const auto& image : images) {
+        distance = std::min(distance, (a - image).norm());
+    }
+    return distance;
+}
+
+
+class CellListTest : public ::testing::TestWithParam<SeamType> {
+protected:
+    Eigen::Matrix<double, Eigen::Dynamic, 2> random_particles(int num_part) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        Eigen::Matrix<double, Eigen::Dynamic, 2> r(num_part, 2);
+        for (int i = 0; i < num_part; ++i) {
+            r(i, 0) = uniform(gen);
+            r(i, 1) = uniform(gen);
+        }
+        return r;
+    }
+};
+
+TEST_P(CellListTest, FindsEveryPairWithinTheSearchRadius) {
+    const double search_radius = 0.05;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r = random_particles(2000);
+
+    UVCellList cell_list(search_radius, GetParam());
+    cell_list.build(r);
+    std::vector<ParticlePair> pairs = cell_list.candidate_pairs();
+    std::set<ParticlePair> candidates(pairs.begin(), pairs.end());
+
+    // Every pair exactly once and with the smaller index first
+    EXPECT_EQ(candidates.size(), pairs.size());
+    for (const auto& [i, j] : pairs) {
+        EXPECT_LT(i, j);
+    }
+
+    for (int i = 0; i < r.rows(); ++i) {
+        for (int j = i + 1; j < r.rows(); ++j) {
+            if (seam_distance(r.row(i), r.row(j), GetParam()) < search_radius) {
+                EXPECT_TRUE(candidates.count({i, j})) << "missed pair " << i << ", " << j;
+            }
+        }
+    }
+
+    // Only a small fraction of all pairs gets checked
+    EXPECT_LT(pairs.size(), all_particle_pairs(r.rows()).size() / 20);
+}
+
+TEST_P(CellListTest, NeighborCellsAreSymmetric) {
+    UVCellList cell_list(0.1, GetParam());
+    const int num_cells = cell_list.cells_per_side() * cell_list.cells_per_side();
+
+    for (int c = 0; c < num_cells; ++c) {
+        for (int neighbor : cell_list.neighbor_cells(c)) {
+            const auto& back = cell_list.neighbor_cells(neighbor);
+            EXPECT_TRUE(std::binary_search(back.begin(), back.end(), c));
+        }
+    }
+}
+
+TEST_P(CellListTest, LargeRadiusComparesAllPairs) {
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r = random_particles(30);
+
+    UVCellList cell_list(2.0, GetParam());
+    cell_list.build(r);
+
+    EXPECT_EQ(cell_list.cells_per_side(), 1);
+    EXPECT_EQ(cell_list.candidate_pairs(), all_particle_pairs(r.rows()));
+}
+
+TEST_P(CellListTest, FindPairsReusesItsPairList) {
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r = random_particles(30);
+
+    UVCellList cell_list(2.0, GetParam());
+    const std::vector<ParticlePair>& first = cell_list.find_pairs(r, {});
+    const ParticlePair* data = first.data();
+
+    r.col(0) = r.col(0).reverse().eval();
+    const std::vector<ParticlePair>& second = cell_list.find_pairs(r, {});
+
+    EXPECT_EQ(&second, &first);
+    EXPECT_EQ(second.data(), data);
+    EXPECT_EQ(second, all_particle_pairs(r.rows()));
+}
+
+INSTANTIATE_TEST_SUITE_P(Seams, CellListTest, ::testing::Values(SeamType::Diagonal, SeamType::Opposite));
+
+
+TEST(CellListSeamTest, DiagonalSeamGluesRightToTopBorder) {
+    UVCellList cell_list(0.1, SeamType::Diagonal);
+
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(2, 2);
+    r << 0.99, 0.35,
+         0.35, 0.99;
+    cell_list.build(r);
+
+    EXPECT_EQ(cell_list.candidate_pairs(), std::vector<ParticlePair>({{0, 1}}));
+}
+
+TEST(UVStretchTest, BoundsTheScaleOfTheParametrization) {
+    Eigen::MatrixXd vertices_3D(3, 3);
+    vertices_3D << 0, 0, 0,
+                   2, 0, 0,
+                   1, std::sqrt(3.0), 0;
+    Eigen::MatrixXi faces(1, 3);
+    faces << 0, 1, 2;
+
+    // Same equilateral triangle with half the size and rotated
+    Eigen::MatrixXd vertices_uv(3, 2);
+    vertices_uv << 0.5, 0.5 * std::sqrt(3.0),
+                   0, 0,
+                   1, 0;
+
+    EXPECT_NEAR(max_uv_stretch(UVAffineMaps(vertices_uv, faces, vertices_3D)), 0.5, 1e-12);
+    EXPECT_NEAR(max_uv_edge_length(vertices_uv, faces), 1.0, 1e-12);
+}
+
+TEST(UVStretchTest, CoversFlatFacesWithLongEdges) {
+    // All 3D edges are longer than 1, but the height of the face shrinks by a factor of 100
+    Eigen::MatrixXd vertices_3D(3, 3);
+    vertices_3D << 0, 0, 0,
+                   2, 0, 0,
+                   1, 0.01, 0;
+    Eigen::MatrixXi faces(1, 3);
+    faces << 0, 1, 2;
+
+    Eigen::MatrixXd vertices_uv(3, 2);
+    vertices_uv << 0, 0,
+                   2, 0,
+                   1, 1;
+
+    EXPECT_NEAR(max_uv_stretch(UVAffineMaps(vertices_uv, faces, vertices_3D)), 100.0, 1e-9);
+}
+
+
+/**
+ * @brief Regular grid over the UV square, whose 3D positions are ten times larger, except for one flattened vertex
+*/
+class LocalStretchTest : public ::testing::TestWithParam<SeamType> {
+protected:
+    const int grid_size = 20;
+    const double search_range = 0.3;
+    Eigen::MatrixXd vertices_uv;
+    Eigen::MatrixXd vertices_3D;
+    Eigen::MatrixXi faces;
+
+    void SetUp() override {
+        const int num_vertices = (grid_size + 1) * (grid_size + 1);
+        vertices_uv.resize(num_vertices, 2);
+        vertices_3D.resize(num_vertices, 3);
+        for (int x = 0; x <= grid_size; ++x) {
+            for (int y = 0; y <= grid_size; ++y) {
+                vertices_uv.row(x * (grid_size + 1) + y) << double(x) / grid_size, double(y) / grid_size;
+                vertices_3D.row(x * (grid_size + 1) + y) << 10.0 * x / grid_size, 10.0 * y / grid_size, 0;
+            }
+        }
+
+        // The faces around the center vertex get squashed to a height of 0.01 in 3D
+        vertices_3D(center_vertex(), 1) -= 0.49;
+
+        faces.resize(2 * grid_size * grid_size, 3);
+        for (int x = 0; x < grid_size; ++x) {
+            for (int y = 0; y < grid_size; ++y) {
+                const int v = x * (grid_size + 1) + y;
+                faces.row(2 * (x * grid_size + y)) << v, v + grid_size + 1, v + grid_size + 2;
+                faces.row(2 * (x * grid_size + y) + 1) << v, v + grid_size + 2, v + 1;
+            }
+        }
+    }
+
+    int center_vertex() const {
+        return (grid_size / 2) * (grid_size + 1) + grid_size / 2;
+    }
+};
+
+TEST_P(LocalStretchTest, OnlyTheCellsAroundTheStretchedFacesReachFurther) {
+    UVAffineMaps affine_maps(vertices_uv, faces, vertices_3D);
+    ASSERT_GT(max_uv_stretch(affine_maps), 1.0);
+
+    UVCellList cell_list(search_range, 0.0, vertices_uv, faces, affine_maps, GetParam());
+
+    // Sized for the stretch of 0.1, the worst face would only leave a single cell
+    EXPECT_EQ(cell_list.cells_per_side(), 33);
+    EXPECT_GT(cell_list.reach_of(cell_list.cell_of(0.5, 0.5)), 1);
+    EXPECT_EQ(cell_list.reach_of(cell_list.cell_of(0.1, 0.1)), 1);
+    EXPECT_EQ(cell_list.reach_of(cell_list.cell_of(0.9, 0.2)), 1);
+}
+
+TEST_P(LocalStretchTest, FindsEveryPairWithinTheLocalSearchRadius) {
+    UVAffineMaps affine_maps(vertices_uv, faces, vertices_3D);
+    UVCellList cell_list(search_range, 0.0, vertices_uv, faces, affine_maps, GetParam());
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(1500, 2);
+    for (int i = 0; i < r.rows(); ++i) {
+        r(i, 0) = uniform(gen);
+        r(i, 1) = uniform(gen);
+    }
+
+    cell_list.build(r);
+    std::vector<ParticlePair> pairs = cell_list.candidate_pairs();
+    std::set<ParticlePair> candidates(pairs.begin(), pairs.end());
+    EXPECT_EQ(candidates.size(), pairs.size());
+
+    // Away from the flattened vertex the typical stretch holds, next to it the largest stretch
+    const Eigen::Vector2d center = vertices_uv.row(center_vertex());
+    const double typical_radius = search_range * 0.1;
+    const double stretched_radius = search_range * max_uv_stretch(affine_maps);
+    for (int i = 0; i < r.rows(); ++i) {
+        const bool next_to_center = (Eigen::Vector2d(r.row(i)) - center).norm() < 0.05;
+        for (int j = i + 1; j < r.rows(); ++j) {
+            const double distance = seam_distance(r.row(i), r.row(j), GetParam());
+            if (distance < typical_radius || (next_to_center && distance < stretched_radius)) {
+                EXPECT_TRUE(candidates.count({i, j})) << "missed pair " << i << ", " << j;
+            }
+        }
+    }
+
+    EXPECT_LT(pairs.size(), all_particle_pairs(r.rows()).size() / 4);
+}
+
+INSTANTIATE_TEST_SUITE_P(Seams, LocalStretchTest, ::testing::Values(SeamType::Diagonal, SeamType::Opposite));
@@ -4,10 +4,15 @@
 // version: 0.1.0
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
 #include <vector>
+#include <omp.h>
 #include <Eigen/Dense>
 
+#include <particle_simulation/cell_list.h>
 #include <particle_simulation/forces.h>
+#include <particle_simulation/pair_interactions.h>
 
 
 class ForcesTest : public ::testing::Test {
@@ -43,9 +48,9 @@ TEST_F(ForcesTest, Test1) {
         0.224224, -0.00563865,    0.046365,   0.0464977,  -0.0666243,   0.0145997,   0.0701667,   -0.267323,           0,  -0.0283143,
         0.252539,   0.0226757,   0.0746793,    0.074812,    -0.03831,    0.042914,    0.098481,   -0.239009,   0.0283143,           0;
 
-    std::vector<Eigen::MatrixXd> dist_vect;
-    dist_vect.push_back(dist_x);
-    dist_vect.push_back(dist_y);
+    // The distance vectors are r_i - r_j, so the first column gives the positions up to a shift
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(10, 2);
+    r << dist_x.col(0), dist_y.col(0);
 
     Eigen::MatrixXd dist_length(10,10);
     dist_length << 0,  9.97271,  7.97793,  8.25324,  11.1856,  11.6679,  8.30672,  16.1402,  8.72409,  10.3384,
@@ -71,8 +76,103 @@ TEST_F(ForcesTest, Test1) {
                 0.0420232, 0.00979946,
                 -0.280147,  -0.321582;
 
-    Eigen::MatrixXd F_track = calculate_forces_between_particles(dist_vect, dist_length, k, σ, r_adh, k_adh);
+    std::vector<ParticlePair> pairs = all_particle_pairs(10);
+    std::vector<double> pair_distances;
+    for (const auto& [i, j] : pairs) {
+        pair_distances.push_back(dist_length(i, j));
+    }
+
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = Eigen::Matrix<double, Eigen::Dynamic, 2>::Zero(10, 2);
+    Eigen::MatrixXd F_track = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh).force;
 
     double tolerance = 1e-5;
     ASSERT_TRUE(expected_result.isApprox(F_track, tolerance));
 }
+
+TEST_F(ForcesTest, ParallelReductionsMatchTheSerialForces) {
+    // Enough pairs, that the forces actually get accumulated by several threads
+    const int num_part = 400;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(num_part, 2);
+
+    std::vector<ParticlePair> pairs = all_particle_pairs(num_part);
+    std::vector<double> pair_distances;
+    for (const auto& [i, j] : pairs) {
+        pair_distances.push_back((r.row(i) - r.row(j)).norm() * 2);
+    }
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = Eigen::Matrix<double, Eigen::Dynamic, 2>::Zero(num_part, 2);
+    Eigen::MatrixXd serial = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::Serial).force;
+    Eigen::MatrixXd buffers = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers).force;
+    Eigen::MatrixXd coloring = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::PairColoring).force;
+
+    // The cached coloring of all candidate pairs gets mapped onto the interacting pairs of the step
+    PairWorkspace workspace;
+    Eigen::MatrixXd cached_coloring = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::PairColoring, workspace).force;
+    omp_set_num_threads(max_threads);
+
+    EXPECT_TRUE(buffers.isApprox(serial, 1e-10));
+    EXPECT_TRUE(coloring.isApprox(serial, 1e-10));
+    EXPECT_TRUE(cached_coloring.isApprox(serial, 1e-10));
+}
+
+TEST_F(ForcesTest, PairsOfOneColorShareNoParticle) {
+    const int num_part = 90;
+    std::vector<ParticlePair> pairs = all_particle_pairs(num_part);
+    PairColors colors = color_pairs(pairs, num_part);
+
+    // A complete graph needs more colors than fit into a single word of the bit masks
+    EXPECT_GT(colors.num_colors(), 64);
+    ASSERT_EQ(colors.pair_ids.size(), pairs.size());
+
+    std::vector<long> pair_ids = colors.pair_ids;
+    std::sort(pair_ids.begin(), pair_ids.end());
+    for (size_t p = 0; p < pair_ids.size(); ++p) {
+        EXPECT_EQ(pair_ids[p], p);
+    }
+
+    for (int color = 0; color < colors.num_colors(); ++color) {
+        std::set<int> particles;
+        for (long c = colors.color_start[color]; c < colors.color_start[color + 1]; ++c) {
+            EXPECT_TRUE(particles.insert(pairs[colors.pair_ids[c]].first).second);
+            EXPECT_TRUE(particles.insert(pairs[colors.pair_ids[c]].second).second);
+        }
+    }
+}
+
+TEST_F(ForcesTest, ColoringIsOnlyComputedForANewPairList) {
+    const int num_part = 400;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(num_part, 2);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = Eigen::Matrix<double, Eigen::Dynamic, 2>::Zero(num_part, 2);
+
+    std::vector<ParticlePair> pairs = all_particle_pairs(num_part);
+    std::vector<double> pair_distances;
+    for (const auto& [i, j] : pairs) {
+        pair_distances.push_back((r.row(i) - r.row(j)).norm() * 2);
+    }
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    PairWorkspace workspace;
+    calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::PairColoring, workspace);
+    EXPECT_EQ(workspace.colors_generation, 0);
+
+    // An empty extra color marks the cached coloring
+    workspace.colors.color_start.push_back(workspace.colors.color_start.back());
+    const int num_colors = workspace.colors.num_colors();
+
+    // A reused pair list keeps its coloring, even if the particles moved and other pairs interact
+    for (double& distance : pair_distances) distance *= 0.5;
+    Eigen::MatrixXd reused = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::PairColoring, workspace).force;
+    EXPECT_EQ(workspace.colors.num_colors(), num_colors);
+
+    ++workspace.pairs_generation;
+    calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::PairColoring, workspace);
+    EXPECT_EQ(workspace.colors_generation, 1);
+    EXPECT_EQ(workspace.colors.num_colors(), num_colors - 1);
+
+    Eigen::MatrixXd serial = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh, ForceReduction::Serial).force;
+    omp_set_num_threads(max_threads);
+    EXPECT_TRUE(reused.isApprox(serial, 1e-10));
+}
@@ -7,8 +7,13 @@
 #include <vector>
 #include <Eigen/Dense>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <omp.h>
+#include <particle_simulation/cell_list.h>
 #include <particle_simulation/motion.h>
+#include <particle_simulation/pair_interactions.h>
+#include <utilities/angles_to_unit_vectors.h>
 
 
 /**
@@ -67,128 +72,7 @@ TEST(SymmetricMatrixTest, AllZerosTest) {
 
 
 /**
- * @brief Test the function get_dist_vect
-*/
-TEST(GetDistVectTest, BasicTest) {
-    // 3x2 matrix
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r(3, 2);
-    r << 1, 2,
-         3, 4,
-         5, 6;
-
-    std::vector<Eigen::MatrixXd> dist_vect = get_dist_vect(r);
-
-    Eigen::MatrixXd expected_diff_x(3, 3);
-    expected_diff_x <<  0, -2, -4,
-                        2,  0, -2,
-                        4,  2,  0;
-
-    Eigen::MatrixXd expected_diff_y(3, 3);
-    expected_diff_y <<  0, -2, -4,
-                        2,  0, -2,
-                        4,  2,  0;
-
-    ASSERT_TRUE(dist_vect[0].isApprox(expected_diff_x));
-    ASSERT_TRUE(dist_vect[1].isApprox(expected_diff_y));
-}
-
-TEST(GetDistVectTest, ZeroMatrixTest) {
-    // 3x2 matrix
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r(3, 2);
-    r << 0, 0,
-         0, 0,
-         0, 0;
-
-    std::vector<Eigen::MatrixXd> dist_vect = get_dist_vect(r);
-
-    Eigen::MatrixXd expected_diff(3, 3);
-    expected_diff << 0, 0, 0,
-                     0, 0, 0,
-                     0, 0, 0;
-
-    ASSERT_TRUE(dist_vect[0].isApprox(expected_diff));
-    ASSERT_TRUE(dist_vect[1].isApprox(expected_diff));
-}
-
-TEST(GetDistVectTest, OneDimensionTest) {
-    // 1x2 matrix
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r(1, 2);
-    r << 1, 2;
-
-    std::vector<Eigen::MatrixXd> dist_vect = get_dist_vect(r);
-
-    Eigen::MatrixXd expected_diff(1, 1);
-    expected_diff << 0;
-
-    ASSERT_TRUE(dist_vect[0].isApprox(expected_diff));
-    ASSERT_TRUE(dist_vect[1].isApprox(expected_diff));
-}
-
-TEST(GetDistVectTest, HandlesSquareMatrixCorrectly) {
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r(2, 2);
-    r << 1.0, 2.0, 3.0, 4.0;
-
-    std::vector<Eigen::MatrixXd> dist_vect = get_dist_vect(r);
-
-    Eigen::MatrixXd expected_diff_x(2, 2);
-    expected_diff_x << 0.0, -2.0, 2.0, 0.0;
-
-    Eigen::MatrixXd expected_diff_y(2, 2);
-    expected_diff_y << 0.0, -2.0, 2.0, 0.0;
-
-    double tolerance = 1e-5;
-    ASSERT_TRUE(dist_vect[0].isApprox(expected_diff_x, tolerance));
-    ASSERT_TRUE(dist_vect[1].isApprox(expected_diff_y, tolerance));
-}
-
-TEST(GetDistVectTest, TenDimensionTest) {
-    // 2x2 matrix
-    Eigen::Matrix<double, Eigen::Dynamic, 2> r(10, 2);
-    r << 0.448453,  0.365021,
-        0.252378,  0.477139,
-        0.0309307,  0.327166,
-        0.903785,  0.160117,
-        0.257268,  0.436529,
-        0.289008,   0.49713,
-        0.844151,  0.209798,
-        0.268783,  0.352196,
-        0.968116,  0.673458,
-        0.188375,  0.567491;
-
-    std::vector<Eigen::MatrixXd> dist_vect = get_dist_vect(r);
-
-    Eigen::MatrixXd expected_diff_x(10, 10);
-    expected_diff_x << 0,    0.196075,    0.417522,   -0.455332,    0.191185,    0.159445,   -0.395698,     0.17967,   -0.519663,    0.260078,
-                -0.196075,           0,    0.221447,   -0.651407, -0.00488968,  -0.0366297,   -0.591773,  -0.0164047,   -0.715738,   0.0640027,
-                -0.417522,   -0.221447,           0,   -0.872854,   -0.226337,   -0.258077,    -0.81322,   -0.237852,   -0.937185,   -0.157445,
-                0.455332,    0.651407,    0.872854,           0,    0.646517,    0.614777,   0.0596337,    0.635002,   -0.064331,    0.715409,
-                -0.191185,  0.00488968,    0.226337,   -0.646517,           0,    -0.03174,   -0.586883,   -0.011515,   -0.710848,   0.0688923,
-                -0.159445,   0.0366297,    0.258077,   -0.614777,     0.03174,           0,   -0.555143,    0.020225,   -0.679108,    0.100632,
-                0.395698,    0.591773,     0.81322,  -0.0596337,    0.586883,    0.555143,           0,    0.575368,   -0.123965,    0.655776,
-                -0.17967,   0.0164047,    0.237852,   -0.635002,    0.011515,   -0.020225,   -0.575368,           0,   -0.699333,   0.0804073,
-                0.519663,    0.715738,    0.937185,    0.064331,    0.710848,    0.679108,    0.123965,    0.699333,           0,     0.77974,
-                -0.260078,  -0.0640027,    0.157445,   -0.715409,  -0.0688923,   -0.100632,   -0.655776,  -0.0804073,    -0.77974,           0;
-
-    Eigen::MatrixXd expected_diff_y(10, 10);
-    expected_diff_y << 0,  -0.112118,  0.0378543,   0.204904, -0.0715087,  -0.132109,   0.155223,  0.0128243,  -0.308438,  -0.202471,
-                0.112118,          0,   0.149973,   0.317022,  0.0406097,  -0.019991,   0.267341,   0.124943,  -0.196319, -0.0903523,
-                -0.0378543,  -0.149973,          0,   0.167049,  -0.109363,  -0.169964,   0.117369,   -0.02503,  -0.346292,  -0.240325,
-                -0.204904,  -0.317022,  -0.167049,          0,  -0.276412,  -0.337013, -0.0496807,  -0.192079,  -0.513341,  -0.407374,
-                0.0715087, -0.0406097,   0.109363,   0.276412,          0, -0.0606007,   0.226732,   0.084333,  -0.236929,  -0.130962,
-                0.132109,   0.019991,   0.169964,   0.337013,  0.0606007,          0,   0.287332,   0.144934,  -0.176328, -0.0703613,
-                -0.155223,  -0.267341,  -0.117369,  0.0496807,  -0.226732,  -0.287332,          0,  -0.142399,  -0.463661,  -0.357694,
-                -0.0128243,  -0.124943,    0.02503,   0.192079,  -0.084333,  -0.144934,   0.142399,          0,  -0.321262,  -0.215295,
-                0.308438,   0.196319,   0.346292,   0.513341,   0.236929,   0.176328,   0.463661,   0.321262,          0,   0.105967,
-                0.202471,  0.0903523,   0.240325,   0.407374,   0.130962,  0.0703613,   0.357694,   0.215295,  -0.105967,          0;
-
-    double tolerance = 1e-5;
-    ASSERT_TRUE(dist_vect[0].isApprox(expected_diff_x, tolerance));
-    ASSERT_TRUE(dist_vect[1].isApprox(expected_diff_y, tolerance));
-}
-
-
-/**
- * @brief Test the function calculate_average_n_within_distance
+ * @brief Test the alignment of calculate_pair_interactions
 */
 void CompareMatrices(const Eigen::MatrixXd& expected, const Eigen::MatrixXd& actual, double tolerance) {
     ASSERT_EQ(expected.rows(), actual.rows());
@@ -201,7 +85,26 @@ void CompareMatrices(const Eigen::MatrixXd& expected, const Eigen::MatrixXd& act
     }
 }
 
-TEST(AverageNWithinDistance, Test1){
+/**
+ * @brief Align every particle with its neighbors, all particle pairs are candidates
+*/
+void align_with_neighbors(
+    const Eigen::Matrix<double, Eigen::Dynamic, 2>& r,
+    const Eigen::MatrixXd& dist_length,
+    Eigen::Matrix<double, Eigen::Dynamic, 2>& n,
+    double σ
+){
+    std::vector<ParticlePair> pairs = all_particle_pairs(r.rows());
+    std::vector<double> pair_distances;
+    for (const auto& [i, j] : pairs) {
+        pair_distances.push_back(dist_length(i, j));
+    }
+
+    PairInteractions interactions = calculate_pair_interactions(r, n, pairs, pair_distances, 10, σ, 1, 0.75);
+    normalize_unit_vector_sums(interactions.n_sum, n);
+}
+
+TEST(PairAlignment, Test1){
     double σ = 1.4166666666666667;
 
     Eigen::MatrixXd diff_x(10, 10);
@@ -228,9 +131,9 @@ TEST(AverageNWithinDistance, Test1){
         0.109245,   0.157587,   0.398941,  -0.237915,   0.284846,   0.123872,  -0.055457,  -0.089272,          0,    0.19609,
         -0.0868453, -0.0385037,   0.202851,  -0.434006,  0.0887553,  -0.072218,  -0.251547,  -0.285362,   -0.19609,          0;
 
-    std::vector<Eigen::MatrixXd> dist_vect;
-    dist_vect.push_back(diff_x);
-    dist_vect.push_back(diff_y);
+    // The distance vectors are r_i - r_j, so the first column gives the positions up to a shift
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(10, 2);
+    r << diff_x.col(0), diff_y.col(0);
 
     Eigen::MatrixXd dist_length(10, 10);
     dist_length << 0, 1.94061, 5.60903, 8.28046, 8.47736, 11.0131, 14.2291,  6.0693, 12.7292,  10.761,
@@ -244,15 +147,79 @@ TEST(AverageNWithinDistance, Test1){
             12.7292,  10.894, 7.80554, 5.19999, 5.71498, 12.4246, 3.28317,  11.829,       0, 11.2371,
             10.761, 10.6601, 6.77901, 11.8869, 6.17054, 3.59292, 12.8653, 16.5712, 11.2371,       0;
 
-    Eigen::VectorXd n(10);
-    n << 168, 154, 290, 83, 110, 46, 48, 144, 227, 48;
+    Eigen::VectorXd n_degrees(10);
+    n_degrees << 168, 154, 290, 83, 110, 46, 48, 144, 227, 48;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = angles_to_unit_vectors(n_degrees);
 
-    calculate_average_n_within_distance(dist_vect, dist_length, n, σ);
+    align_with_neighbors(r, dist_length, n, σ);
 
     Eigen::VectorXd expected_n(10);
     expected_n << 161, 161, 191.31, 83, 191.31, 46, 48, 144, 227, 48;
 
-    CompareMatrices(expected_n, n, 2);
+    CompareMatrices(expected_n, unit_vectors_to_angles(n), 2);
+    CompareMatrices(n.rowwise().norm(), Eigen::VectorXd::Ones(10), 1e-12);
+}
+
+
+TEST(PairAlignment, MatchesTheMeanAngleOfTheNeighbors){
+    const double σ = 0.4166666666666667;
+    const int num_part = 300;
+
+    Eigen::MatrixXd dist_length = (Eigen::MatrixXd::Random(num_part, num_part).array() + 1.0) * 4 * σ;
+    dist_length = (dist_length + dist_length.transpose()).eval() / 2;
+    dist_length.diagonal().setZero();
+
+    Eigen::VectorXd n_degrees = (Eigen::VectorXd::Random(num_part).array() + 1.0) * 180;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = angles_to_unit_vectors(n_degrees);
+
+    // Reference: collect the angles of the neighbors and average them on the unit circle
+    Eigen::VectorXd expected_n(num_part);
+    for (int i = 0; i < num_part; i++) {
+        std::vector<double> angles;
+        for (int j = 0; j < num_part; j++) {
+            if (dist_length(i, j) < 2 * σ) angles.push_back(n_degrees(j));
+        }
+        expected_n(i) = mean_unit_circle_vector_angle_degrees(angles);
+    }
+
+    align_with_neighbors(Eigen::MatrixXd::Zero(num_part, 2), dist_length, n, σ);
+
+    CompareMatrices(angles_to_unit_vectors(expected_n), n, 1e-9);
+}
+
+
+TEST(AngularNoiseTest, TurnsWithinHalfTheAmplitude){
+    const int num_part = 2000;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = angles_to_unit_vectors(Eigen::VectorXd::LinSpaced(num_part, 0, 359));
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_noisy = n;
+
+    add_angular_noise(n_noisy, AngularNoise{CounterRNG(5), 30}, 3);
+
+    Eigen::VectorXd turn = (unit_vectors_to_angles(n_noisy) - unit_vectors_to_angles(n)).unaryExpr([](double d) { return std::remainder(d, 360.0); });
+    EXPECT_LE(turn.cwiseAbs().maxCoeff(), 15 + 1e-9);
+    EXPECT_GT(turn.cwiseAbs().maxCoeff(), 14);
+    EXPECT_NEAR(turn.mean(), 0, 1);
+    CompareMatrices(n_noisy.rowwise().norm(), Eigen::VectorXd::Ones(num_part), 1e-12);
+}
+
+TEST(AngularNoiseTest, SameAtEveryThreadCount){
+    const int num_part = 5000;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n = angles_to_unit_vectors(Eigen::VectorXd::LinSpaced(num_part, 0, 359));
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_single = n;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_parallel = n;
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    add_angular_noise(n_single, AngularNoise{CounterRNG(9), 20}, 11);
+    omp_set_num_threads(4);
+    add_angular_noise(n_parallel, AngularNoise{CounterRNG(9), 20}, 11);
+    omp_set_num_threads(max_threads);
+
+    EXPECT_EQ(n_single, n_parallel);
+
+    // Another step draws other numbers
+    add_angular_noise(n, AngularNoise{CounterRNG(9), 20}, 12);
+    EXPECT_NE(n, n_single);
 }
 
 
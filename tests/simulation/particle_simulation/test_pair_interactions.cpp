@@ -0,0 +1,174 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_list.h>
+#include <particle_simulation/pair_interactions.h>
+#include <utilities/angles_to_unit_vectors.h>
+
+
+class PairInteractionsTest : public ::testing::Test {
+protected:
+    const double k = 10;
+    const double σ = 0.4166666666666667;
+    const double r_adh = 1;
+    const double k_adh = 0.75;
+    const int num_part = 16;
+
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n;
+    std::vector<ParticlePair> pairs;
+    std::vector<double> pair_distances;
+
+    void SetUp() override {
+        std::srand(3);
+        r = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(num_part, 2);
+        n = angles_to_unit_vectors((Eigen::VectorXd::Random(num_part).array() + 1.0) * 180);
+
+        // Distances within and beyond 2σ and 2.4σ and two particles on the same vertex
+        pairs = all_particle_pairs(num_part);
+        for (size_t p = 0; p < pairs.size(); ++p) {
+            pair_distances.push_back((p % 7) * 0.5 * σ);
+        }
+    }
+};
+
+TEST_F(PairInteractionsTest, AlignsAndCountsTheNeighborsWithinTheirRanges) {
+    PairInteractions interactions = calculate_pair_interactions(r, n, pairs, pair_distances, k, σ, r_adh, k_adh);
+
+    // Every particle aligns with itself and the particles closer than 2σ, the nonzero distances up to 2.4σ count as neighbors
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_sum = n;
+    Eigen::VectorXd neighbor_count = Eigen::VectorXd::Zero(num_part);
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        const auto [i, j] = pairs[p];
+        if (pair_distances[p] < 2 * σ) {
+            n_sum.row(i) += n.row(j);
+            n_sum.row(j) += n.row(i);
+        }
+        if (pair_distances[p] != 0 && pair_distances[p] <= 2.4 * σ) {
+            neighbor_count(i) += 1;
+            neighbor_count(j) += 1;
+        }
+    }
+
+    EXPECT_TRUE(interactions.n_sum.isApprox(n_sum, 1e-12));
+    EXPECT_EQ(interactions.neighbor_count, neighbor_count);
+
+    // The forces between the particles cancel each other
+    EXPECT_GT(interactions.force.norm(), 0);
+    EXPECT_LT(interactions.force.colwise().sum().norm(), 1e-12 * interactions.force.norm());
+}
+
+TEST_F(PairInteractionsTest, LonelyParticleKeepsItsOrientation) {
+    PairInteractions interactions = calculate_pair_interactions(r, n, {}, {}, k, σ, r_adh, k_adh);
+
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_new;
+    normalize_unit_vector_sums(interactions.n_sum, n_new);
+
+    EXPECT_TRUE(n_new.isApprox(n, 1e-9));
+    EXPECT_TRUE(interactions.force.isZero());
+    EXPECT_TRUE(interactions.neighbor_count.isZero());
+}
+
+TEST_F(PairInteractionsTest, ParallelSumsMatchTheSerialSumsExactly) {
+    // Enough pairs, that the particles actually get split over several threads
+    const int many_particles = 400;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r_many = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(many_particles, 2);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_many = angles_to_unit_vectors((Eigen::VectorXd::Random(many_particles).array() + 1.0) * 180);
+
+    std::vector<ParticlePair> many_pairs = all_particle_pairs(many_particles);
+    std::vector<double> distances;
+    for (const auto& [i, j] : many_pairs) {
+        distances.push_back((r_many.row(i) - r_many.row(j)).norm());
+    }
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    PairInteractions serial = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::Serial);
+    PairInteractions parallel = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers);
+    omp_set_num_threads(max_threads);
+
+    // Every particle sums its pairs in the same order at any thread count
+    EXPECT_EQ(parallel.n_sum, serial.n_sum);
+    EXPECT_EQ(parallel.neighbor_count, serial.neighbor_count);
+    EXPECT_TRUE(parallel.force.isApprox(serial.force, 1e-10));
+}
+
+TEST_F(PairInteractionsTest, ReusesTheWorkspaceWhileThePairsStayTheSame) {
+    const int many_particles = 400;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r_many = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(many_particles, 2);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_many = angles_to_unit_vectors((Eigen::VectorXd::Random(many_particles).array() + 1.0) * 180);
+
+    std::vector<ParticlePair> many_pairs = all_particle_pairs(many_particles);
+    std::vector<double> distances;
+    for (const auto& [i, j] : many_pairs) {
+        distances.push_back((r_many.row(i) - r_many.row(j)).norm());
+    }
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    PairWorkspace workspace;
+    calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers, workspace);
+    const auto* neighbors = workspace.neighbors.data();
+    const auto* batch = workspace.batch.dist.data();
+    const double* force = workspace.interactions.force.data();
+    const double* n_sum = workspace.interactions.n_sum.data();
+    const double* thread_force = workspace.thread_forces[0].data();
+
+    // The next step moves the particles apart, so fewer pairs interact, but it keeps the pair list
+    for (double& distance : distances) distance *= 1.5;
+    PairInteractions reused = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers, workspace);
+    PairInteractions fresh = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers);
+    PairInteractions serial = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::Serial);
+    omp_set_num_threads(max_threads);
+
+    EXPECT_EQ(workspace.neighbors.data(), neighbors);
+    EXPECT_EQ(workspace.batch.dist.data(), batch);
+    EXPECT_EQ(workspace.interactions.force.data(), force);
+    EXPECT_EQ(workspace.interactions.n_sum.data(), n_sum);
+    EXPECT_EQ(workspace.thread_forces[0].data(), thread_force);
+    EXPECT_EQ(workspace.neighbors_generation, 0);
+
+    EXPECT_EQ(reused.n_sum, fresh.n_sum);
+    EXPECT_EQ(reused.neighbor_count, fresh.neighbor_count);
+    EXPECT_EQ(reused.force, fresh.force);
+    EXPECT_EQ(reused.n_sum, serial.n_sum);
+    EXPECT_EQ(reused.neighbor_count, serial.neighbor_count);
+}
+
+TEST_F(PairInteractionsTest, RebuildsTheNeighborRowsForANewPairList) {
+    const int many_particles = 400;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r_many = Eigen::Matrix<double, Eigen::Dynamic, 2>::Random(many_particles, 2);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> n_many = angles_to_unit_vectors((Eigen::VectorXd::Random(many_particles).array() + 1.0) * 180);
+
+    std::vector<ParticlePair> many_pairs = all_particle_pairs(many_particles);
+    std::vector<double> distances;
+    for (const auto& [i, j] : many_pairs) {
+        distances.push_back((r_many.row(i) - r_many.row(j)).norm());
+    }
+
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    PairWorkspace workspace;
+    calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers, workspace);
+
+    // Same number of pairs, but the neighbor search handed out another list
+    std::reverse(many_pairs.begin(), many_pairs.end());
+    std::reverse(distances.begin(), distances.end());
+    ++workspace.pairs_generation;
+    PairInteractions reused = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::ThreadLocalBuffers, workspace);
+    PairInteractions serial = calculate_pair_interactions(r_many, n_many, many_pairs, distances, k, σ, r_adh, k_adh, ForceReduction::Serial);
+    omp_set_num_threads(max_threads);
+
+    EXPECT_EQ(workspace.neighbors_generation, 1);
+    EXPECT_EQ(reused.n_sum, serial.n_sum);
+    EXPECT_EQ(reused.neighbor_count, serial.neighbor_count);
+    EXPECT_TRUE(reused.force.isApprox(serial.force, 1e-10));
+}
@@ -0,0 +1,177 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/distance_matrix.h>
+#include <utilities/simulation_context.h>
+
+#include <2DTissue.h>
+
+
+/**
+ * @brief Distance matrix, which counts how often it gets copied
+*/
+class CopyCountingDistances : public DistanceMatrix {
+public:
+    static inline int copies = 0;
+
+    explicit CopyCountingDistances(const Eigen::MatrixXd& matrix) : DistanceMatrix(matrix) {}
+    CopyCountingDistances(const CopyCountingDistances& other) : DistanceMatrix(other) { ++copies; }
+};
+
+
+static_assert(!std::is_copy_constructible_v<SimulationContext>, "The simulation context has to be passed by reference");
+static_assert(!std::is_copy_assignable_v<SimulationContext>, "The simulation context has to be passed by reference");
+
+
+/**
+ * @brief Flat UV grid over the unit square, whose 3D mesh is the same grid scaled by 10
+*/
+class SimulationContextTest : public ::testing::Test {
+protected:
+    static constexpr int grid_size = 40;
+    const int num_vertices = (grid_size + 1) * (grid_size + 1);
+    const int num_part = 8;
+    const int num_steps = 4;
+    std::shared_ptr<const SimulationContext> context;
+
+    void SetUp() override {
+        Eigen::MatrixXd vertices_UV(num_vertices, 3);
+        std::vector<int64_t> h_v_mapping(num_vertices);
+        for (int v = 0; v < num_vertices; ++v) {
+            vertices_UV.row(v) << double(v % (grid_size + 1)) / grid_size, double(v / (grid_size + 1)) / grid_size, 0;
+            h_v_mapping[v] = v;
+        }
+        Eigen::MatrixXd vertices_3D = 10 * vertices_UV;
+
+        Eigen::MatrixXi faces_uv(2 * grid_size * grid_size, 3);
+        int face = 0;
+        for (int y = 0; y < grid_size; ++y) {
+            for (int x = 0; x < grid_size; ++x) {
+                const int v = (grid_size + 1) * y + x;
+                faces_uv.row(face++) << v, v + 1, v + grid_size + 2;
+                faces_uv.row(face++) << v, v + grid_size + 2, v + grid_size + 1;
+            }
+        }
+
+        Eigen::MatrixXd distances(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                distances(i, j) = (vertices_3D.row(i) - vertices_3D.row(j)).norm();
+            }
+        }
+
+        context = std::make_shared<const SimulationContext>(
+            std::make_shared<CopyCountingDistances>(distances),
+            UVFaceTable{faces_uv, faces_uv.cast<int64_t>()},
+            h_v_mapping,
+            vertices_UV,
+            vertices_3D,
+            "meshes/sphere_uv_test.off"
+        );
+    }
+};
+
+TEST_F(SimulationContextTest, StepsDoNotCopyTheStaticData) {
+    const double* vertices_3D = context->vertices_3D.data();
+    const double* vertices_UV = context->vertices_UV.data();
+    const int* faces_uv = context->faces_uv.data();
+    const int64_t* h_v_mapping = context->h_v_mapping.data();
+
+    _2DTissue tissue(context, num_part, num_steps);
+    tissue.start();
+
+    // The tissue shares the context and its distances, it neither copies them nor hands them out to the steps
+    const long context_owners = context.use_count();
+    const long distance_owners = context->distance_matrix.use_count();
+    EXPECT_EQ(context_owners, 2);
+
+    CopyCountingDistances::copies = 0;
+    System system;
+    for (int step = 0; step < num_steps; ++step) {
+        system = tissue.update();
+    }
+
+    EXPECT_EQ(CopyCountingDistances::copies, 0);
+    EXPECT_EQ(context.use_count(), context_owners);
+    EXPECT_EQ(context->distance_matrix.use_count(), distance_owners);
+    EXPECT_EQ(context->vertices_3D.data(), vertices_3D);
+    EXPECT_EQ(context->vertices_UV.data(), vertices_UV);
+    EXPECT_EQ(context->faces_uv.data(), faces_uv);
+    EXPECT_EQ(context->h_v_mapping.data(), h_v_mapping);
+    EXPECT_TRUE(tissue.is_finished());
+
+    // get_r3d lifted every particle through the affine map of its face onto the scaled grid
+    ASSERT_EQ(system.particles.size(), static_cast<size_t>(num_part));
+    for (const Particle& particle : system.particles) {
+        EXPECT_NEAR(particle.x_3D, 10 * particle.x_UV, 1e-9);
+        EXPECT_NEAR(particle.y_3D, 10 * particle.y_UV, 1e-9);
+        EXPECT_NEAR(particle.z_3D, 0, 1e-9);
+    }
+}
+
+TEST_F(SimulationContextTest, UsesTheFaceTableAsUVMesh) {
+    EXPECT_EQ(context->halfedges_uv.data(), context->vertices_UV.data());
+    EXPECT_EQ(context->faces_uv.rows(), 2 * grid_size * grid_size);
+    EXPECT_EQ(context->face_vertex_ids(7, 2), context->h_v_mapping[context->faces_uv(7, 2)]);
+}
+
+TEST_F(SimulationContextTest, RejectsAnIncompleteFaceTable) {
+    Eigen::MatrixXi rows = Eigen::MatrixXi::Zero(2, 3);
+    EXPECT_THROW(
+        SimulationContext(context->distance_matrix, UVFaceTable{rows, Eigen::Matrix<int64_t, Eigen::Dynamic, 3>(1, 3)}, {0}, Eigen::MatrixXd::Zero(1, 3), Eigen::MatrixXd::Zero(1, 3), "ellipsoid_uv.off"),
+        std::invalid_argument
+    );
+}
+
+TEST_F(SimulationContextTest, RejectsAFaceTableOutsideOfTheVertices) {
+    Eigen::MatrixXi rows(1, 3);
+    rows << 0, 1, 3;
+    Eigen::Matrix<int64_t, Eigen::Dynamic, 3> ids = rows.cast<int64_t>();
+
+    // The row 3 does not exist, the derived members would read behind the vertices
+    EXPECT_THROW(
+        SimulationContext(context->distance_matrix, UVFaceTable{rows, ids}, {0, 1, 2}, Eigen::MatrixXd::Zero(3, 3), Eigen::MatrixXd::Zero(3, 3), "ellipsoid_uv.off"),
+        std::invalid_argument
+    );
+
+    // Every row needs its 3D position and the 3D vertex id of the face corner has to be the one of its row
+    rows << 0, 1, 2;
+    EXPECT_THROW(
+        SimulationContext(context->distance_matrix, UVFaceTable{rows, rows.cast<int64_t>()}, {0, 1, 2}, Eigen::MatrixXd::Zero(3, 3), Eigen::MatrixXd::Zero(2, 3), "ellipsoid_uv.off"),
+        std::invalid_argument
+    );
+    EXPECT_THROW(
+        SimulationContext(context->distance_matrix, UVFaceTable{rows, rows.cast<int64_t>()}, {0, 1, 5}, Eigen::MatrixXd::Zero(3, 3), Eigen::MatrixXd::Zero(3, 3), "ellipsoid_uv.off"),
+        std::invalid_argument
+    );
+}
+
+TEST_F(SimulationContextTest, DerivesTheSeamTypeFromTheUVMesh) {
+    EXPECT_EQ(context->seam_type, SeamType::Opposite);
+    EXPECT_EQ(context->mesh_file_path, "meshes/sphere_uv_test.off");
+}
+
+TEST(TissueArgumentsTest, RejectsVertexNeighborhoodsOnLazyDistanceRows) {
+    // The arguments get checked before the mesh is read, so the mesh does not have to exist
+    EXPECT_THROW(
+        _2DTissue(
+            "meshes/missing_mesh.off", 8, 1,
+            TissueDefaults::v0, TissueDefaults::k, TissueDefaults::k_next, TissueDefaults::v0_next, TissueDefaults::σ,
+            TissueDefaults::μ, TissueDefaults::r_adh, TissueDefaults::k_adh, TissueDefaults::step_size, 30,
+            MatrixDtype::Float64, std::numeric_limits<double>::infinity(), 1 << 20, "", HeatMethodVariant::IntrinsicDelaunay, 32, "",
+            NeighborSearchType::MeshVertices
+        ),
+        std::invalid_argument
+    );
+}
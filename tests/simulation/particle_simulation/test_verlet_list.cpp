@@ -0,0 +1,250 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/verlet_list.h>
+#include <particle_simulation/vertex_neighborhoods.h>
+#include <utilities/distance_matrix.h>
+#include <utilities/heat_method.h>
+
+
+/**
+ * @brief Particles on the vertices of a ring, whose geodesic distance is the shorter way around the ring
+*/
+class VerletListTest : public ::testing::Test {
+protected:
+    const int num_vertices = 60;
+    const double cutoff = 3;
+    const double skin = 4;
+    std::shared_ptr<DistanceMatrix> distance_matrix;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r_UV;
+
+    void SetUp() override {
+        Eigen::MatrixXd matrix(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                const int steps = std::abs(i - j);
+                matrix(i, j) = std::min(steps, num_vertices - steps);
+            }
+        }
+        distance_matrix = std::make_shared<DistanceMatrix>(matrix);
+    }
+
+    VerletList make_verlet_list() {
+        auto candidates = std::make_shared<VertexNeighborhoods>(*distance_matrix, cutoff + skin);
+        return VerletList(candidates, distance_matrix, cutoff, skin);
+    }
+
+    std::set<ParticlePair> pairs_within_cutoff(const std::vector<int>& vertices) {
+        std::set<ParticlePair> pairs;
+        for (int i = 0; i < static_cast<int>(vertices.size()); ++i) {
+            for (int j = i + 1; j < static_cast<int>(vertices.size()); ++j) {
+                if (distance_matrix->distances_between({vertices[i], vertices[j]})(0, 1) <= cutoff) {
+                    pairs.insert({i, j});
+                }
+            }
+        }
+        return pairs;
+    }
+};
+
+TEST_F(VerletListTest, ReusesThePairsWithinHalfTheSkin) {
+    VerletList verlet_list = make_verlet_list();
+
+    auto first = verlet_list.find_pairs(r_UV, {0, 5, 20});
+    auto second = verlet_list.find_pairs(r_UV, {2, 5, 18});
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(verlet_list.stats().steps, 2);
+    EXPECT_EQ(verlet_list.stats().rebuilds, 1);
+}
+
+TEST_F(VerletListTest, RebuildsAfterMovingMoreThanHalfTheSkin) {
+    VerletList verlet_list = make_verlet_list();
+
+    verlet_list.find_pairs(r_UV, {0, 5, 20});
+    verlet_list.find_pairs(r_UV, {0, 8, 20});
+
+    EXPECT_EQ(verlet_list.stats().rebuilds, 2);
+    EXPECT_DOUBLE_EQ(verlet_list.stats().rebuild_rate(), 1.0);
+}
+
+TEST_F(VerletListTest, KeepsThePairWorkspaceUntilTheNextRebuild) {
+    VerletList verlet_list = make_verlet_list();
+
+    verlet_list.find_pairs(r_UV, {0, 5, 20});
+    const int64_t first_generation = verlet_list.workspace().pairs_generation;
+    verlet_list.find_pairs(r_UV, {2, 5, 18});
+    EXPECT_EQ(verlet_list.workspace().pairs_generation, first_generation);
+
+    verlet_list.find_pairs(r_UV, {0, 8, 20});
+    EXPECT_NE(verlet_list.workspace().pairs_generation, first_generation);
+}
+
+TEST_F(VerletListTest, RebuildsIfTheParticleCountChanges) {
+    VerletList verlet_list = make_verlet_list();
+
+    verlet_list.find_pairs(r_UV, {0, 5});
+    verlet_list.find_pairs(r_UV, {0, 5, 20});
+
+    EXPECT_EQ(verlet_list.stats().rebuilds, 2);
+}
+
+TEST_F(VerletListTest, NeverMissesAPairWithinTheCutoff) {
+    VerletList verlet_list = make_verlet_list();
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> uniform(0, num_vertices - 1);
+    std::uniform_int_distribution<int> hop(-1, 1);
+
+    std::vector<int> vertices(25);
+    for (int& vertex : vertices) {
+        vertex = uniform(gen);
+    }
+
+    for (int step = 0; step < 50; ++step) {
+        auto pairs = verlet_list.find_pairs(r_UV, vertices);
+        std::set<ParticlePair> listed(pairs.begin(), pairs.end());
+
+        for (const ParticlePair& pair : pairs_within_cutoff(vertices)) {
+            EXPECT_TRUE(listed.count(pair)) << "step " << step << ": " << pair.first << " " << pair.second;
+        }
+
+        for (int& vertex : vertices) {
+            vertex = (vertex + hop(gen) + num_vertices) % num_vertices;
+        }
+    }
+
+    // Single vertex hops stay within half of the skin for a few steps
+    EXPECT_LT(verlet_list.stats().rebuilds, verlet_list.stats().steps);
+}
+
+TEST_F(VerletListTest, RejectsANegativeSkin) {
+    auto candidates = std::make_shared<VertexNeighborhoods>(*distance_matrix, cutoff);
+    EXPECT_THROW(VerletList(candidates, distance_matrix, cutoff, -1), std::invalid_argument);
+}
+
+
+/**
+ * @brief Particles hopping along the edges of a unit icosphere, whose distances come from the heat method
+ *
+ * The heat method distances only fulfill the triangle inequality up to their error.
+*/
+class HeatMethodVerletListTest : public ::testing::Test {
+protected:
+    const double cutoff = 0.3;
+    const double skin = 1.0;
+    std::shared_ptr<DistanceMatrix> distance_matrix;
+    std::vector<std::vector<int>> vertex_neighbors;
+    double mean_edge_length;
+
+    void SetUp() override {
+        const double phi = (1.0 + std::sqrt(5.0)) / 2.0;
+        std::vector<Eigen::Vector3d> points {
+            {-1, phi, 0}, {1, phi, 0}, {-1, -phi, 0}, {1, -phi, 0},
+            {0, -1, phi}, {0, 1, phi}, {0, -1, -phi}, {0, 1, -phi},
+            {phi, 0, -1}, {phi, 0, 1}, {-phi, 0, -1}, {-phi, 0, 1}
+        };
+        std::vector<Eigen::Vector3i> triangles {
+            {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+            {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+            {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+            {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+        };
+        for (auto& point : points) point.normalize();
+
+        for (int level = 0; level < 3; ++level) {
+            std::map<std::pair<int, int>, int> midpoints;
+            auto midpoint = [&](int a, int b) {
+                auto key = std::minmax(a, b);
+                auto it = midpoints.find(key);
+                if (it != midpoints.end()) return it->second;
+                points.push_back((points[a] + points[b]).normalized());
+                return midpoints[key] = points.size() - 1;
+            };
+
+            std::vector<Eigen::Vector3i> refined;
+            for (const auto& t : triangles) {
+                int ab = midpoint(t[0], t[1]), bc = midpoint(t[1], t[2]), ca = midpoint(t[2], t[0]);
+                refined.push_back({t[0], ab, ca});
+                refined.push_back({t[1], bc, ab});
+                refined.push_back({t[2], ca, bc});
+                refined.push_back({ab, bc, ca});
+            }
+            triangles = refined;
+        }
+
+        Eigen::MatrixXd vertices(points.size(), 3);
+        for (size_t i = 0; i < points.size(); ++i) vertices.row(i) = points[i];
+        Eigen::MatrixXi faces(triangles.size(), 3);
+        for (size_t i = 0; i < triangles.size(); ++i) faces.row(i) = triangles[i];
+
+        std::vector<int> source_ids(vertices.rows());
+        for (int i = 0; i < vertices.rows(); ++i) source_ids[i] = i;
+        distance_matrix = std::make_shared<DistanceMatrix>(HeatMethodSolver(vertices, faces).distances(source_ids));
+        mean_edge_length = HeatMethodSolver::mean_edge_length(vertices, faces);
+
+        vertex_neighbors.resize(vertices.rows());
+        for (const auto& t : triangles) {
+            for (int corner = 0; corner < 3; ++corner) {
+                vertex_neighbors[t[corner]].push_back(t[(corner + 1) % 3]);
+            }
+        }
+    }
+};
+
+TEST_F(HeatMethodVerletListTest, NeverMissesAPairWithinTheCutoff) {
+    auto candidates = std::make_shared<VertexNeighborhoods>(*distance_matrix, cutoff + skin);
+    VerletList verlet_list(candidates, distance_matrix, cutoff, skin, mean_edge_length);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r_UV;
+
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> uniform(0, distance_matrix->rows() - 1);
+    std::bernoulli_distribution hops(0.3);
+
+    std::vector<int> vertices(40);
+    for (int& vertex : vertices) {
+        vertex = uniform(gen);
+    }
+
+    for (int step = 0; step < 200; ++step) {
+        auto pairs = verlet_list.find_pairs(r_UV, vertices);
+        std::set<ParticlePair> listed(pairs.begin(), pairs.end());
+
+        // Brute force over all pairs of particles
+        for (int i = 0; i < static_cast<int>(vertices.size()); ++i) {
+            for (int j = i + 1; j < static_cast<int>(vertices.size()); ++j) {
+                if ((*distance_matrix)(vertices[i], vertices[j]) <= cutoff) {
+                    EXPECT_TRUE(listed.count({i, j})) << "step " << step << ": " << i << " " << j;
+                }
+            }
+        }
+
+        for (int& vertex : vertices) {
+            if (hops(gen)) {
+                const std::vector<int>& neighbors = vertex_neighbors[vertex];
+                vertex = neighbors[std::uniform_int_distribution<int>(0, neighbors.size() - 1)(gen)];
+            }
+        }
+    }
+
+    EXPECT_LT(verlet_list.stats().rebuilds, verlet_list.stats().steps);
+}
+
+TEST_F(HeatMethodVerletListTest, RejectsANegativeDistanceError) {
+    auto candidates = std::make_shared<VertexNeighborhoods>(*distance_matrix, cutoff + skin);
+    EXPECT_THROW(VerletList(candidates, distance_matrix, cutoff, skin, -0.1), std::invalid_argument);
+}
@@ -0,0 +1,98 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-26
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/vertex_neighborhoods.h>
+#include <utilities/distance_matrix.h>
+
+
+/**
+ * @brief Vertices on a ring, whose geodesic distance is the shorter way around the ring
+*/
+class VertexNeighborhoodsTest : public ::testing::Test {
+protected:
+    const int num_vertices = 40;
+    Eigen::MatrixXd matrix;
+
+    void SetUp() override {
+        matrix.resize(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                const int steps = std::abs(i - j);
+                matrix(i, j) = std::min(steps, num_vertices - steps);
+            }
+        }
+    }
+
+    std::vector<int> random_vertices(int num_part) {
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<int> uniform(0, num_vertices - 1);
+
+        std::vector<int> vertices(num_part);
+        for (int& vertex : vertices) {
+            vertex = uniform(gen);
+        }
+        return vertices;
+    }
+};
+
+TEST_F(VertexNeighborhoodsTest, CollectsTheVerticesWithinTheCutoff) {
+    VertexNeighborhoods neighborhoods(DistanceMatrix(matrix), 1.5);
+
+    auto [begin, end] = neighborhoods.neighborhood(0);
+    EXPECT_EQ(std::vector<int>(begin, end), std::vector<int>({0, 1, 39}));
+}
+
+TEST_F(VertexNeighborhoodsTest, SparseMatrixGivesTheSameNeighborhoods) {
+    VertexNeighborhoods dense(DistanceMatrix(matrix), 3);
+    VertexNeighborhoods sparse(DistanceMatrix(matrix, MatrixDtype::Float64, 4), 3);
+
+    for (int v = 0; v < num_vertices; ++v) {
+        auto [dense_begin, dense_end] = dense.neighborhood(v);
+        auto [sparse_begin, sparse_end] = sparse.neighborhood(v);
+        EXPECT_EQ(std::vector<int>(dense_begin, dense_end), std::vector<int>(sparse_begin, sparse_end));
+    }
+}
+
+TEST_F(VertexNeighborhoodsTest, FindsEveryPairWithinTheCutoff) {
+    const double cutoff = 2;
+    VertexNeighborhoods neighborhoods(DistanceMatrix(matrix), cutoff);
+
+    // More particles than vertices, so that several particles share a vertex
+    std::vector<int> vertices_active = random_vertices(100);
+    std::vector<ParticlePair> pairs = neighborhoods.candidate_pairs(vertices_active);
+    std::set<ParticlePair> candidates(pairs.begin(), pairs.end());
+
+    std::set<ParticlePair> expected;
+    for (int i = 0; i < 100; ++i) {
+        for (int j = i + 1; j < 100; ++j) {
+            if (matrix(vertices_active[i], vertices_active[j]) <= cutoff) {
+                expected.insert({i, j});
+            }
+        }
+    }
+
+    // The neighborhoods match the cutoff exactly, so there are no additional candidates
+    EXPECT_EQ(candidates.size(), pairs.size());
+    EXPECT_EQ(candidates, expected);
+}
+
+TEST_F(VertexNeighborhoodsTest, RejectsVerticesOutsideOfTheMesh) {
+    VertexNeighborhoods neighborhoods(DistanceMatrix(matrix), 1);
+
+    EXPECT_THROW(neighborhoods.candidate_pairs({0, num_vertices}), std::out_of_range);
+}
+
+TEST_F(VertexNeighborhoodsTest, RejectsASparseMatrixWithASmallerCutoff) {
+    EXPECT_THROW(VertexNeighborhoods(DistanceMatrix(matrix, MatrixDtype::Float64, 2), 3), std::invalid_argument);
+    EXPECT_NO_THROW(VertexNeighborhoods(DistanceMatrix(matrix, MatrixDtype::Float64, 3), 3));
+}
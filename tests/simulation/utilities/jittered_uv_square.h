@@ -0,0 +1,33 @@
+// jittered_uv_square.h
+#pragma once
+
+#include <random>
+#include <Eigen/Dense>
+
+
+/**
+ * @brief Triangulation of the UV square with n x n quads, whose vertices get jittered by up to 30% of a quad
+ *
+ * The boundary vertices only slide along the boundary, so the mesh still covers the whole square.
+*/
+inline void jittered_uv_square(int n, std::mt19937& gen, Eigen::MatrixXd& halfedges_uv, Eigen::MatrixXi& faces_uv) {
+    std::uniform_real_distribution<double> jitter(-0.3 / n, 0.3 / n);
+
+    halfedges_uv.resize((n + 1) * (n + 1), 3);
+    for (int y = 0; y <= n; ++y) {
+        for (int x = 0; x <= n; ++x) {
+            const bool inner_x = x > 0 && x < n;
+            const bool inner_y = y > 0 && y < n;
+            halfedges_uv.row(y * (n + 1) + x) << double(x) / n + (inner_x ? jitter(gen) : 0), double(y) / n + (inner_y ? jitter(gen) : 0), 0;
+        }
+    }
+
+    faces_uv.resize(2 * n * n, 3);
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            const int v = y * (n + 1) + x;
+            faces_uv.row(2 * (y * n + x)) << v, v + 1, v + n + 2;
+            faces_uv.row(2 * (y * n + x) + 1) << v, v + n + 2, v + n + 1;
+        }
+    }
+}
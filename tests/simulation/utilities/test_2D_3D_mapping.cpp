@@ -0,0 +1,144 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/2D_3D_mapping.h>
+#include <utilities/distance_matrix.h>
+#include <utilities/simulation_context.h>
+
+
+/**
+ * @brief Square cylinder cut open along the seam u = 0, whose UV chart has the seam column twice
+ *
+ * The rows of the last column are copies of the first one, they share the 3D vertex ids and coordinates.
+*/
+class R3DMappingTest : public ::testing::Test {
+protected:
+    const int nx = 4;
+    const int ny = 2;
+    std::shared_ptr<const SimulationContext> context;
+    std::mt19937 gen{7};
+
+    void SetUp() override {
+        const int num_rows = (nx + 1) * (ny + 1);
+        Eigen::MatrixXd vertices_UV(num_rows, 3);
+        Eigen::MatrixXd vertices_3D(num_rows, 3);
+        std::vector<int64_t> h_v_mapping(num_rows);
+        for (int y = 0; y <= ny; ++y) {
+            for (int x = 0; x <= nx; ++x) {
+                const int row = y * (nx + 1) + x;
+                const double angle = 2 * M_PI * x / nx;
+                vertices_UV.row(row) << double(x) / nx, double(y) / ny, 0;
+                vertices_3D.row(row) << std::cos(angle), std::sin(angle), double(y) / ny;
+                h_v_mapping[row] = y * nx + x % nx;
+            }
+        }
+
+        Eigen::MatrixXi faces_uv(2 * nx * ny, 3);
+        for (int y = 0; y < ny; ++y) {
+            for (int x = 0; x < nx; ++x) {
+                const int v = y * (nx + 1) + x;
+                faces_uv.row(2 * (y * nx + x)) << v, v + 1, v + nx + 2;
+                faces_uv.row(2 * (y * nx + x) + 1) << v, v + nx + 2, v + nx + 1;
+            }
+        }
+
+        Eigen::Matrix<int64_t, Eigen::Dynamic, 3> face_vertex_ids(faces_uv.rows(), 3);
+        for (int f = 0; f < faces_uv.rows(); ++f) {
+            for (int c = 0; c < 3; ++c) {
+                face_vertex_ids(f, c) = h_v_mapping[faces_uv(f, c)];
+            }
+        }
+
+        context = std::make_shared<const SimulationContext>(
+            std::make_shared<DistanceMatrix>(Eigen::MatrixXd::Zero(nx * (ny + 1), nx * (ny + 1))),
+            UVFaceTable{faces_uv, face_vertex_ids},
+            h_v_mapping,
+            vertices_UV,
+            vertices_3D,
+            "meshes/sphere_uv_cylinder.off"
+        );
+    }
+
+    // The scan over all faces of the UV file, which the step replaced by the face walk and the face grid
+    std::pair<Eigen::MatrixXd, std::vector<int>> get_r3d_by_scan(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r) {
+        return get_r3d(r, context->halfedges_uv, context->faces_uv, context->vertices_UV, context->vertices_3D, context->h_v_mapping);
+    }
+
+    void expect_inside_of_their_faces(const Eigen::Matrix<double, Eigen::Dynamic, 2>& r, const std::vector<int>& particle_faces) {
+        for (int i = 0; i < r.rows(); ++i) {
+            Eigen::Vector3d barycentric = context->uv_affine_maps.barycentric(r.row(i).transpose(), particle_faces[i]);
+            EXPECT_GT(barycentric.minCoeff(), -1e-12) << "particle " << i << " is outside of face " << particle_faces[i];
+        }
+    }
+};
+
+TEST_F(R3DMappingTest, LiftsLikeTheScanOverAllFaces) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(200, 2);
+    for (int i = 0; i < r.rows(); ++i) {
+        r.row(i) << uniform(gen), uniform(gen);
+    }
+
+    std::vector<int> particle_faces;
+    auto [r_3D, vertices_3D_active] = get_r3d(r, *context, particle_faces);
+    auto [r_3D_scan, vertices_3D_active_scan] = get_r3d_by_scan(r);
+
+    expect_inside_of_their_faces(r, particle_faces);
+    EXPECT_TRUE(r_3D.isApprox(r_3D_scan, 1e-12));
+    EXPECT_EQ(vertices_3D_active, vertices_3D_active_scan);
+}
+
+TEST_F(R3DMappingTest, TracksParticlesAcrossFacesAndTheSeam) {
+    // Particles drift along u and wrap around the seam like on the simulated surface
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(4, 2);
+    r << 0.05, 0.1,
+         0.30, 0.6,
+         0.55, 0.3,
+         0.80, 0.9;
+    std::vector<int> particle_faces(r.rows(), -1);
+    auto [r_3D, vertices_3D_active] = get_r3d(r, *context, particle_faces);
+
+    for (int step = 0; step < 60; ++step) {
+        Eigen::MatrixXd r_3D_old = r_3D;
+        r.col(0) = (r.col(0).array() + 0.02).unaryExpr([](double u) { return u - std::floor(u); });
+        r.col(1) = (r.col(1).array() + 0.005).unaryExpr([](double v) { return v - std::floor(v); });
+
+        std::tie(r_3D, vertices_3D_active) = get_r3d(r, *context, particle_faces);
+        auto [r_3D_scan, vertices_3D_active_scan] = get_r3d_by_scan(r);
+
+        expect_inside_of_their_faces(r, particle_faces);
+        ASSERT_TRUE(r_3D.isApprox(r_3D_scan, 1e-12)) << "step " << step;
+        ASSERT_EQ(vertices_3D_active, vertices_3D_active_scan) << "step " << step;
+
+        // The lift is continuous across the seam, only the jump of v at the top of the chart moves a particle far
+        for (int i = 0; i < r.rows(); ++i) {
+            if (r(i, 1) >= 0.005) {
+                EXPECT_LT((r_3D.row(i) - r_3D_old.row(i)).norm(), 0.2) << "particle " << i << " at step " << step;
+            }
+        }
+    }
+}
+
+TEST_F(R3DMappingTest, BothSidesOfTheSeamShareTheirVertex) {
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(2, 2);
+    r << 0.99, 0.02,
+         0.01, 0.02;
+
+    std::vector<int> particle_faces;
+    auto [r_3D, vertices_3D_active] = get_r3d(r, *context, particle_faces);
+
+    EXPECT_NE(particle_faces[0], particle_faces[1]);
+    EXPECT_EQ(vertices_3D_active[0], 0);
+    EXPECT_EQ(vertices_3D_active[1], 0);
+    EXPECT_LT((r_3D.row(0) - r_3D.row(1)).norm(), 0.2);
+}
@@ -5,6 +5,8 @@
 
 #include <gtest/gtest.h>
 #include <fstream>
+#include <string>
+#include <vector>
 #include <boost/filesystem.hpp>
 
 #include <utilities/2D_surface.h>
@@ -111,3 +113,104 @@ TEST_F(MyTestFixture, MaxDistance) {
     // Distance from start node to node 42
     EXPECT_EQ(max_distance, expected_distance);
 }
+
+
+/**
+ * @brief Octahedron as the smallest closed mesh, which gets cut open and parameterized into a cache folder
+*/
+class UVFaceTableTest : public ::testing::Test {
+protected:
+    fs::path directory;
+    std::string mesh_path;
+    _3D::Mesh mesh;
+
+    void SetUp() override {
+        directory = fs::temp_directory_path() / fs::unique_path("uv_face_table_%%%%-%%%%");
+        fs::create_directories(directory);
+        mesh_path = (directory / "octahedron.off").string();
+
+        std::ofstream out(mesh_path);
+        out << "OFF\n6 8 0\n"
+            << "1 0 0\n-1 0 0\n0 1 0\n0 -1 0\n0 0 1\n0 0 -1\n"
+            << "3 0 2 4\n3 2 1 4\n3 1 3 4\n3 3 0 4\n"
+            << "3 2 0 5\n3 1 2 5\n3 3 1 5\n3 0 3 5\n";
+        out.close();
+
+        std::ifstream in(mesh_path);
+        in >> mesh;
+    }
+
+    void TearDown() override {
+        fs::remove_all(directory);
+    }
+
+    // Reads the UV coordinates and the faces of the written UV mesh
+    static void read_uv_off(const std::string& path, Eigen::MatrixXd& vertices, Eigen::MatrixXi& faces) {
+        std::ifstream in(path);
+        std::string header;
+        int num_vertices, num_faces, num_edges;
+        in >> header >> num_vertices >> num_faces >> num_edges;
+
+        vertices.resize(num_vertices, 3);
+        for (int v = 0; v < num_vertices; ++v) {
+            in >> vertices(v, 0) >> vertices(v, 1) >> vertices(v, 2);
+        }
+
+        faces.resize(num_faces, 3);
+        for (int f = 0; f < num_faces; ++f) {
+            int corners;
+            in >> corners >> faces(f, 0) >> faces(f, 1) >> faces(f, 2);
+        }
+    }
+};
+
+TEST_F(UVFaceTableTest, RowsMatchTheWrittenUVMeshAndThe3DMesh) {
+    auto [h_v_mapping, vertices_UV, vertices_3D, uv_mesh_path, face_table] = create_uv_surface(mesh_path, 0, (directory / "cache").string());
+
+    Eigen::MatrixXd file_vertices;
+    Eigen::MatrixXi file_faces;
+    read_uv_off(uv_mesh_path, file_vertices, file_faces);
+
+    ASSERT_EQ(face_table.vertex_rows.rows(), static_cast<int>(num_faces(mesh)));
+    ASSERT_EQ(file_faces.rows(), face_table.vertex_rows.rows());
+
+    // The file lists its faces in another order, so every row has to find a face of the file with the same UV corners in the same orientation
+    std::vector<bool> matched(file_faces.rows(), false);
+    for (int f = 0; f < face_table.vertex_rows.rows(); ++f) {
+        int match = -1;
+        for (int g = 0; g < file_faces.rows() && match < 0; ++g) {
+            for (int shift = 0; shift < 3 && match < 0; ++shift) {
+                bool same_corners = true;
+                for (int c = 0; c < 3; ++c) {
+                    Eigen::Vector2d uv = vertices_UV.row(face_table.vertex_rows(f, c)).head<2>();
+                    Eigen::Vector2d file_uv = file_vertices.row(file_faces(g, (c + shift) % 3)).head<2>();
+                    same_corners = same_corners && (uv - file_uv).norm() < 1e-5;
+                }
+                if (same_corners && !matched[g]) {
+                    match = g;
+                }
+            }
+        }
+        ASSERT_GE(match, 0) << "UV face " << f << " is missing in " << uv_mesh_path;
+        matched[match] = true;
+    }
+
+    // Face f of the table is face f of the 3D mesh, with the same corners in the same orientation
+    int f = 0;
+    for (auto fd : faces(mesh)) {
+        int c = 0;
+        for (_3D::halfedge_descriptor hd : halfedges_around_face(halfedge(fd, mesh), mesh)) {
+            const int row = face_table.vertex_rows(f, c);
+            const int64_t vertex_id = target(hd, mesh);
+            const auto point = mesh.point(target(hd, mesh));
+
+            EXPECT_EQ(face_table.vertex_ids(f, c), vertex_id);
+            EXPECT_EQ(h_v_mapping[row], vertex_id);
+            EXPECT_DOUBLE_EQ(vertices_3D(row, 0), point.x());
+            EXPECT_DOUBLE_EQ(vertices_3D(row, 1), point.y());
+            EXPECT_DOUBLE_EQ(vertices_3D(row, 2), point.z());
+            ++c;
+        }
+        ++f;
+    }
+}
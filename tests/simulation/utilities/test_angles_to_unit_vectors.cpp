@@ -36,3 +36,17 @@ TEST(AngleToUnitVectorTest, BasicAssertions) {
     ASSERT_NEAR(n_vec(5, 0), 1, 1e-9);
     ASSERT_NEAR(n_vec(5, 1), 0, 1e-9);
 }
+
+TEST(AngleToUnitVectorTest, RoundTripIntoTheRangeOf360Degrees) {
+    Eigen::VectorXd angles(5);
+    angles << 0, 45, 180, 270, 359.5;
+
+    Eigen::VectorXd round_trip = unit_vectors_to_angles(angles_to_unit_vectors(angles));
+    ASSERT_TRUE(round_trip.isApprox(angles, 1e-12));
+
+    Eigen::VectorXd wrapped(2);
+    wrapped << -90, 450;
+    Eigen::VectorXd expected(2);
+    expected << 270, 90;
+    ASSERT_TRUE(unit_vectors_to_angles(angles_to_unit_vectors(wrapped)).isApprox(expected, 1e-12));
+}
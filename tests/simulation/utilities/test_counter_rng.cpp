@@ -0,0 +1,54 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-28
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <set>
+
+#include <utilities/counter_rng.h>
+
+
+TEST(CounterRNGTest, MatchesThePhiloxKnownAnswers) {
+    // Known answer vectors of the Random123 library
+    std::array<uint32_t, 4> zero = CounterRNG::philox4x32({0, 0, 0, 0}, {0, 0});
+    EXPECT_EQ(zero, (std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+
+    std::array<uint32_t, 4> ones = CounterRNG::philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff});
+    EXPECT_EQ(ones, (std::array<uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+}
+
+TEST(CounterRNGTest, SameCounterGivesTheSameNumbers) {
+    CounterRNG rng(42);
+    EXPECT_EQ(rng.uniform(RandomStream::AngularNoise, 7, 3), CounterRNG(42).uniform(RandomStream::AngularNoise, 7, 3));
+}
+
+TEST(CounterRNGTest, EveryCounterPartChangesTheNumbers) {
+    CounterRNG rng(42);
+    std::set<std::array<double, 2>> draws {
+        rng.uniform(RandomStream::AngularNoise, 7, 3),
+        rng.uniform(RandomStream::AngularNoise, 7, 4),
+        rng.uniform(RandomStream::AngularNoise, 8, 3),
+        rng.uniform(RandomStream::InitialParticles, 7, 3),
+        CounterRNG(43).uniform(RandomStream::AngularNoise, 7, 3)
+    };
+    EXPECT_EQ(draws.size(), 5);
+}
+
+TEST(CounterRNGTest, UniformNumbersAreInTheUnitInterval) {
+    CounterRNG rng(1);
+    double sum = 0;
+    const int num_draws = 20000;
+
+    for (int id = 0; id < num_draws; ++id) {
+        for (double u : rng.uniform(RandomStream::AngularNoise, 0, id)) {
+            ASSERT_GE(u, 0.0);
+            ASSERT_LT(u, 1.0);
+            sum += u;
+        }
+    }
+
+    EXPECT_NEAR(sum / (2 * num_draws), 0.5, 0.01);
+}
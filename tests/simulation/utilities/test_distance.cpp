@@ -0,0 +1,53 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-24
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <Eigen/Dense>
+
+#include <io/binary_matrix.h>
+#include <utilities/distance.h>
+#include <utilities/heat_method.h>
+
+const boost::filesystem::path PROJECT_PATH = PROJECT_SOURCE_DIR;
+
+
+/**
+ * @brief The CGAL heat method on the intrinsic Delaunay triangulation against the batched heat method on the mesh itself
+ *
+ * The sphere mesh is Delaunay, there both only differ by their solvers. The ellipsoid has a few non-Delaunay edges.
+*/
+TEST(DistanceRowsTest, BatchedDistancesStayCloseToTheCGALHeatMethod) {
+    for (auto [mesh_name, max_relative_difference] : {std::pair<std::string, double>{"sphere", 0.02}, {"ellipsoid_x4", 0.05}}) {
+        std::string mesh_path = PROJECT_PATH.string() + "/meshes/" + mesh_name + ".off";
+        std::vector<int> source_ids(64);
+        std::iota(source_ids.begin(), source_ids.end(), 0);
+
+        RowMajorMatrixXd cgal = get_distance_rows(mesh_path, source_ids, HeatMethodVariant::IntrinsicDelaunay);
+        RowMajorMatrixXd batched = get_distance_rows(mesh_path, source_ids, HeatMethodVariant::Batched);
+
+        ASSERT_EQ(batched.rows(), cgal.rows());
+        ASSERT_EQ(batched.cols(), cgal.cols());
+        EXPECT_LT((batched - cgal).norm() / cgal.norm(), max_relative_difference) << mesh_name;
+        EXPECT_LT((batched - cgal).cwiseAbs().maxCoeff(), 2 * max_relative_difference * cgal.maxCoeff()) << mesh_name;
+    }
+}
+
+TEST(DistanceRowsTest, BlockSizeDoesNotChangeTheBatchedDistances) {
+    std::string mesh_path = PROJECT_PATH.string() + "/meshes/sphere.off";
+    std::vector<int> source_ids(40);
+    std::iota(source_ids.begin(), source_ids.end(), 0);
+
+    RowMajorMatrixXd single = get_distance_rows(mesh_path, source_ids, HeatMethodVariant::Batched, 1);
+    RowMajorMatrixXd blocks = get_distance_rows(mesh_path, source_ids, HeatMethodVariant::Batched, 16);
+
+    EXPECT_LT((blocks - single).cwiseAbs().maxCoeff(), 1e-10);
+    EXPECT_THROW(get_distance_rows(mesh_path, source_ids, HeatMethodVariant::Batched, 0), std::invalid_argument);
+}
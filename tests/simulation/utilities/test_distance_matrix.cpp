@@ -0,0 +1,201 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-21
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <particle_simulation/cell_list.h>
+#include <particle_simulation/pair_interactions.h>
+#include <utilities/angles_to_unit_vectors.h>
+#include <utilities/distance_matrix.h>
+
+
+/**
+ * @brief Compare the force and the alignment of reduced precision distance matrices against the double baseline
+ *
+ * The vertices lie on a sphere, so the great circle distance acts as geodesic distance
+*/
+class DistancePrecisionTest : public ::testing::Test {
+protected:
+    const double k = 10;
+    const double σ = 0.4166666666666667;
+    const double r_adh = 1;
+    const double k_adh = 0.75;
+    const double radius = 3;
+    const int num_vertices = 400;
+    const int num_part = 80;
+
+    Eigen::MatrixXd distances;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r;
+    Eigen::VectorXd n;
+    std::vector<int> vertices_active;
+
+    void SetUp() override {
+        std::mt19937 gen(42);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::uniform_int_distribution<int> vertex(0, num_vertices - 1);
+
+        Eigen::MatrixXd points(num_vertices, 3);
+        for (int i = 0; i < num_vertices; ++i) {
+            Eigen::Vector3d point(normal(gen), normal(gen), normal(gen));
+            points.row(i) = point.normalized();
+        }
+
+        distances.resize(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                double cos_angle = std::clamp(points.row(i).dot(points.row(j)), -1.0, 1.0);
+                distances(i, j) = i == j ? 0 : radius * std::acos(cos_angle);
+            }
+        }
+
+        r.resize(num_part, 2);
+        n.resize(num_part);
+        for (int i = 0; i < num_part; ++i) {
+            r.row(i) << uniform(gen), uniform(gen);
+            n(i) = 360 * uniform(gen);
+            vertices_active.push_back(vertex(gen));
+        }
+    }
+
+    /**
+     * @brief Largest absolute error of a stored distance: half a uint16 step, or the float32 rounding of the largest kept value
+    */
+    double storage_error(MatrixDtype dtype, double cutoff) const {
+        double max_kept = 0;
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                if (distances(i, j) <= cutoff) max_kept = std::max(max_kept, distances(i, j));
+            }
+        }
+
+        switch (dtype) {
+            case MatrixDtype::UInt16: return 0.5 * max_kept / std::numeric_limits<uint16_t>::max();
+            case MatrixDtype::Float32: return max_kept * std::numeric_limits<float>::epsilon();
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Particles with a pair distance so close to a threshold that the stored precision may flip the comparison
+     *
+     * The alignment and the force act below 2σ, the neighbor count up to 2.4σ and only for nonzero distances.
+    */
+    std::vector<bool> near_threshold(const Eigen::MatrixXd& dist_length, double error) const {
+        std::vector<bool> ambiguous(num_part, false);
+        for (int i = 0; i < num_part; ++i) {
+            for (int j = 0; j < num_part; ++j) {
+                for (double threshold : {0.0, 2 * σ, 2.4 * σ}) {
+                    if (i != j && std::abs(dist_length(i, j) - threshold) <= error && dist_length(i, j) != 0) {
+                        ambiguous[i] = ambiguous[j] = true;
+                    }
+                }
+            }
+        }
+        return ambiguous;
+    }
+
+    /**
+     * @brief Compare the particles, whose neighborhoods do not depend on the stored precision, against the double baseline
+     *
+     * The repulsion k (2σ - d) / (2σ) · Δr / d changes by at most k |Δr| / (d - ε)² · ε, if the distance d is off by ε.
+     * With the same neighbors the alignment sums the same unit vectors, so only rounding remains.
+    */
+    void compare_against_double(MatrixDtype dtype, double cutoff = std::numeric_limits<double>::infinity()) {
+        DistanceMatrix baseline(distances);
+        DistanceMatrix reduced(distances, dtype, cutoff);
+
+        // All pairs are candidates, so every interaction within the ranges gets evaluated
+        std::vector<ParticlePair> pairs = all_particle_pairs(num_part);
+        Eigen::MatrixXd dist_length = baseline.distances_between(vertices_active);
+
+        const double error = storage_error(dtype, cutoff);
+        std::vector<bool> ambiguous = near_threshold(dist_length, error);
+        ASSERT_GT(std::count(ambiguous.begin(), ambiguous.end(), false), num_part / 2);
+
+        Eigen::Matrix<double, Eigen::Dynamic, 2> n_vec = angles_to_unit_vectors(n);
+        PairInteractions interactions = calculate_pair_interactions(r, n_vec, pairs, baseline.distances_of_pairs(vertices_active, pairs), k, σ, r_adh, k_adh);
+        PairInteractions interactions_reduced = calculate_pair_interactions(r, n_vec, pairs, reduced.distances_of_pairs(vertices_active, pairs), k, σ, r_adh, k_adh);
+
+        const auto& F = interactions.force;
+        const auto& F_reduced = interactions_reduced.force;
+
+        // Make sure that the particles actually interact with each other
+        ASSERT_GT(F.norm(), 0);
+
+        Eigen::Matrix<double, Eigen::Dynamic, 2> n_baseline;
+        Eigen::Matrix<double, Eigen::Dynamic, 2> n_reduced;
+        normalize_unit_vector_sums(interactions.n_sum, n_baseline);
+        normalize_unit_vector_sums(interactions_reduced.n_sum, n_reduced);
+
+        const auto& neighbors = interactions.neighbor_count;
+        const auto& neighbors_reduced = interactions_reduced.neighbor_count;
+
+        for (int i = 0; i < num_part; ++i) {
+            if (ambiguous[i]) continue;
+
+            double force_bound = 1e-12;
+            for (int j = 0; j < num_part; ++j) {
+                const double dist = dist_length(i, j);
+                if (j != i && dist != 0 && dist < 2 * σ) {
+                    force_bound += k * (r.row(i) - r.row(j)).norm() * error / std::pow(dist - error, 2);
+                }
+            }
+            EXPECT_LE((F.row(i) - F_reduced.row(i)).norm(), force_bound);
+
+            // Compare the orientations on the unit circle, the difference of unit vectors is the angle for small angles
+            EXPECT_LT((n_baseline.row(i) - n_reduced.row(i)).norm(), 1e-12);
+
+            EXPECT_EQ(neighbors(i), neighbors_reduced(i));
+        }
+    }
+};
+
+TEST_F(DistancePrecisionTest, Float32) {
+    compare_against_double(MatrixDtype::Float32);
+}
+
+TEST_F(DistancePrecisionTest, UInt16) {
+    compare_against_double(MatrixDtype::UInt16);
+}
+
+TEST_F(DistancePrecisionTest, SparseCutoff) {
+    const double cutoff = std::max(2.4 * σ, r_adh);
+    compare_against_double(MatrixDtype::Float64, cutoff);
+
+    // Only a small part of the vertex pairs is within the cutoff
+    DistanceMatrix sparse(distances, MatrixDtype::Float64, cutoff);
+    EXPECT_EQ(sparse.layout(), MatrixLayout::SparseCSR);
+    EXPECT_LT(sparse.nonzeros(), packed_upper_size(num_vertices) / 4);
+    EXPECT_TRUE(std::isinf(sparse(0, 1)) || sparse(0, 1) <= cutoff);
+}
+
+TEST_F(DistancePrecisionTest, SparseCutoffUInt16) {
+    compare_against_double(MatrixDtype::UInt16, std::max(2.4 * σ, r_adh));
+}
+
+TEST(DistanceMatrixPrecisionTest, QuantizationErrorIsBoundedByHalfAStep) {
+    Eigen::MatrixXd matrix(3, 3);
+    matrix << 0, 0.123456789, 7.5,
+              0.123456789, 0, 10,
+              7.5, 10, 0;
+
+    DistanceMatrix reduced(matrix, MatrixDtype::UInt16);
+    double step = 10.0 / 65535;
+
+    for (int i = 0; i < matrix.rows(); ++i) {
+        for (int j = 0; j < matrix.cols(); ++j) {
+            EXPECT_NEAR(reduced(i, j), matrix(i, j), 0.5 * step + 1e-12);
+        }
+    }
+    EXPECT_EQ(reduced(0, 0), 0);
+}
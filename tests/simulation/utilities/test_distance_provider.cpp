@@ -0,0 +1,261 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-22
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <Eigen/Dense>
+
+#include <utilities/distance_matrix.h>
+#include <utilities/distance_provider.h>
+
+namespace fs = boost::filesystem;
+
+
+/**
+ * @brief The row solver reads the rows of a known, slightly asymmetric matrix and counts its calls
+*/
+class LazyDistanceRowsTest : public ::testing::Test {
+protected:
+    const int num_vertices = 6;
+    Eigen::MatrixXd matrix;
+    std::vector<int> solved_rows;
+    std::mutex solved_mutex;
+
+    void SetUp() override {
+        matrix.resize(num_vertices, num_vertices);
+        for (int i = 0; i < num_vertices; ++i) {
+            for (int j = 0; j < num_vertices; ++j) {
+                matrix(i, j) = std::abs(i - j) + (i > j ? 0.25 : 0.0);
+            }
+        }
+    }
+
+    DistanceRowSolver solver() {
+        return [this](int source_id) {
+            std::lock_guard<std::mutex> lock(solved_mutex);
+            solved_rows.push_back(source_id);
+            return row_of(source_id);
+        };
+    }
+
+    std::vector<double> row_of(int source_id) const {
+        std::vector<double> distances(num_vertices);
+        for (int j = 0; j < num_vertices; ++j) {
+            distances[j] = matrix(source_id, j);
+        }
+        return distances;
+    }
+};
+
+TEST_F(LazyDistanceRowsTest, MatchesThePrecomputedMatrix) {
+    LazyDistanceRows lazy_rows(num_vertices, solver(), 1 << 20);
+    DistanceMatrix distance_matrix(matrix);
+
+    std::vector<int> vertices_active {4, 1, 1, 3};
+
+    Eigen::MatrixXd lazy = lazy_rows.distances_between(vertices_active);
+    Eigen::MatrixXd precomputed = distance_matrix.distances_between(vertices_active);
+
+    EXPECT_TRUE(lazy.isApprox(precomputed));
+    EXPECT_EQ(lazy, lazy.transpose());
+}
+
+TEST_F(LazyDistanceRowsTest, PairDistancesMatchTheDenseBlock) {
+    LazyDistanceRows lazy_rows(num_vertices, solver(), 1 << 20);
+    DistanceMatrix distance_matrix(matrix);
+
+    std::vector<int> vertices_active {4, 1, 1, 3};
+    std::vector<ParticlePair> pairs {{0, 1}, {1, 2}, {0, 3}, {2, 3}};
+    Eigen::MatrixXd dense = lazy_rows.distances_between(vertices_active);
+
+    std::vector<double> lazy = lazy_rows.distances_of_pairs(vertices_active, pairs);
+    std::vector<double> precomputed = distance_matrix.distances_of_pairs(vertices_active, pairs);
+
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        EXPECT_DOUBLE_EQ(lazy[p], dense(pairs[p].first, pairs[p].second));
+        EXPECT_DOUBLE_EQ(precomputed[p], dense(pairs[p].first, pairs[p].second));
+    }
+}
+
+TEST_F(LazyDistanceRowsTest, ComputesEachActiveRowOnce) {
+    LazyDistanceRows lazy_rows(num_vertices, solver(), 1 << 20);
+
+    lazy_rows.distances_between({0, 2, 2});
+    lazy_rows.distances_between({2, 0});
+
+    // The distinct rows of a lookup get solved in parallel, in any order
+    std::sort(solved_rows.begin(), solved_rows.end());
+    std::vector<int> expected {0, 2};
+    EXPECT_EQ(solved_rows, expected);
+    EXPECT_EQ(lazy_rows.computed_rows(), 2);
+}
+
+TEST_F(LazyDistanceRowsTest, EvictsLeastRecentlyUsedRowsAboveTheBudget) {
+    LazyDistanceRows lazy_rows(num_vertices, solver(), 2 * num_vertices * sizeof(double));
+
+    // The lookup still works if it needs more rows than the budget allows
+    Eigen::MatrixXd distances = lazy_rows.distances_between({0, 1, 2});
+    EXPECT_DOUBLE_EQ(distances(0, 2), 2);
+    EXPECT_EQ(lazy_rows.cached_rows(), 2);
+    EXPECT_LE(lazy_rows.cached_bytes(), 2 * num_vertices * sizeof(double));
+
+    // Row 0 is the least recently used one and gets evicted
+    lazy_rows.row(0);
+    lazy_rows.row(1);
+    lazy_rows.row(2);
+    solved_rows.clear();
+    lazy_rows.row(2);
+    lazy_rows.row(0);
+    std::vector<int> expected {0};
+    EXPECT_EQ(solved_rows, expected);
+}
+
+TEST_F(LazyDistanceRowsTest, SolvesDifferentRowsConcurrentlyAndEachRowOnce) {
+    std::atomic<int> running {0};
+    std::atomic<int> max_running {0};
+    std::atomic<int> num_solves {0};
+
+    DistanceRowSolver slow_solver = [&](int source_id) {
+        int now_running = ++running;
+        int previous_max = max_running;
+        while (previous_max < now_running && !max_running.compare_exchange_weak(previous_max, now_running)) {}
+        ++num_solves;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+        return row_of(source_id);
+    };
+    LazyDistanceRows lazy_rows(num_vertices, slow_solver, 1 << 20);
+
+    // Threads asking for the same row wait for the one solving it
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() { lazy_rows.row(3); });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(num_solves, 1);
+
+    // Different rows get solved at the same time
+    threads.clear();
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() { lazy_rows.row(t == 3 ? 5 : t); });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(num_solves, 5);
+    EXPECT_GT(max_running, 1);
+    EXPECT_EQ(lazy_rows.computed_rows(), 5);
+}
+
+TEST_F(LazyDistanceRowsTest, ReloadsSpilledRows) {
+    std::string spill_directory = (fs::temp_directory_path() / fs::unique_path("distance_rows_%%%%-%%%%")).string();
+    LazyDistanceRows lazy_rows(num_vertices, solver(), num_vertices * sizeof(double), spill_directory);
+
+    lazy_rows.row(0);
+    lazy_rows.row(1);
+    EXPECT_EQ(lazy_rows.spilled_rows(), 1);
+
+    solved_rows.clear();
+    Eigen::VectorXd distances = lazy_rows.row(0);
+
+    EXPECT_TRUE(solved_rows.empty());
+    EXPECT_DOUBLE_EQ(distances(5), matrix(0, 5));
+
+    fs::remove_all(spill_directory);
+}
+
+TEST_F(LazyDistanceRowsTest, KeepsTheSpilledRowsOfAnotherKeyApart) {
+    std::string spill_directory = (fs::temp_directory_path() / fs::unique_path("distance_rows_%%%%-%%%%")).string();
+    auto other_solver = [this](int source_id) {
+        std::vector<double> distances = row_of(source_id);
+        for (double& distance : distances) distance += 100;
+        return distances;
+    };
+    {
+        LazyDistanceRows other_mesh_rows(num_vertices, other_solver, num_vertices * sizeof(double), spill_directory, 1);
+        other_mesh_rows.row(0);
+        other_mesh_rows.row(1);
+        ASSERT_EQ(other_mesh_rows.spilled_rows(), 1);
+    }
+
+    // Another key neither reads nor replaces the spilled row of the first one
+    {
+        LazyDistanceRows lazy_rows(num_vertices, solver(), num_vertices * sizeof(double), spill_directory, 2);
+        EXPECT_DOUBLE_EQ(lazy_rows.row(0)(5), matrix(0, 5));
+        lazy_rows.row(1);
+        EXPECT_EQ(lazy_rows.spilled_rows(), 1);
+        solved_rows.clear();
+        EXPECT_DOUBLE_EQ(lazy_rows.row(0)(5), matrix(0, 5));
+        EXPECT_TRUE(solved_rows.empty());
+    }
+
+    int other_solves = 0;
+    LazyDistanceRows other_mesh_rows(num_vertices, [&](int source_id) {
+        ++other_solves;
+        return other_solver(source_id);
+    }, num_vertices * sizeof(double), spill_directory, 1);
+    EXPECT_DOUBLE_EQ(other_mesh_rows.row(0)(5), matrix(0, 5) + 100);
+    EXPECT_EQ(other_solves, 0);
+
+    fs::remove_all(spill_directory);
+}
+
+TEST_F(LazyDistanceRowsTest, ReplacesASpillFileWithAForeignHeader) {
+    std::string spill_directory = (fs::temp_directory_path() / fs::unique_path("distance_rows_%%%%-%%%%")).string();
+    {
+        LazyDistanceRows other_size_rows(num_vertices + 1, [this](int source_id) {
+            std::vector<double> distances = row_of(source_id % 6);
+            distances.push_back(100);
+            return distances;
+        }, (num_vertices + 1) * sizeof(double), spill_directory, 3);
+        other_size_rows.row(0);
+        other_size_rows.row(1);
+        ASSERT_EQ(other_size_rows.spilled_rows(), 1);
+    }
+
+    // Same key and file name, but another vertex count: the row gets recomputed and its spill file replaced
+    LazyDistanceRows lazy_rows(num_vertices, solver(), num_vertices * sizeof(double), spill_directory, 3);
+    EXPECT_DOUBLE_EQ(lazy_rows.row(0)(5), matrix(0, 5));
+    EXPECT_EQ(solved_rows, std::vector<int>({0}));
+
+    lazy_rows.row(1);
+    EXPECT_EQ(lazy_rows.spilled_rows(), 1);
+    solved_rows.clear();
+    EXPECT_DOUBLE_EQ(lazy_rows.row(0)(5), matrix(0, 5));
+    EXPECT_TRUE(solved_rows.empty());
+
+    fs::remove_all(spill_directory);
+}
+
+TEST_F(LazyDistanceRowsTest, StaysConsistentWhenTheSpillFails) {
+    std::string spill_directory = (fs::temp_directory_path() / fs::unique_path("distance_rows_%%%%-%%%%")).string();
+    LazyDistanceRows lazy_rows(num_vertices, solver(), num_vertices * sizeof(double), spill_directory);
+
+    // A directory in place of the spill file of row 0 with the spill key 0 makes its spill fail
+    fs::create_directories(fs::path(spill_directory) / "distance_row_0000000000000000_0.bin");
+
+    lazy_rows.row(0);
+    EXPECT_ANY_THROW(lazy_rows.row(1));
+    EXPECT_EQ(lazy_rows.cached_rows(), 1);
+
+    // The row got cached before the spill failed, the evicted row gets recomputed and the cache keeps working
+    solved_rows.clear();
+    EXPECT_DOUBLE_EQ(lazy_rows.row(1)(3), matrix(1, 3));
+    EXPECT_DOUBLE_EQ(lazy_rows.row(0)(4), matrix(0, 4));
+    EXPECT_EQ(solved_rows, std::vector<int>({0}));
+
+    EXPECT_ANY_THROW(lazy_rows.row(2));
+    EXPECT_EQ(lazy_rows.cached_rows(), 1);
+    EXPECT_DOUBLE_EQ(lazy_rows.row(2)(4), matrix(2, 4));
+    EXPECT_EQ(solved_rows, std::vector<int>({0, 2}));
+
+    fs::remove_all(spill_directory);
+}
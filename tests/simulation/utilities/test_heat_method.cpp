@@ -0,0 +1,178 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-24
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/heat_method.h>
+
+
+/**
+ * @brief Unit icosphere, the great circle distance is the exact geodesic distance
+*/
+class HeatMethodTest : public ::testing::Test {
+protected:
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi faces;
+
+    void SetUp() override {
+        const double phi = (1.0 + std::sqrt(5.0)) / 2.0;
+        std::vector<Eigen::Vector3d> points {
+            {-1, phi, 0}, {1, phi, 0}, {-1, -phi, 0}, {1, -phi, 0},
+            {0, -1, phi}, {0, 1, phi}, {0, -1, -phi}, {0, 1, -phi},
+            {phi, 0, -1}, {phi, 0, 1}, {-phi, 0, -1}, {-phi, 0, 1}
+        };
+        std::vector<Eigen::Vector3i> triangles {
+            {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+            {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+            {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+            {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+        };
+        for (auto& point : points) point.normalize();
+
+        // Split every triangle into four, the new vertices get projected onto the sphere
+        for (int level = 0; level < 4; ++level) {
+            std::map<std::pair<int, int>, int> midpoints;
+            auto midpoint = [&](int a, int b) {
+                auto key = std::minmax(a, b);
+                auto it = midpoints.find(key);
+                if (it != midpoints.end()) return it->second;
+                points.push_back((points[a] + points[b]).normalized());
+                return midpoints[key] = points.size() - 1;
+            };
+
+            std::vector<Eigen::Vector3i> refined;
+            for (const auto& t : triangles) {
+                int ab = midpoint(t[0], t[1]), bc = midpoint(t[1], t[2]), ca = midpoint(t[2], t[0]);
+                refined.push_back({t[0], ab, ca});
+                refined.push_back({t[1], bc, ab});
+                refined.push_back({t[2], ca, bc});
+                refined.push_back({ab, bc, ca});
+            }
+            triangles = refined;
+        }
+
+        vertices.resize(points.size(), 3);
+        for (size_t i = 0; i < points.size(); ++i) vertices.row(i) = points[i];
+        faces.resize(triangles.size(), 3);
+        for (size_t i = 0; i < triangles.size(); ++i) faces.row(i) = triangles[i];
+    }
+};
+
+TEST_F(HeatMethodTest, ApproximatesGreatCircleDistances) {
+    HeatMethodSolver solver(vertices, faces);
+    Eigen::MatrixXd distances = solver.distances({7});
+
+    ASSERT_EQ(distances.rows(), vertices.rows());
+    EXPECT_DOUBLE_EQ(distances(7, 0), 0);
+
+    double max_error = 0;
+    for (int i = 0; i < vertices.rows(); ++i) {
+        double exact = std::acos(std::clamp(vertices.row(i).dot(vertices.row(7)), -1.0, 1.0));
+        max_error = std::max(max_error, std::abs(distances(i, 0) - exact));
+    }
+
+    // Less than 3 % of the largest distance π
+    EXPECT_LT(max_error, 0.03 * M_PI);
+}
+
+TEST_F(HeatMethodTest, BlockSolveMatchesSingleSources) {
+    HeatMethodSolver solver(vertices, faces);
+    std::vector<int> source_ids {0, 13, 200, 1500, 2561};
+
+    Eigen::MatrixXd block = solver.distances(source_ids);
+
+    for (size_t k = 0; k < source_ids.size(); ++k) {
+        Eigen::MatrixXd single = solver.distances({source_ids[k]});
+        EXPECT_LT((block.col(k) - single.col(0)).cwiseAbs().maxCoeff(), 1e-10);
+    }
+}
+
+TEST_F(HeatMethodTest, TruncatedSolveMatchesTheWholeMeshWithinTheCutoff) {
+    const double cutoff = 0.4;
+    HeatMethodSolver solver(vertices, faces);
+    TruncatedHeatMethodSolver truncated(vertices, faces, cutoff);
+    std::vector<int> source_ids {0, 13, 200, 1500, 2561};
+
+    Eigen::MatrixXd whole_mesh = solver.distances(source_ids);
+    Eigen::MatrixXd block = truncated.distances(source_ids);
+
+    for (size_t k = 0; k < source_ids.size(); ++k) {
+        // Each source only solves on a small part of the sphere
+        EXPECT_LT(truncated.patch_vertices(source_ids[k]).size(), vertices.rows() / 4);
+        EXPECT_EQ(truncated.patch_vertices(source_ids[k]).front(), source_ids[k]);
+
+        for (int i = 0; i < vertices.rows(); ++i) {
+            if (std::isinf(block(i, k))) {
+                EXPECT_GT(whole_mesh(i, k), cutoff - 0.01);
+            }
+            else {
+                EXPECT_LE(block(i, k), cutoff);
+                EXPECT_NEAR(block(i, k), whole_mesh(i, k), 0.01);
+            }
+        }
+    }
+}
+
+TEST_F(HeatMethodTest, TruncatedSolveErrorStaysSmallRelativeToTheCutoff) {
+    HeatMethodSolver solver(vertices, faces);
+
+    // A block of consecutive vertices, which holds both grouped and lonely sources.
+    // The smallest cutoff is less than three edge lengths, there the patch border costs up to 4 % of the cutoff
+    std::vector<int> source_ids;
+    for (int v = 600; v < 664; ++v) source_ids.push_back(v);
+    Eigen::MatrixXd whole_mesh = solver.distances(source_ids);
+
+    for (double cutoff : {0.2, 0.4, 0.8}) {
+        TruncatedHeatMethodSolver truncated(vertices, faces, cutoff);
+        Eigen::MatrixXd block = truncated.distances(source_ids);
+        EXPECT_LT(truncated.group_solves(), static_cast<int64_t>(source_ids.size())) << "cutoff " << cutoff;
+
+        // Beyond the cutoff both count as the cutoff, so a distance that crosses the cutoff counts with its error
+        auto clamped = [cutoff](double distance) { return std::min(distance, cutoff); };
+        double max_error = 0;
+        for (size_t k = 0; k < source_ids.size(); ++k) {
+            Eigen::MatrixXd single = truncated.distances({source_ids[k]});
+            for (int i = 0; i < vertices.rows(); ++i) {
+                max_error = std::max(max_error, std::abs(clamped(block(i, k)) - clamped(whole_mesh(i, k))));
+                max_error = std::max(max_error, std::abs(clamped(single(i, 0)) - clamped(whole_mesh(i, k))));
+            }
+        }
+        EXPECT_LT(max_error, 0.05 * cutoff) << "cutoff " << cutoff;
+    }
+}
+
+TEST_F(HeatMethodTest, TruncatedSolveFallsBackToTheWholeMesh) {
+    HeatMethodSolver solver(vertices, faces);
+    TruncatedHeatMethodSolver truncated(vertices, faces, 2.5);
+
+    Eigen::MatrixXd whole_mesh = solver.distances({42});
+    Eigen::MatrixXd block = truncated.distances({42});
+
+    for (int i = 0; i < vertices.rows(); ++i) {
+        if (whole_mesh(i, 0) <= 2.5) EXPECT_DOUBLE_EQ(block(i, 0), whole_mesh(i, 0));
+        else EXPECT_TRUE(std::isinf(block(i, 0)));
+    }
+}
+
+TEST_F(HeatMethodTest, RejectsUnknownSource) {
+    HeatMethodSolver solver(vertices, faces);
+
+    EXPECT_THROW(solver.distances({static_cast<int>(vertices.rows())}), std::out_of_range);
+    EXPECT_THROW(TruncatedHeatMethodSolver(vertices, faces, 0.5).distances({-1}), std::out_of_range);
+}
+
+TEST(HeatMethodVariantTest, ParsesItsNames) {
+    for (HeatMethodVariant variant : {HeatMethodVariant::IntrinsicDelaunay, HeatMethodVariant::Batched}) {
+        EXPECT_EQ(parse_heat_method(heat_method_name(variant)), variant);
+    }
+    EXPECT_THROW(parse_heat_method("cgal"), std::invalid_argument);
+}
@@ -0,0 +1,168 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-28
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/barycentric_coord.h>
+#include <utilities/uv_affine_maps.h>
+
+
+/**
+ * @brief Two UV triangles of the unit square, lifted onto a bent sheet in 3D
+*/
+class UVAffineMapsTest : public ::testing::Test {
+protected:
+    Eigen::MatrixXd vertices_uv;
+    Eigen::MatrixXi faces;
+    Eigen::MatrixXd vertices_3D;
+    std::mt19937 gen{9};
+
+    void SetUp() override {
+        vertices_uv.resize(4, 3);
+        vertices_uv << 0, 0, 0,
+                       1, 0, 0,
+                       1, 1, 0,
+                       0, 1, 0;
+        faces.resize(2, 3);
+        faces << 0, 1, 2,
+                 0, 2, 3;
+        vertices_3D.resize(4, 3);
+        vertices_3D << 1, 2, 3,
+                       3, 2, 4,
+                       3, 5, 6,
+                       1, 4, 2;
+    }
+
+    Eigen::Vector2d random_point_on(int face) {
+        std::uniform_real_distribution<double> uniform(0, 1);
+        double s = uniform(gen);
+        double t = uniform(gen);
+        if (s + t > 1) {
+            s = 1 - s;
+            t = 1 - t;
+        }
+        Eigen::Vector2d a = vertices_uv.row(faces(face, 0)).head<2>();
+        Eigen::Vector2d b = vertices_uv.row(faces(face, 1)).head<2>();
+        Eigen::Vector2d c = vertices_uv.row(faces(face, 2)).head<2>();
+        return a + s * (b - a) + t * (c - a);
+    }
+};
+
+TEST_F(UVAffineMapsTest, LiftsTheCornersOntoTheirVertices) {
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+
+    for (int f = 0; f < 2; ++f) {
+        for (int c = 0; c < 3; ++c) {
+            Eigen::Vector2d corner = vertices_uv.row(faces(f, c)).head<2>();
+            Eigen::Vector3d expected = vertices_3D.row(faces(f, c));
+            EXPECT_TRUE(maps.lift(corner, f).isApprox(expected)) << "face " << f << ", corner " << c;
+            EXPECT_EQ(maps.nearest_corner(corner, f), c);
+        }
+    }
+}
+
+TEST_F(UVAffineMapsTest, InterpolatesWithTheBarycentricCoordinates) {
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+
+    for (int i = 0; i < 100; ++i) {
+        const int f = i % 2;
+        Eigen::Vector2d point = random_point_on(f);
+        Eigen::Vector3d lambda = maps.barycentric(point, f);
+
+        EXPECT_NEAR(lambda.sum(), 1, 1e-12);
+        EXPECT_GE(lambda.minCoeff(), -1e-12);
+
+        Eigen::Vector3d expected = Eigen::Vector3d::Zero();
+        Eigen::Vector2d uv = Eigen::Vector2d::Zero();
+        for (int c = 0; c < 3; ++c) {
+            expected += lambda(c) * vertices_3D.row(faces(f, c)).transpose();
+            uv += lambda(c) * vertices_uv.row(faces(f, c)).head<2>().transpose();
+        }
+        EXPECT_TRUE(uv.isApprox(point));
+        EXPECT_TRUE(maps.lift(point, f).isApprox(expected));
+    }
+}
+
+TEST_F(UVAffineMapsTest, LiftsAllParticlesAtOnce) {
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(50, 2);
+    std::vector<int> particle_faces(50);
+    for (int i = 0; i < 50; ++i) {
+        particle_faces[i] = (i * 7) % 2;
+        r.row(i) = random_point_on(particle_faces[i]).transpose();
+    }
+
+    Eigen::MatrixXd r_3D = maps.lift(r, particle_faces);
+
+    ASSERT_EQ(r_3D.rows(), 50);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(r_3D.row(i).transpose().isApprox(maps.lift(r.row(i).transpose(), particle_faces[i])));
+    }
+}
+
+TEST_F(UVAffineMapsTest, ScalesTheVelocitiesBetweenUVAnd3D) {
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+
+    // Moving along a UV edge moves along the 3D edge
+    Eigen::Vector2d edge_uv = (vertices_uv.row(1) - vertices_uv.row(0)).head<2>();
+    Eigen::Vector3d edge_3D = vertices_3D.row(1) - vertices_3D.row(0);
+    EXPECT_TRUE(maps.lift_velocity(edge_uv, 0).isApprox(edge_3D));
+
+    // The tangential 3D velocities map back onto the UV velocities
+    std::normal_distribution<double> normal(0, 1);
+    for (int i = 0; i < 20; ++i) {
+        Eigen::Vector2d velocity(normal(gen), normal(gen));
+        EXPECT_TRUE(maps.uv_velocity(maps.lift_velocity(velocity, 1), 1).isApprox(velocity));
+    }
+
+    // The normal of the face has no UV velocity
+    Eigen::Vector3d edge_b = vertices_3D.row(1) - vertices_3D.row(0);
+    Eigen::Vector3d edge_c = vertices_3D.row(2) - vertices_3D.row(0);
+    Eigen::Vector3d normal_3D = edge_b.cross(edge_c);
+    EXPECT_LT(maps.uv_velocity(normal_3D, 0).norm(), 1e-12);
+}
+
+TEST_F(UVAffineMapsTest, CollapsedFacesStayFinite) {
+    vertices_uv.row(2) = vertices_uv.row(1);
+    vertices_3D.row(2) = vertices_3D.row(1);
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+
+    EXPECT_TRUE(maps.lift(Eigen::Vector2d(0.5, 0.5), 0).allFinite());
+    EXPECT_TRUE(maps.uv_velocity(Eigen::Vector3d(1, 1, 1), 0).allFinite());
+}
+
+TEST_F(UVAffineMapsTest, RejectsMismatchedVertexRows) {
+    EXPECT_THROW(UVAffineMaps(vertices_uv, faces, vertices_3D.topRows(3)), std::invalid_argument);
+}
+
+TEST(NearestCornerTest, IsTheCornerClosestToTheLiftedPoint) {
+    Eigen::MatrixXd vertices_uv(3, 3);
+    vertices_uv << 0, 0, 0,
+                   4, 0, 0,
+                   0, 1, 0;
+    Eigen::MatrixXi faces(1, 3);
+    faces << 0, 1, 2;
+    Eigen::MatrixXd vertices_3D = vertices_uv;
+    std::vector<int64_t> h_v_mapping {10, 11, 12};
+
+    // The point is closest to corner a in 3D, even though corner c has the largest barycentric coordinate
+    Eigen::Matrix<double, Eigen::Dynamic, 2> r(1, 2);
+    r << 1.5, 0.45;
+
+    UVAffineMaps maps(vertices_uv, faces, vertices_3D);
+    EXPECT_TRUE(maps.barycentric(r.row(0).transpose(), 0).isApprox(Eigen::Vector3d(0.175, 0.375, 0.45)));
+    EXPECT_EQ(maps.nearest_corner(r.row(0).transpose(), 0), 0);
+
+    // The scan over the faces picks the same vertex
+    auto [r_3D, vertex_id] = calculate_barycentric_3D_coord(r, vertices_uv, faces, vertices_uv, vertices_3D, h_v_mapping, 0);
+    EXPECT_TRUE(r_3D.isApprox(Eigen::Vector3d(1.5, 0.45, 0)));
+    EXPECT_EQ(vertex_id, 10);
+}
@@ -0,0 +1,113 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/barycentric_coord.h>
+#include <utilities/uv_face_grid.h>
+
+#include "jittered_uv_square.h"
+
+
+/**
+ * @brief Jittered triangulation of the UV square, whose vertex table is a shuffled copy of the UV mesh vertices
+*/
+class UVFaceGridTest : public ::testing::Test {
+protected:
+    const int n = 12;
+    Eigen::MatrixXd halfedges_uv;
+    Eigen::MatrixXi faces_uv;
+    Eigen::MatrixXd vertices_uv;
+    Eigen::MatrixXi face_vertex_rows;
+    std::mt19937 gen{5};
+
+    void SetUp() override {
+        const int num_vertices = (n + 1) * (n + 1);
+        jittered_uv_square(n, gen, halfedges_uv, faces_uv);
+
+        std::vector<int> order(num_vertices);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), gen);
+
+        vertices_uv.resize(num_vertices, 3);
+        for (int row = 0; row < num_vertices; ++row) {
+            vertices_uv.row(row) = halfedges_uv.row(order[row]);
+        }
+
+        // The parameterization knows the rows of the face corners, which the scan recovers from the coordinates
+        std::vector<int> row_of(num_vertices);
+        for (int row = 0; row < num_vertices; ++row) {
+            row_of[order[row]] = row;
+        }
+        face_vertex_rows.resize(faces_uv.rows(), 3);
+        for (int f = 0; f < faces_uv.rows(); ++f) {
+            for (int c = 0; c < 3; ++c) {
+                face_vertex_rows(f, c) = row_of[faces_uv(f, c)];
+            }
+        }
+    }
+
+    int nearest_face_by_scan(const Eigen::Vector2d& point) {
+        std::pair<double, int> best(std::numeric_limits<double>::infinity(), -1);
+        for (int f = 0; f < faces_uv.rows(); ++f) {
+            Eigen::Vector3d a = halfedges_uv.row(faces_uv(f, 0));
+            Eigen::Vector3d b = halfedges_uv.row(faces_uv(f, 1));
+            Eigen::Vector3d c = halfedges_uv.row(faces_uv(f, 2));
+            best = std::min(best, {pointTriangleDistance(Eigen::Vector3d(point.x(), point.y(), 0), a, b, c), f});
+        }
+        return best.second;
+    }
+};
+
+TEST_F(UVFaceGridTest, FindsTheSameFaceAsTheScanOverAllFaces) {
+    std::uniform_real_distribution<double> uniform(-0.2, 1.2);
+
+    for (int cells_per_side : {0, 1, 3, 50}) {
+        UVFaceGrid grid(halfedges_uv, faces_uv, cells_per_side);
+        for (int i = 0; i < 500; ++i) {
+            Eigen::Vector2d point(uniform(gen), uniform(gen));
+            ASSERT_EQ(grid.nearest_face(point), nearest_face_by_scan(point)) << "cells " << cells_per_side << ", point " << point.transpose();
+        }
+    }
+}
+
+TEST_F(UVFaceGridTest, BreaksTiesOnSharedEdgesByTheSmallestFace) {
+    UVFaceGrid grid(halfedges_uv, faces_uv);
+
+    // The mesh vertices lie on the edges of up to six faces
+    for (int v = 0; v < halfedges_uv.rows(); ++v) {
+        Eigen::Vector2d point = halfedges_uv.row(v).head<2>();
+        EXPECT_EQ(grid.nearest_face(point), nearest_face_by_scan(point)) << "vertex " << v;
+    }
+}
+
+TEST_F(UVFaceGridTest, FaceTableMeshLocatesTheSameFaces) {
+    // Same faces in the same order, only indexing the rows of vertices_uv
+    UVFaceGrid grid(vertices_uv, face_vertex_rows);
+
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (int i = 0; i < 200; ++i) {
+        Eigen::Vector2d point(uniform(gen), uniform(gen));
+        EXPECT_EQ(grid.nearest_face(point), nearest_face_by_scan(point));
+    }
+}
+
+TEST_F(UVFaceGridTest, ChoosesAboutOneCellPerTwoFaces) {
+    UVFaceGrid grid(halfedges_uv, faces_uv);
+    EXPECT_EQ(grid.num_faces(), 2 * n * n);
+    EXPECT_EQ(grid.cells_per_side(), n);
+}
+
+TEST(UVFaceGrid, RejectsAMeshWithoutFaces) {
+    EXPECT_THROW(UVFaceGrid(Eigen::MatrixXd::Zero(3, 3), Eigen::MatrixXi(0, 3)), std::invalid_argument);
+}
@@ -0,0 +1,131 @@
+// author: @Jan-Piotraschke
+// date: 2023-07-27
+// license: Apache License 2.0
+// version: 0.1.0
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+#include <utilities/uv_face_grid.h>
+#include <utilities/uv_face_walk.h>
+
+#include "jittered_uv_square.h"
+
+
+/**
+ * @brief Jittered triangulation of the UV square with n x n quads
+*/
+class UVFaceWalkTest : public ::testing::Test {
+protected:
+    const int n = 10;
+    Eigen::MatrixXd halfedges_uv;
+    Eigen::MatrixXi faces_uv;
+    std::mt19937 gen{3};
+
+    void SetUp() override {
+        jittered_uv_square(n, gen, halfedges_uv, faces_uv);
+    }
+
+    std::set<std::pair<int, int>> neighbor_pairs(const FaceAdjacency& adjacency) {
+        std::set<std::pair<int, int>> pairs;
+        for (int f = 0; f + 1 < static_cast<int>(adjacency.offsets.size()); ++f) {
+            for (int i = adjacency.offsets[f]; i < adjacency.offsets[f + 1]; ++i) {
+                pairs.insert({f, adjacency.neighbors[i]});
+            }
+        }
+        return pairs;
+    }
+};
+
+TEST_F(UVFaceWalkTest, FacesShareEdgesWithTheirNeighbors) {
+    FaceAdjacency adjacency = calculate_face_adjacency(halfedges_uv, faces_uv);
+    auto pairs = neighbor_pairs(adjacency);
+
+    // 3 edges per face, minus the 4 n edges on the border of the square
+    EXPECT_EQ(adjacency.neighbors.size(), 3 * faces_uv.rows() - 4 * n);
+    for (const auto& [f, g] : pairs) {
+        EXPECT_TRUE(pairs.count({g, f}));
+    }
+
+    // The shared edge lies opposite to the given corner, i.e. the neighbor has the other two corners
+    for (int f = 0; f < faces_uv.rows(); ++f) {
+        for (int i = adjacency.offsets[f]; i < adjacency.offsets[f + 1]; ++i) {
+            const int corner = adjacency.opposite_corner[i];
+            const Eigen::Vector3i neighbor = faces_uv.row(adjacency.neighbors[i]);
+            EXPECT_EQ(std::count(neighbor.data(), neighbor.data() + 3, faces_uv(f, (corner + 1) % 3)), 1);
+            EXPECT_EQ(std::count(neighbor.data(), neighbor.data() + 3, faces_uv(f, (corner + 2) % 3)), 1);
+            EXPECT_EQ(std::count(neighbor.data(), neighbor.data() + 3, faces_uv(f, corner)), 0);
+        }
+    }
+}
+
+TEST_F(UVFaceWalkTest, MatchesEdgesByTheirUVCoordinates) {
+    // Every face gets its own copy of its vertices, like a loader without vertex joining
+    Eigen::MatrixXd split_halfedges(3 * faces_uv.rows(), 3);
+    Eigen::MatrixXi split_faces(faces_uv.rows(), 3);
+    for (int f = 0; f < faces_uv.rows(); ++f) {
+        for (int c = 0; c < 3; ++c) {
+            split_halfedges.row(3 * f + c) = halfedges_uv.row(faces_uv(f, c));
+            split_faces(f, c) = 3 * f + c;
+        }
+    }
+
+    EXPECT_EQ(neighbor_pairs(calculate_face_adjacency(split_halfedges, split_faces)), neighbor_pairs(calculate_face_adjacency(halfedges_uv, faces_uv)));
+}
+
+TEST_F(UVFaceWalkTest, WalksToTheFaceOfTheGrid) {
+    FaceAdjacency adjacency = calculate_face_adjacency(halfedges_uv, faces_uv);
+    UVFaceGrid grid(halfedges_uv, faces_uv);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::uniform_int_distribution<int> random_face(0, faces_uv.rows() - 1);
+
+    int found = 0;
+    for (int i = 0; i < 500; ++i) {
+        Eigen::Vector2d point(uniform(gen), uniform(gen));
+        const int face = walk_to_face(point, random_face(gen), adjacency, halfedges_uv, faces_uv, 4 * n);
+        if (face >= 0) {
+            EXPECT_EQ(face, grid.nearest_face(point));
+            ++found;
+        }
+    }
+
+    // The square is convex, so only points on an edge are left to the grid
+    EXPECT_EQ(found, 500);
+}
+
+TEST_F(UVFaceWalkTest, TracksMovingParticlesWithFewSteps) {
+    FaceAdjacency adjacency = calculate_face_adjacency(halfedges_uv, faces_uv);
+    UVFaceGrid grid(halfedges_uv, faces_uv);
+    std::normal_distribution<double> move(0, 0.01);
+
+    Eigen::Vector2d point(0.5, 0.5);
+    int face = grid.nearest_face(point);
+    for (int step = 0; step < 1000; ++step) {
+        point = (point + Eigen::Vector2d(move(gen), move(gen))).cwiseMax(0.01).cwiseMin(0.99);
+
+        // A move of a tenth of a face needs at most a few steps
+        face = walk_to_face(point, face, adjacency, halfedges_uv, faces_uv, 3);
+        ASSERT_GE(face, 0) << "step " << step;
+        ASSERT_EQ(face, grid.nearest_face(point));
+    }
+}
+
+TEST_F(UVFaceWalkTest, FailsOutsideOfTheMesh) {
+    FaceAdjacency adjacency = calculate_face_adjacency(halfedges_uv, faces_uv);
+
+    EXPECT_EQ(walk_to_face(Eigen::Vector2d(1.1, 0.5), 0, adjacency, halfedges_uv, faces_uv), -1);
+    EXPECT_EQ(walk_to_face(Eigen::Vector2d(0.95, 0.95), 0, adjacency, halfedges_uv, faces_uv, 2), -1);
+}
+
+TEST_F(UVFaceWalkTest, LeavesPointsOnAnEdgeToTheGrid) {
+    FaceAdjacency adjacency = calculate_face_adjacency(halfedges_uv, faces_uv);
+
+    // The diagonal of the first quad is shared by its two faces
+    Eigen::Vector2d point = 0.5 * (halfedges_uv.row(0).head<2>() + halfedges_uv.row(n + 2).head<2>()).transpose();
+    EXPECT_EQ(walk_to_face(point, 0, adjacency, halfedges_uv, faces_uv), -1);
+}